@@ -37,11 +37,14 @@ SOURCES += \
     codeformatter.cpp \
     codesnippetsmanager.cpp \
     colorscheme.cpp \
+    compiler/ojproblemcaseprocess.cpp \
     compiler/ojproblemcasesrunner.cpp \
+    compiler/ojproblemstressrunner.cpp \
     compiler/projectcompiler.cpp \
     compiler/runner.cpp \
     gdbmiresultparser.cpp \
     platform.cpp \
+    compiler/compilecache.cpp \
     compiler/compiler.cpp \
     compiler/compilermanager.cpp \
     compiler/executablerunner.cpp \
@@ -62,6 +65,7 @@ SOURCES += \
     qsynedit/SearchBase.cpp \
     qsynedit/SearchRegex.cpp \
     qsynedit/Types.cpp \
+    recoveryjournal.cpp \
     settingsdialog/compilerautolinkwidget.cpp \
     settingsdialog/debuggeneralwidget.cpp \
     settingsdialog/editorautosavewidget.cpp \
@@ -85,10 +89,12 @@ SOURCES += \
     settingsdialog/projectprecompilewidget.cpp \
     settingsdialog/toolsgeneralwidget.cpp \
     shortcutmanager.cpp \
+    startupprofiler.cpp \
     symbolusagemanager.cpp \
     thememanager.cpp \
     todoparser.cpp \
     toolsmanager.cpp \
+    undojournal.cpp \
     widgets/aboutdialog.cpp \
     widgets/bookmarkmodel.cpp \
     widgets/classbrowser.cpp \
@@ -99,6 +105,7 @@ SOURCES += \
     editor.cpp \
     editorlist.cpp \
     iconsmanager.cpp \
+    lazyinitializer.cpp \
     main.cpp \
     mainwindow.cpp \
     qsynedit/CodeFolding.cpp \
@@ -164,11 +171,14 @@ HEADERS += \
     codeformatter.h \
     codesnippetsmanager.h \
     colorscheme.h \
+    compiler/compilecache.h \
     compiler/compiler.h \
     compiler/compilermanager.h \
     compiler/executablerunner.h \
     compiler/filecompiler.h \
+    compiler/ojproblemcaseprocess.h \
     compiler/ojproblemcasesrunner.h \
+    compiler/ojproblemstressrunner.h \
     compiler/projectcompiler.h \
     compiler/runner.h \
     compiler/stdincompiler.h \
@@ -188,6 +198,7 @@ HEADERS += \
     qsynedit/Search.h \
     qsynedit/SearchBase.h \
     qsynedit/SearchRegex.h \
+    recoveryjournal.h \
     settingsdialog/compilerautolinkwidget.h \
     settingsdialog/debuggeneralwidget.h \
     settingsdialog/editorautosavewidget.h \
@@ -211,10 +222,12 @@ HEADERS += \
     settingsdialog/projectprecompilewidget.h \
     settingsdialog/toolsgeneralwidget.h \
     shortcutmanager.h \
+    startupprofiler.h \
     symbolusagemanager.h \
     thememanager.h \
     todoparser.h \
     toolsmanager.h \
+    undojournal.h \
     widgets/aboutdialog.h \
     widgets/bookmarkmodel.h \
     widgets/classbrowser.h \
@@ -225,6 +238,7 @@ HEADERS += \
     editor.h \
     editorlist.h \
     iconsmanager.h \
+    lazyinitializer.h \
     mainwindow.h \
     qsynedit/CodeFolding.h \
     qsynedit/Constants.h \
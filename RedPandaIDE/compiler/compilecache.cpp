@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "compilecache.h"
+#include "../settings.h"
+#include "../systemconsts.h"
+#include "../utils.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+CompileCache* pCompileCache;
+
+CompileCache::CompileCache():
+    mHits(0),
+    mMisses(0),
+    mLoaded(false)
+{
+
+}
+
+QByteArray CompileCache::computeKey(const QString &compiler, const QString &arguments, const QString &sourceFilename)
+{
+    QFile sourceFile(sourceFilename);
+    if (!sourceFile.open(QFile::ReadOnly))
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // identify the compiler binary by its path, size and modification time
+    QFileInfo compilerInfo(compiler);
+    hash.addData(compiler.toUtf8());
+    hash.addData(QByteArray::number(compilerInfo.size()));
+    hash.addData(QByteArray::number(compilerInfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(arguments.toUtf8());
+    hash.addData(sourceFile.readAll());
+    return hash.result().toHex();
+}
+
+QString CompileCache::dependencyFilename(const QByteArray &key)
+{
+    QDir dir(cacheDir());
+    if (!dir.exists())
+        dir.mkpath(dir.absolutePath());
+    return dir.filePath(QString::fromLatin1(key)+"."+DEP_EXT);
+}
+
+bool CompileCache::restore(const QByteArray &key, const QString &outputFilename)
+{
+    QMutexLocker locker(&mMutex);
+    load();
+    PCompileCacheEntry entry = mEntries.value(key);
+    if (!entry || !isUpToDate(entry)) {
+        if (entry)
+            removeEntry(key);
+        mMisses++;
+        save();
+        return false;
+    }
+    QFile::remove(outputFilename);
+    if (!QFile::copy(executableFilename(key), outputFilename)) {
+        removeEntry(key);
+        mMisses++;
+        save();
+        return false;
+    }
+    entry->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    mHits++;
+    save();
+    return true;
+}
+
+void CompileCache::store(const QByteArray &key, const QString &outputFilename)
+{
+    QMutexLocker locker(&mMutex);
+    load();
+    QString depFilename = dependencyFilename(key);
+    QStringList dependencies = parseDependencyFile(depFilename);
+    QFile::remove(depFilename);
+    if (dependencies.isEmpty())
+        return;
+    removeEntry(key);
+    if (!QFile::copy(outputFilename, executableFilename(key)))
+        return;
+    PCompileCacheEntry entry = std::make_shared<CompileCacheEntry>();
+    entry->key = key;
+    entry->size = QFileInfo(outputFilename).size();
+    entry->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    foreach (const QString& filename, dependencies) {
+        QFileInfo info(filename);
+        CompileCacheDependency dependency;
+        dependency.filename = info.absoluteFilePath();
+        dependency.size = info.size();
+        dependency.lastModified = info.lastModified().toMSecsSinceEpoch();
+        entry->dependencies.append(dependency);
+    }
+    mEntries.insert(key,entry);
+    shrink((qint64)pSettings->executor().compileCacheMaxSize()*1024*1024);
+    save();
+}
+
+void CompileCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    QDir(cacheDir()).removeRecursively();
+    mEntries.clear();
+    mHits = 0;
+    mMisses = 0;
+    mLoaded = true;
+}
+
+int CompileCache::hits()
+{
+    QMutexLocker locker(&mMutex);
+    load();
+    return mHits;
+}
+
+int CompileCache::misses()
+{
+    QMutexLocker locker(&mMutex);
+    load();
+    return mMisses;
+}
+
+qint64 CompileCache::totalSize()
+{
+    QMutexLocker locker(&mMutex);
+    load();
+    qint64 size = 0;
+    foreach (const PCompileCacheEntry& entry, mEntries) {
+        size += entry->size;
+    }
+    return size;
+}
+
+void CompileCache::load()
+{
+    if (mLoaded)
+        return;
+    mLoaded = true;
+    QFile file(QDir(cacheDir()).filePath(DEV_COMPILE_CACHE_INDEX_FILE));
+    if (!file.open(QFile::ReadOnly))
+        return;
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    mHits = root["hits"].toInt();
+    mMisses = root["misses"].toInt();
+    foreach (const QJsonValue& value, root["entries"].toArray()) {
+        QJsonObject obj = value.toObject();
+        PCompileCacheEntry entry = std::make_shared<CompileCacheEntry>();
+        entry->key = obj["key"].toString().toLatin1();
+        entry->size = obj["size"].toVariant().toLongLong();
+        entry->lastUsed = obj["lastUsed"].toVariant().toLongLong();
+        foreach (const QJsonValue& depValue, obj["dependencies"].toArray()) {
+            QJsonObject depObj = depValue.toObject();
+            CompileCacheDependency dependency;
+            dependency.filename = depObj["filename"].toString();
+            dependency.size = depObj["size"].toVariant().toLongLong();
+            dependency.lastModified = depObj["lastModified"].toVariant().toLongLong();
+            entry->dependencies.append(dependency);
+        }
+        mEntries.insert(entry->key,entry);
+    }
+}
+
+void CompileCache::save()
+{
+    QJsonArray entries;
+    foreach (const PCompileCacheEntry& entry, mEntries) {
+        QJsonObject obj;
+        obj["key"] = QString::fromLatin1(entry->key);
+        obj["size"] = entry->size;
+        obj["lastUsed"] = entry->lastUsed;
+        QJsonArray dependencies;
+        foreach (const CompileCacheDependency& dependency, entry->dependencies) {
+            QJsonObject depObj;
+            depObj["filename"] = dependency.filename;
+            depObj["size"] = dependency.size;
+            depObj["lastModified"] = dependency.lastModified;
+            dependencies.append(depObj);
+        }
+        obj["dependencies"] = dependencies;
+        entries.append(obj);
+    }
+    QJsonObject root;
+    root["hits"] = mHits;
+    root["misses"] = mMisses;
+    root["entries"] = entries;
+    QDir dir(cacheDir());
+    if (!dir.exists())
+        dir.mkpath(dir.absolutePath());
+    QFile file(dir.filePath(DEV_COMPILE_CACHE_INDEX_FILE));
+    if (file.open(QFile::WriteOnly|QFile::Truncate)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    }
+}
+
+QString CompileCache::cacheDir() const
+{
+    return QDir(pSettings->dirs().config()).filePath(DEV_COMPILE_CACHE_DIR);
+}
+
+QString CompileCache::executableFilename(const QByteArray &key) const
+{
+    return QDir(cacheDir()).filePath(QString::fromLatin1(key)+".bin");
+}
+
+bool CompileCache::isUpToDate(const PCompileCacheEntry &entry) const
+{
+    if (!fileExists(executableFilename(entry->key)))
+        return false;
+    foreach (const CompileCacheDependency& dependency, entry->dependencies) {
+        QFileInfo info(dependency.filename);
+        if (!info.exists()
+                || info.size()!=dependency.size
+                || info.lastModified().toMSecsSinceEpoch()!=dependency.lastModified)
+            return false;
+    }
+    return true;
+}
+
+QStringList CompileCache::parseDependencyFile(const QString &filename) const
+{
+    // the file is generated with "-MT cache", so it is a single rule "cache: dep1 dep2 \ ..."
+    QStringList result;
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly))
+        return result;
+    QString content = QString::fromLocal8Bit(file.readAll());
+    int pos = content.indexOf("cache:");
+    if (pos<0)
+        return result;
+    pos += QString("cache:").length();
+    QString current;
+    while (pos<content.length()) {
+        QChar ch = content[pos];
+        if (ch == '\\' && pos+1<content.length()) {
+            QChar next = content[pos+1];
+            if (next == ' ' || next == '#') {
+                current += next;
+                pos+=2;
+                continue;
+            } else if (next == '\n' || next == '\r') {
+                // line continuation
+                pos++;
+                continue;
+            }
+        } else if (ch == '$' && pos+1<content.length() && content[pos+1]=='$') {
+            current += ch;
+            pos+=2;
+            continue;
+        }
+        if (ch.isSpace()) {
+            if (!current.isEmpty())
+                result.append(current);
+            current.clear();
+        } else {
+            current += ch;
+        }
+        pos++;
+    }
+    if (!current.isEmpty())
+        result.append(current);
+    return result;
+}
+
+void CompileCache::removeEntry(const QByteArray &key)
+{
+    mEntries.remove(key);
+    QFile::remove(executableFilename(key));
+}
+
+void CompileCache::shrink(qint64 maxSize)
+{
+    QList<PCompileCacheEntry> entries = mEntries.values();
+    qint64 size = 0;
+    foreach (const PCompileCacheEntry& entry, entries) {
+        size += entry->size;
+    }
+    if (size <= maxSize)
+        return;
+    // remove the least recently used entries first
+    std::sort(entries.begin(),entries.end(),[](const PCompileCacheEntry& e1, const PCompileCacheEntry& e2){
+        return e1->lastUsed < e2->lastUsed;
+    });
+    foreach (const PCompileCacheEntry& entry, entries) {
+        if (size <= maxSize)
+            break;
+        size -= entry->size;
+        removeEntry(entry->key);
+    }
+}
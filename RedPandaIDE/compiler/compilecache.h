@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <memory>
+
+struct CompileCacheDependency {
+    QString filename;
+    qint64 size;
+    qint64 lastModified;
+};
+
+struct CompileCacheEntry {
+    QByteArray key;
+    qint64 size; // size of the cached executable
+    qint64 lastUsed;
+    QList<CompileCacheDependency> dependencies; // the source and all files it includes
+};
+
+using PCompileCacheEntry = std::shared_ptr<CompileCacheEntry>;
+
+/**
+ * Cache of executables compiled from single files.
+ *
+ * Entries are keyed by the compiler binary, the full argument list and the source text.
+ * The include closure of the source is taken from the dependency file gcc writes (-MD)
+ * while compiling, and an entry is only reused if none of those files changed.
+ */
+class CompileCache
+{
+public:
+    explicit CompileCache();
+    static QByteArray computeKey(const QString& compiler, const QString& arguments, const QString& sourceFilename);
+    QString dependencyFilename(const QByteArray& key);
+    bool restore(const QByteArray& key, const QString& outputFilename);
+    void store(const QByteArray& key, const QString& outputFilename);
+    void clear();
+    int hits();
+    int misses();
+    qint64 totalSize();
+private:
+    void load();
+    void save();
+    QString cacheDir() const;
+    QString executableFilename(const QByteArray& key) const;
+    bool isUpToDate(const PCompileCacheEntry& entry) const;
+    QStringList parseDependencyFile(const QString& filename) const;
+    void removeEntry(const QByteArray& key);
+    void shrink(qint64 maxSize);
+private:
+    QHash<QByteArray,PCompileCacheEntry> mEntries;
+    int mHits;
+    int mMisses;
+    bool mLoaded;
+    QMutex mMutex;
+};
+
+extern CompileCache* pCompileCache;
+
+#endif // COMPILECACHE_H
@@ -17,6 +17,7 @@
 #include "compiler.h"
 #include "utils.h"
 #include "compilermanager.h"
+#include "compilecache.h"
 #include "../systemconsts.h"
 
 #include <QFileInfo>
@@ -25,6 +26,11 @@
 #include <QTextCodec>
 #include <QTime>
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QReadWriteLock>
+#include <QRegularExpression>
 #include "../editor.h"
 #include "../mainwindow.h"
 #include "../editorlist.h"
@@ -34,13 +40,57 @@
 #include "../project.h"
 
 #define COMPILE_PROCESS_END "---//END//----"
+// number of flag combinations we keep precompiled headers for
+#define PRECOMPILED_HEADERS_MAX_SETS 4
+
+// heavy headers that are worth precompiling when they are the first include of a file
+static const QStringList PrecompilableHeaders {
+    "bits/stdc++.h"
+};
+
+// compilers building or evicting precompiled headers lock it for write,
+// compilers using them hold it for read until they finish
+static QReadWriteLock PrecompiledHeadersLock;
+
+static QString findFirstInclude(const QString& sourceText)
+{
+    static QRegularExpression includeRegex("^\\s*#\\s*include\\s*<([^>]+)>");
+    bool inComment = false;
+    foreach (QString line, textToLines(sourceText)) {
+        if (inComment) {
+            int pos = line.indexOf("*/");
+            if (pos<0)
+                continue;
+            line.remove(0,pos+2);
+            inComment = false;
+        }
+        int pos = line.indexOf("/*");
+        if (pos>=0 && line.indexOf("*/",pos+2)<0) {
+            line.truncate(pos);
+            inComment = true;
+        }
+        line.remove(QRegularExpression("/\\*.*?\\*/"));
+        pos = line.indexOf("//");
+        if (pos>=0)
+            line.truncate(pos);
+        if (line.trimmed().isEmpty())
+            continue;
+        QRegularExpressionMatch match = includeRegex.match(line);
+        if (match.hasMatch())
+            return match.captured(1).trimmed();
+        return QString();
+    }
+    return QString();
+}
 
 Compiler::Compiler(const QString &filename, bool silent, bool onlyCheckSyntax):
     QThread(),
     mSilent(silent),
     mOnlyCheckSyntax(onlyCheckSyntax),
     mFilename(filename),
-    mRebuild(false)
+    mRebuild(false),
+    mStop(false),
+    mPrecompiledHeadersLocked(false)
 {
 
 }
@@ -49,6 +99,9 @@ void Compiler::run()
 {
     emit compileStarted();
     auto action = finally([this]{
+        releasePrecompiledHeaders();
+        if (!mObjectFile.isEmpty())
+            QFile::remove(mObjectFile);
         emit compileFinished();
     });
     try {
@@ -62,10 +115,28 @@ void Compiler::run()
         mWarningCount = 0;
         QElapsedTimer timer;
         timer.start();
-        runCommand(mCompiler, mArguments, mDirectory, pipedText());
+        bool cacheHit = false;
+        if (!mCacheKey.isEmpty() && !mRebuild)
+            cacheHit = pCompileCache->restore(mCacheKey, mOutputFile);
+        if (!cacheHit) {
+            QDateTime startTime = QDateTime::currentDateTime();
+            int exitCode = runCommand(mCompiler, mArguments, mDirectory, pipedText());
+            if (!mLinkArguments.isEmpty()) {
+                // the linker doesn't read the precompiled header, let it be evicted
+                releasePrecompiledHeaders();
+                if (exitCode == 0 && !mStop)
+                    exitCode = runCommand(mCompiler, mLinkArguments, mDirectory);
+            }
+            // only cache what this run has completely written
+            if (!mCacheKey.isEmpty() && exitCode == 0 && !mStop && mErrorCount == 0
+                    && isOutputFileWrittenSince(startTime))
+                pCompileCache->store(mCacheKey, mOutputFile);
+        }
         log("");
         log(tr("Compile Result:"));
         log("------------------");
+        if (cacheHit)
+            log(tr("- Sources unchanged, reused the cached executable."));
         log(tr("- Errors: %1").arg(mErrorCount));
         log(tr("- Warnings: %1").arg(mWarningCount));
         if (!mOutputFile.isEmpty()) {
@@ -74,6 +145,8 @@ void Compiler::run()
             log(tr("- Output Size: %1").arg(locale.formattedDataSize(QFileInfo(mOutputFile).size())));
         }
         log(tr("- Compilation Time: %1 secs").arg(timer.elapsed() / 1000.0));
+        if (!mCacheKey.isEmpty())
+            log(tr("- Compile Cache: %1 hits, %2 misses").arg(pCompileCache->hits()).arg(pCompileCache->misses()));
     } catch (CompileError e) {
         emit compileErrorOccured(e.reason());
     }
@@ -196,6 +269,11 @@ void Compiler::processOutput(QString &line)
     issue->type = CompileIssueType::Other;
     issue->endColumn = -1;
     if (line.startsWith(inFilePrefix)) {
+        // a new diagnostic begins (possibly from another job of a parallel build)
+        if (mLastIssue) {
+            emit compileIssue(mLastIssue);
+            mLastIssue.reset();
+        }
         line.remove(0,inFilePrefix.length());
         issue->filename = getFileNameFromOutputLine(line);
         issue->line = getLineNumberFromOutputLine(line);
@@ -528,6 +606,102 @@ QString Compiler::getLibraryArguments(FileType fileType)
     return result;
 }
 
+QString Compiler::getPrecompiledHeaderArguments(const QString &sourceText, const QString &arguments)
+{
+    QString header = findFirstInclude(sourceText);
+    if (header.isEmpty() || !PrecompilableHeaders.contains(header))
+        return QString();
+    // A precompiled header is only valid for the compiler and flags it's built with
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QFileInfo compilerInfo(mCompiler);
+    hash.addData(mCompiler.toUtf8());
+    hash.addData(QByteArray::number(compilerInfo.size()));
+    hash.addData(QByteArray::number(compilerInfo.lastModified().toMSecsSinceEpoch()));
+    // syntax checks can use the header built for compiles
+    QStringList argumentList = splitProcessCommand(arguments);
+    argumentList.removeAll("-fsyntax-only");
+    hash.addData(argumentList.join(' ').toUtf8());
+    hash.addData(header.toUtf8());
+    QString pchRootDir = QDir(pSettings->dirs().config()).filePath(DEV_PRECOMPILED_HEADERS_DIR);
+    QString pchDir = QDir(pchRootDir).filePath(QString::fromLatin1(hash.result().toHex()));
+    QString gchFilename = QDir(pchDir).filePath(header+"."+GCH_EXT);
+    if (mPrecompiledHeadersLocked)
+        return QString();
+    PrecompiledHeadersLock.lockForWrite();
+    if (!fileExists(gchFilename)) {
+        log(tr("Precompiling header <%1>...").arg(header));
+        QDir(pchDir).mkpath(extractFileDir(gchFilename));
+        // build it under another name, so a half written header is never used
+        QString tempFilename = gchFilename+".tmp";
+        if (!buildPrecompiledHeader(header, arguments, tempFilename)
+                || !QFile::rename(tempFilename, gchFilename)) {
+            log(tr("Failed to precompile header <%1>, compile without it.").arg(header));
+            QDir(pchDir).removeRecursively();
+            PrecompiledHeadersLock.unlock();
+            return QString();
+        }
+        removeUnusedPrecompiledHeaders(pchRootDir);
+    }
+    // recreate the stamp file, so the dir's modification time tells when it's last used
+    QFile stamp(QDir(pchDir).filePath("lastused"));
+    stamp.remove();
+    if (stamp.open(QFile::WriteOnly))
+        stamp.close();
+    // keep it from being evicted until the compiler has read it
+    PrecompiledHeadersLock.unlock();
+    PrecompiledHeadersLock.lockForRead();
+    mPrecompiledHeadersLocked = true;
+    if (!fileExists(gchFilename))
+        return QString();
+    // gcc looks for <header>.gch in each include dir before <header> itself
+    return QString(" -I\"%1\"").arg(pchDir);
+}
+
+bool Compiler::buildPrecompiledHeader(const QString &header, const QString &arguments, const QString &gchFilename)
+{
+    QProcess process;
+    process.setProgram(mCompiler);
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QString cmdDir = extractFileDir(mCompiler);
+    if (!cmdDir.isEmpty()) {
+        QString path = env.value("PATH");
+        env.insert("PATH",path.isEmpty()?cmdDir:cmdDir + PATH_SEPARATOR + path);
+    }
+    process.setProcessEnvironment(env);
+    QStringList args{"-x","c++-header","-","-o",gchFilename};
+    args.append(splitProcessCommand(arguments));
+    // gcc can use the header in syntax checks, but won't generate it with -fsyntax-only
+    args.removeAll("-fsyntax-only");
+    process.setArguments(args);
+    process.start();
+    if (!process.waitForStarted(5000))
+        return false;
+    process.write(QString("#include <%1>\n").arg(header).toLocal8Bit());
+    process.closeWriteChannel();
+    while (!process.waitForFinished(1000)) {
+        if (process.state()!=QProcess::Running)
+            break;
+        if (mStop) {
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+    }
+    return process.exitStatus() == QProcess::NormalExit
+            && process.exitCode() == 0
+            && fileExists(gchFilename);
+}
+
+void Compiler::removeUnusedPrecompiledHeaders(const QString &pchRootDir)
+{
+    // precompiled headers are big, only keep the most recently built ones
+    QDir dir(pchRootDir);
+    QFileInfoList dirs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
+    for (int i=PRECOMPILED_HEADERS_MAX_SETS;i<dirs.count();i++) {
+        QDir(dirs[i].absoluteFilePath()).removeRecursively();
+    }
+}
+
 QString Compiler::parseFileIncludesForAutolink(
         const QString &filename,
         QSet<QString>& parsedFiles,
@@ -551,10 +725,28 @@ QString Compiler::parseFileIncludesForAutolink(
     return result;
 }
 
-void Compiler::runCommand(const QString &cmd, const QString  &arguments, const QString &workingDir, const QString& inputText)
+void Compiler::releasePrecompiledHeaders()
+{
+    if (mPrecompiledHeadersLocked) {
+        PrecompiledHeadersLock.unlock();
+        mPrecompiledHeadersLocked = false;
+    }
+}
+
+bool Compiler::isOutputFileWrittenSince(const QDateTime &time)
+{
+    QFileInfo info(mOutputFile);
+    if (!info.exists())
+        return false;
+    // some file systems only store the modification time in seconds
+    return info.lastModified().toMSecsSinceEpoch() / 1000 >= time.toMSecsSinceEpoch() / 1000;
+}
+
+int Compiler::runCommand(const QString &cmd, const QString  &arguments, const QString &workingDir, const QString& inputText)
 {
     QProcess process;
     mStop = false;
+    mErrorBuffer.clear();
     bool errorOccurred = false;
     process.setProgram(cmd);
     QString cmdDir = extractFileDir(cmd);
@@ -627,6 +819,9 @@ void Compiler::runCommand(const QString &cmd, const QString  &arguments, const Q
             throw CompileError(tr("An unknown error occurred."));
         }
     }
+    if (process.exitStatus() != QProcess::NormalExit)
+        return -1;
+    return process.exitCode();
 }
 
 const std::shared_ptr<Project> &Compiler::project() const
@@ -656,9 +851,19 @@ void Compiler::log(const QString &msg)
 
 void Compiler::error(const QString &msg)
 {
-    if (msg != COMPILE_PROCESS_END)
+    QString text;
+    if (msg != COMPILE_PROCESS_END) {
         emit compileOutput(msg);
-    for (QString& s:msg.split("\n")) {
+        // output of parallel jobs may be delivered in chunks that don't end at line breaks
+        text = mErrorBuffer + msg;
+        int pos = text.lastIndexOf('\n');
+        mErrorBuffer = text.mid(pos+1);
+        text.truncate(pos+1);
+    } else {
+        text = mErrorBuffer + "\n" + COMPILE_PROCESS_END;
+        mErrorBuffer.clear();
+    }
+    for (QString& s:text.split("\n")) {
         if (!s.isEmpty())
             processOutput(s);
     }
@@ -17,6 +17,7 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
+#include <QDateTime>
 #include <QThread>
 #include "settings.h"
 #include "../common.h"
@@ -71,13 +72,16 @@ protected:
     virtual QString getProjectIncludeArguments();
     virtual QString getCppIncludeArguments();
     virtual QString getLibraryArguments(FileType fileType);
+    virtual QString getPrecompiledHeaderArguments(const QString& sourceText, const QString& arguments);
     virtual QString parseFileIncludesForAutolink(
             const QString& filename,
             QSet<QString>& parsedFiles,
             PCppParser& parser);
     void log(const QString& msg);
     void error(const QString& msg);
-    void runCommand(const QString& cmd, const QString& arguments, const QString& workingDir, const QString& inputText=QString());
+    // returns the exit code of the command, or -1 if it crashed or was killed
+    int runCommand(const QString& cmd, const QString& arguments, const QString& workingDir, const QString& inputText=QString());
+    bool isOutputFileWrittenSince(const QDateTime& time);
 
 protected:
     bool mSilent;
@@ -92,9 +96,19 @@ protected:
     QString mDirectory;
     bool mRebuild;
     std::shared_ptr<Project> mProject;
+    QByteArray mCacheKey; // key in the compile cache, empty if the result shouldn't be cached
+    // if not empty, mArguments only compiles mObjectFile, which is then linked with these
+    QString mLinkArguments;
+    QString mObjectFile; // removed when the compile finishes
 
+private:
+    bool buildPrecompiledHeader(const QString& header, const QString& arguments, const QString& gchFilename);
+    void removeUnusedPrecompiledHeaders(const QString& pchRootDir);
+    void releasePrecompiledHeaders();
 private:
     bool mStop;
+    QString mErrorBuffer; // incomplete last line of the error output
+    bool mPrecompiledHeadersLocked; // holds the precompiled headers lock for read
 };
 
 
@@ -20,6 +20,7 @@
 #include "../mainwindow.h"
 #include "executablerunner.h"
 #include "ojproblemcasesrunner.h"
+#include "ojproblemstressrunner.h"
 #include "utils.h"
 #include "../settings.h"
 #include <QMessageBox>
@@ -182,7 +183,7 @@ void CompilerManager::buildProjectMakefile(std::shared_ptr<Project> project)
             return;
         }
         ProjectCompiler compiler(project,false,false);
-        compiler.buildMakeFile();
+        compiler.buildMakeFile(true);
     }
 
 }
@@ -294,7 +295,8 @@ void CompilerManager::run(const QString &filename, const QString &arguments, con
     mRunner->start();
 }
 
-void CompilerManager::runProblem(const QString &filename, const QString &arguments, const QString &workDir, POJProblemCase problemCase)
+void CompilerManager::runProblem(const QString &filename, const QString &arguments, const QString &workDir, POJProblemCase problemCase,
+                                 int timeLimit, int memoryLimit)
 {
     QMutexLocker locker(&mRunnerMutex);
     if (mRunner!=nullptr) {
@@ -302,6 +304,8 @@ void CompilerManager::runProblem(const QString &filename, const QString &argumen
     }
 
     OJProblemCasesRunner * execRunner = new OJProblemCasesRunner(filename,arguments,workDir,problemCase);
+    execRunner->setTimeLimit(timeLimit);
+    execRunner->setMemoryLimit(memoryLimit);
     mRunner = execRunner;
     connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
     connect(mRunner, &Runner::finished, mRunner ,&Runner::deleteLater);
@@ -312,13 +316,16 @@ void CompilerManager::runProblem(const QString &filename, const QString &argumen
     mRunner->start();
 }
 
-void CompilerManager::runProblem(const QString &filename, const QString &arguments, const QString &workDir, QVector<POJProblemCase> problemCases)
+void CompilerManager::runProblem(const QString &filename, const QString &arguments, const QString &workDir, QVector<POJProblemCase> problemCases,
+                                 int timeLimit, int memoryLimit)
 {
     QMutexLocker locker(&mRunnerMutex);
     if (mRunner!=nullptr) {
         return;
     }
     OJProblemCasesRunner * execRunner = new OJProblemCasesRunner(filename,arguments,workDir,problemCases);
+    execRunner->setTimeLimit(timeLimit);
+    execRunner->setMemoryLimit(memoryLimit);
     mRunner = execRunner;
     connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
     connect(mRunner, &Runner::finished, pMainWindow ,&MainWindow::onRunProblemFinished);
@@ -329,6 +336,32 @@ void CompilerManager::runProblem(const QString &filename, const QString &argumen
     mRunner->start();
 }
 
+void CompilerManager::runProblemStressTest(const QString &filename, const QString &arguments, const QString &workDir,
+                                           const QString &generatorFilename, const QString &bruteForceFilename,
+                                           int timeLimit, int memoryLimit)
+{
+    QMutexLocker locker(&mRunnerMutex);
+    if (mRunner!=nullptr) {
+        return;
+    }
+    OJProblemStressRunner * execRunner = new OJProblemStressRunner(filename,arguments,workDir,
+                                                                   generatorFilename,bruteForceFilename);
+    execRunner->setTimeLimit(timeLimit);
+    execRunner->setMemoryLimit(memoryLimit);
+    execRunner->setIgnoreSpaces(pSettings->executor().ignoreSpacesWhenValidatingCases());
+    if (pSettings->executor().enableFloatToleranceWhenValidatingCases())
+        execRunner->setFloatTolerance(pSettings->executor().floatToleranceWhenValidatingCases());
+    execRunner->setCaseDir(workDir);
+    mRunner = execRunner;
+    connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
+    connect(mRunner, &Runner::finished, mRunner ,&Runner::deleteLater);
+    connect(mRunner, &Runner::finished, pMainWindow ,&MainWindow::onRunProblemFinished);
+    connect(mRunner, &Runner::runErrorOccurred, pMainWindow ,&MainWindow::onRunErrorOccured);
+    connect(execRunner, &OJProblemStressRunner::iterationsUpdated, pMainWindow, &MainWindow::onOJProblemStressIterationsUpdated);
+    connect(execRunner, &OJProblemStressRunner::failingCaseFound, pMainWindow, &MainWindow::onOJProblemStressCaseFound);
+    mRunner->start();
+}
+
 void CompilerManager::stopRun()
 {
     QMutexLocker locker(&mRunnerMutex);
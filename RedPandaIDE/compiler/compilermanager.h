@@ -43,8 +43,13 @@ public:
     void buildProjectMakefile(std::shared_ptr<Project> project);
     void checkSyntax(const QString&filename, const QString& content, bool isAscii, std::shared_ptr<Project> project);
     void run(const QString& filename, const QString& arguments, const QString& workDir);
-    void runProblem(const QString& filename, const QString& arguments, const QString& workDir, POJProblemCase problemCase);
-    void runProblem(const QString& filename, const QString& arguments, const QString& workDir, QVector<POJProblemCase> problemCases);
+    void runProblem(const QString& filename, const QString& arguments, const QString& workDir, POJProblemCase problemCase,
+                    int timeLimit = 0, int memoryLimit = 0);
+    void runProblem(const QString& filename, const QString& arguments, const QString& workDir, QVector<POJProblemCase> problemCases,
+                    int timeLimit = 0, int memoryLimit = 0);
+    void runProblemStressTest(const QString& filename, const QString& arguments, const QString& workDir,
+                              const QString& generatorFilename, const QString& bruteForceFilename,
+                              int timeLimit = 0, int memoryLimit = 0);
     void stopRun();
     void stopAllRunners();
     void stopPausing();
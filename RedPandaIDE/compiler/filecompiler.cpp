@@ -18,10 +18,14 @@
 #include "utils.h"
 #include "../mainwindow.h"
 #include "compilermanager.h"
+#include "compilecache.h"
+#include "../systemconsts.h"
 
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QTemporaryFile>
 
 
 FileCompiler::FileCompiler(const QString &filename, const QByteArray &encoding,bool silent,bool onlyCheckSyntax):
@@ -40,9 +44,10 @@ bool FileCompiler::prepareForCompile()
     log("");
     FileType fileType = getFileType(mFilename);
     mArguments= QString(" \"%1\"").arg(mFilename);
+    mLinkArguments.clear();
+    mObjectFile.clear();
     if (!mOnlyCheckSyntax) {
         mOutputFile = getCompiledExecutableName(mFilename);
-        mArguments+=QString(" -o \"%1\"").arg(mOutputFile);
 
         //remove the old file if it exists
         QFile outputFile(mOutputFile);
@@ -54,38 +59,80 @@ bool FileCompiler::prepareForCompile()
         }
     }
 
-    mArguments += getCharsetArgument(mEncoding);
+    QString charsetArgument = getCharsetArgument(mEncoding);
+    mArguments += charsetArgument;
     QString strFileType;
+    QString compileArguments;
+    bool usePrecompiledHeader = false;
     switch(fileType) {
     case FileType::CSource:
-        mArguments += getCCompileArguments(mOnlyCheckSyntax);
+        compileArguments = getCCompileArguments(mOnlyCheckSyntax);
+        mArguments += compileArguments;
         mArguments += getCIncludeArguments();
         mArguments += getProjectIncludeArguments();
         strFileType = "C";
         mCompiler = compilerSet()->CCompiler();
         break;
-    case FileType::CppSource:
-        mArguments += getCppCompileArguments(mOnlyCheckSyntax);
-        mArguments += getCppIncludeArguments();
-        mArguments += getProjectIncludeArguments();
-        strFileType = "C++";
+    case FileType::CppSource: {
         mCompiler = compilerSet()->cppCompiler();
+        compileArguments = getCppCompileArguments(mOnlyCheckSyntax);
+        QString includeArguments = getCppIncludeArguments() + getProjectIncludeArguments();
+        mArguments += compileArguments;
+        if (pSettings->executor().autoPrecompileHeaders()) {
+            QString pchArguments = getPrecompiledHeaderArguments(
+                        QString::fromLocal8Bit(readFileToByteArray(mFilename)),
+                        charsetArgument + compileArguments + includeArguments);
+            mArguments += pchArguments;
+            usePrecompiledHeader = !pchArguments.isEmpty();
+        }
+        mArguments += includeArguments;
+        strFileType = "C++";
         break;
+    }
     default:
         throw CompileError(tr("Can't find the compiler for file %1").arg(mFilename));
     }
 
-    if (!mOnlyCheckSyntax)
-        mArguments += getLibraryArguments(fileType);
+    if (!mOnlyCheckSyntax) {
+        QString libraryArguments = getLibraryArguments(fileType);
+        QTemporaryFile objectFile(QDir(QDir::tempPath()).filePath("redpanda-compile-XXXXXX." OBJ_EXT));
+        objectFile.setAutoRemove(false);
+        if (usePrecompiledHeader && objectFile.open()) {
+            // compile and link in two steps, so the precompiled header is
+            // only locked while the compiler reads it
+            mObjectFile = objectFile.fileName();
+            objectFile.close();
+            mArguments += QString(" -c -o \"%1\"").arg(mObjectFile);
+            mLinkArguments = QString(" \"%1\" -o \"%2\"").arg(mObjectFile, mOutputFile)
+                    + charsetArgument + compileArguments + libraryArguments;
+        } else {
+            mArguments += QString(" -o \"%1\"").arg(mOutputFile);
+            mArguments += libraryArguments;
+        }
+    }
 
     if (!fileExists(mCompiler)) {
         throw CompileError(tr("The Compiler '%1' doesn't exists!").arg(mCompiler));
     }
 
+    if (!mOnlyCheckSyntax && pSettings->executor().enableCompileCache()) {
+        QString keyArguments = mArguments + mLinkArguments;
+        // the object file's name is random
+        if (!mObjectFile.isEmpty())
+            keyArguments.replace(mObjectFile, "<object>");
+        mCacheKey = CompileCache::computeKey(mCompiler, keyArguments, mFilename);
+        if (!mCacheKey.isEmpty()) {
+            // let gcc tell us which files are included, to validate the cached result later
+            mArguments += QString(" -MD -MT cache -MF \"%1\"").arg(pCompileCache->dependencyFilename(mCacheKey));
+        }
+    }
+
     log(tr("Processing %1 source file:").arg(strFileType));
     log("------------------");
     log(tr("%1 Compiler: %2").arg(strFileType).arg(mCompiler));
     log(tr("Command: %1 %2").arg(extractFileName(mCompiler)).arg(mArguments));
+    if (!mLinkArguments.isEmpty())
+        log(tr("Command: %1 %2").arg(extractFileName(mCompiler)).arg(mLinkArguments));
     mDirectory = extractFileDir(mFilename);
     return true;
 }
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ojproblemcaseprocess.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <tlhelp32.h>
+#endif
+
+// the hard limits are looser than the problem's limits, so a program that exceeds
+// them is still measured and reported as TLE/MLE instead of just being killed early
+static qint64 hardMemoryLimit(int memoryLimit)
+{
+    return ((qint64)memoryLimit*2+64)*1024*1024;
+}
+
+static qint64 hardTimeLimit(int timeLimit)
+{
+    return (qint64)timeLimit*2+1000;
+}
+
+#ifdef Q_OS_WIN
+static void resumeProcess(DWORD processId)
+{
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE)
+        return;
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    if (Thread32First(snapshot, &entry)) {
+        do {
+            if (entry.th32OwnerProcessID != processId)
+                continue;
+            HANDLE thread = OpenThread(THREAD_SUSPEND_RESUME, FALSE, entry.th32ThreadID);
+            if (thread) {
+                ResumeThread(thread);
+                CloseHandle(thread);
+            }
+        } while (Thread32Next(snapshot, &entry));
+    }
+    CloseHandle(snapshot);
+}
+#endif
+
+OJProblemCaseProcess::OJProblemCaseProcess(int timeLimit, int memoryLimit, QObject *parent):
+    QProcess(parent),
+    mTimeLimit(timeLimit),
+    mMemoryLimit(memoryLimit),
+    mCpuTime(0),
+    mPeakMemory(0)
+{
+#ifdef Q_OS_LINUX
+    if (pipe2(mUsagePipe, O_CLOEXEC)!=0) {
+        mUsagePipe[0] = -1;
+        mUsagePipe[1] = -1;
+    } else {
+        // the usage is written before the waiting process exits, never wait for it
+        fcntl(mUsagePipe[0], F_SETFL, fcntl(mUsagePipe[0], F_GETFL) | O_NONBLOCK);
+    }
+#if QT_VERSION_MAJOR >= 6
+    setChildProcessModifier([this](){
+        setupChild();
+    });
+#endif
+#elif defined(Q_OS_WIN)
+    mJob = CreateJobObject(nullptr, nullptr);
+    if (mJob) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION info;
+        ZeroMemory(&info, sizeof(info));
+        info.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        if (mMemoryLimit>0) {
+            info.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+            info.ProcessMemoryLimit = hardMemoryLimit(mMemoryLimit);
+        }
+        if (mTimeLimit>0) {
+            info.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_TIME;
+            // in 100-nanosecond ticks
+            info.BasicLimitInformation.PerProcessUserTimeLimit.QuadPart = hardTimeLimit(mTimeLimit)*10000;
+        }
+        SetInformationJobObject(mJob, JobObjectExtendedLimitInformation, &info, sizeof(info));
+        // start it suspended, so it can't run or spawn children outside the job
+        setCreateProcessArgumentsModifier([](QProcess::CreateProcessArguments * args){
+            args->flags |= CREATE_SUSPENDED;
+        });
+    }
+#endif
+}
+
+OJProblemCaseProcess::~OJProblemCaseProcess()
+{
+#ifdef Q_OS_LINUX
+    if (mUsagePipe[0]>=0)
+        ::close(mUsagePipe[0]);
+    if (mUsagePipe[1]>=0)
+        ::close(mUsagePipe[1]);
+#elif defined(Q_OS_WIN)
+    if (mJob)
+        CloseHandle(mJob);
+#endif
+}
+
+void OJProblemCaseProcess::startCase()
+{
+    start();
+#ifdef Q_OS_LINUX
+    // only the forked child should keep the write end
+    if (mUsagePipe[1]>=0) {
+        ::close(mUsagePipe[1]);
+        mUsagePipe[1] = -1;
+    }
+#elif defined(Q_OS_WIN)
+    if (mJob && state()!=QProcess::NotRunning) {
+        HANDLE handle = OpenProcess(PROCESS_SET_QUOTA | PROCESS_TERMINATE, FALSE, processId());
+        if (handle) {
+            AssignProcessToJobObject(mJob, handle);
+            CloseHandle(handle);
+        }
+        resumeProcess(processId());
+    }
+#endif
+}
+
+void OJProblemCaseProcess::collectUsage()
+{
+#ifdef Q_OS_LINUX
+    if (mUsagePipe[0]<0)
+        return;
+    struct rusage usage;
+    ssize_t size;
+    do {
+        size = ::read(mUsagePipe[0], &usage, sizeof(usage));
+    } while (size<0 && errno == EINTR);
+    if (size == sizeof(usage)) {
+        mCpuTime = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)*1000
+                + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000;
+        mPeakMemory = usage.ru_maxrss;
+    }
+#elif defined(Q_OS_WIN)
+    if (!mJob)
+        return;
+    JOBOBJECT_BASIC_ACCOUNTING_INFORMATION accounting;
+    if (QueryInformationJobObject(mJob, JobObjectBasicAccountingInformation, &accounting, sizeof(accounting), nullptr)) {
+        mCpuTime = (accounting.TotalUserTime.QuadPart + accounting.TotalKernelTime.QuadPart) / 10000;
+    }
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION info;
+    if (QueryInformationJobObject(mJob, JobObjectExtendedLimitInformation, &info, sizeof(info), nullptr)) {
+        mPeakMemory = info.PeakProcessMemoryUsed / 1024;
+    }
+#endif
+}
+
+qint64 OJProblemCaseProcess::cpuTime() const
+{
+    return mCpuTime;
+}
+
+qint64 OJProblemCaseProcess::peakMemory() const
+{
+    return mPeakMemory;
+}
+
+#if defined(Q_OS_LINUX) && QT_VERSION_MAJOR < 6
+void OJProblemCaseProcess::setupChildProcess()
+{
+    setupChild();
+}
+#endif
+
+void OJProblemCaseProcess::setupChild()
+{
+#ifdef Q_OS_LINUX
+    // We are in the forked child, only async-signal-safe calls are allowed here.
+    if (mUsagePipe[1]<0)
+        return;
+    pid_t pid = fork();
+    if (pid<0) // run the program without accounting
+        return;
+    if (pid == 0) {
+        // the program, which is killed when the waiting process is killed
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        struct rlimit limit;
+        if (mMemoryLimit>0) {
+            limit.rlim_cur = limit.rlim_max = hardMemoryLimit(mMemoryLimit);
+            setrlimit(RLIMIT_AS, &limit);
+        }
+        if (mTimeLimit>0) {
+            limit.rlim_cur = (hardTimeLimit(mTimeLimit)+999)/1000;
+            limit.rlim_max = limit.rlim_cur+1;
+            setrlimit(RLIMIT_CPU, &limit);
+        }
+        return;
+    }
+    // The waiting process. Close the fds it inherited (QProcess uses one of them
+    // to detect the exec of the program), except the usage pipe and std channels.
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 3, mUsagePipe[1]-1, 0)!=0
+            || syscall(SYS_close_range, mUsagePipe[1]+1, ~0U, 0)!=0)
+#endif
+    {
+        int maxFd = sysconf(_SC_OPEN_MAX);
+        for (int fd=3; fd<maxFd; fd++) {
+            if (fd!=mUsagePipe[1])
+                ::close(fd);
+        }
+    }
+    int status = 0;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage)<0) {
+        if (errno != EINTR)
+            _exit(127);
+    }
+    ssize_t written = ::write(mUsagePipe[1], &usage, sizeof(usage));
+    (void)written;
+    if (WIFSIGNALED(status)) {
+        signal(WTERMSIG(status), SIG_DFL);
+        kill(getpid(), WTERMSIG(status));
+    }
+    _exit(WIFEXITED(status)?WEXITSTATUS(status):127);
+#endif
+}
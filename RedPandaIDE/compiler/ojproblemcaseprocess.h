@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OJPROBLEMCASEPROCESS_H
+#define OJPROBLEMCASEPROCESS_H
+
+#include <QProcess>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+/**
+ * Process running the answer program on a problem case.
+ *
+ * Applies the problem's time/memory limits to the program, and measures its
+ * cpu time and peak memory usage.
+ * On Linux the forked child forks once more and waits for the program with wait4(),
+ * so limits are set with setrlimit() and the usage reported is exactly the program's.
+ * On Windows the program is started suspended and put into a job object before it
+ * runs, the job enforces the limits and keeps the accounting after the program exits.
+ */
+class OJProblemCaseProcess : public QProcess
+{
+public:
+    explicit OJProblemCaseProcess(int timeLimit, int memoryLimit, QObject* parent = nullptr);
+    ~OJProblemCaseProcess();
+    void startCase();
+    // call it after the process is finished, it doesn't block
+    void collectUsage();
+    qint64 cpuTime() const;
+    qint64 peakMemory() const;
+#if defined(Q_OS_LINUX) && QT_VERSION_MAJOR < 6
+protected:
+    void setupChildProcess() override;
+#endif
+private:
+    void setupChild();
+private:
+    int mTimeLimit; // in ms
+    int mMemoryLimit; // in MB
+    qint64 mCpuTime; // in ms
+    qint64 mPeakMemory; // in KB
+#ifdef Q_OS_LINUX
+    int mUsagePipe[2];
+#elif defined(Q_OS_WIN)
+    HANDLE mJob;
+#endif
+};
+
+#endif // OJPROBLEMCASEPROCESS_H
@@ -15,11 +15,20 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "ojproblemcasesrunner.h"
+#include "ojproblemcaseprocess.h"
 #include "../utils.h"
 #include "../settings.h"
 #include "../systemconsts.h"
 #include "../widgets/ojproblemsetmodel.h"
-#include <QProcess>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <functional>
 
 
 OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QString& arguments, const QString& workDir,
@@ -29,6 +38,9 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
     mProblemCases = problemCases;
     mBufferSize = 8192;
     mOutputRefreshTime = 1000;
+    mMaxParallelCases = QThread::idealThreadCount();
+    mTimeLimit = 0;
+    mMemoryLimit = 0;
     setWaitForFinishTime(100);
 }
 
@@ -39,21 +51,19 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
     mProblemCases.append(problemCase);
     mBufferSize = 8192;
     mOutputRefreshTime = 1000;
+    mMaxParallelCases = QThread::idealThreadCount();
+    mTimeLimit = 0;
+    mMemoryLimit = 0;
     setWaitForFinishTime(100);
 }
 
-void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
+OJProblemCaseProcess *OJProblemCasesRunner::createCaseProcess(const QString &program, const QStringList &arguments,
+                                                              int timeLimit, int memoryLimit)
 {
-    emit caseStarted(problemCase->getId(),index, mProblemCases.count());
-    auto action = finally([this,&index, &problemCase]{
-        emit caseFinished(problemCase->getId(), index, mProblemCases.count());
-    });
-    QProcess process;
-    bool errorOccurred = false;
-
-    process.setProgram(mFilename);
-    process.setArguments(splitProcessCommand(mArguments));
-    process.setWorkingDirectory(mWorkDir);
+    OJProblemCaseProcess* process = new OJProblemCaseProcess(timeLimit, memoryLimit);
+    process->setProgram(program);
+    process->setArguments(arguments);
+    process->setWorkingDirectory(mWorkDir);
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     QString path = env.value("PATH");
     QStringList pathAdded;
@@ -69,80 +79,61 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
         path = pathAdded.join(PATH_SEPARATOR);
     }
     env.insert("PATH",path);
-    process.setProcessEnvironment(env);
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.connect(
-                &process, &QProcess::errorOccurred,
-                [&](){
-        errorOccurred= true;
-    });
-    problemCase->output.clear();
-    process.start();
-    process.waitForStarted(5000);
-    if (process.state()==QProcess::Running) {
-        process.write(problemCase->input.toUtf8());
-        process.closeWriteChannel();
+    process->setProcessEnvironment(env);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    return process;
+}
+
+void OJProblemCasesRunner::openOutputFile(POJProblemCase problemCase, QFile &file)
+{
+    if (problemCase->outputFileName.isEmpty()) {
+        QTemporaryFile tempFile(QDir(QDir::tempPath()).filePath("redpanda-case-XXXXXX.out"));
+        tempFile.setAutoRemove(false);
+        if (tempFile.open())
+            problemCase->outputFileName = tempFile.fileName();
     }
-    QByteArray readed;
-    QByteArray buffer;
-    QByteArray output;
-    int noOutputTime = 0;
-    while (true) {
-        process.waitForFinished(mWaitForFinishTime);
-        readed = process.read(mBufferSize);
-        buffer += readed;
-        if (process.state()!=QProcess::Running) {
-            break;
-        }
-        if (mStop) {            
-            process.closeReadChannel(QProcess::StandardOutput);
-            process.closeReadChannel(QProcess::StandardError);
-            process.closeWriteChannel();
-            process.terminate();
-            process.kill();
-            break;
-        }
-        if (errorOccurred)
-            break;
-        if (buffer.length()>=mBufferSize || noOutputTime > mOutputRefreshTime) {
-            if (!buffer.isEmpty()) {
-                emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
-                output.append(buffer);
-                buffer.clear();
-            }
-            noOutputTime = 0;
-        } else {
-            noOutputTime += mWaitForFinishTime;
-        }
+    file.setFileName(problemCase->outputFileName);
+    if (problemCase->outputFileName.isEmpty()
+            || !file.open(QFile::WriteOnly | QFile::Truncate)) {
+        //validate with the preview in memory
+        problemCase->outputFileName.clear();
     }
-    if (process.state() == QProcess::ProcessState::NotRunning)
-        buffer += process.readAll();
-    emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
-    output.append(buffer);
-    if (errorOccurred) {
-        //qDebug()<<"process error:"<<process.error();
-        switch (process.error()) {
-        case QProcess::FailedToStart:
-            emit runErrorOccurred(tr("The runner process '%1' failed to start.").arg(mFilename));
-            break;
+}
+
+void OJProblemCasesRunner::reportProcessError(QProcess::ProcessError error)
+{
+    switch (error) {
+    case QProcess::FailedToStart:
+        emit runErrorOccurred(tr("The runner process '%1' failed to start.").arg(mFilename));
+        break;
 //        case QProcess::Crashed:
 //            if (!mStop)
 //                emit runErrorOccurred(tr("The runner process crashed after starting successfully."));
 //            break;
-        case QProcess::Timedout:
-            emit runErrorOccurred(tr("The last waitFor...() function timed out."));
-            break;
-        case QProcess::WriteError:
-            emit runErrorOccurred(tr("An error occurred when attempting to write to the runner process."));
-            break;
-        case QProcess::ReadError:
-            emit runErrorOccurred(tr("An error occurred when attempting to read from the runner process."));
-            break;
-        default:
-            break;
-        }
+    case QProcess::Timedout:
+        emit runErrorOccurred(tr("The last waitFor...() function timed out."));
+        break;
+    case QProcess::WriteError:
+        emit runErrorOccurred(tr("An error occurred when attempting to write to the runner process."));
+        break;
+    case QProcess::ReadError:
+        emit runErrorOccurred(tr("An error occurred when attempting to read from the runner process."));
+        break;
+    default:
+        break;
     }
-    problemCase->output = QString::fromLocal8Bit(output);
+}
+
+namespace {
+struct CaseRun {
+    POJProblemCase problemCase;
+    QFile outputFile;
+    QByteArray preview; // beginning of the output, the rest is only written to outputFile
+    QByteArray buffer; // output not sent by newOutputGetted yet
+    QElapsedTimer refreshTimer;
+    QElapsedTimer wallTimer;
+    bool killedByTimer;
+};
 }
 
 void OJProblemCasesRunner::run()
@@ -151,12 +142,161 @@ void OJProblemCasesRunner::run()
     auto action = finally([this]{
         emit terminated();
     });
-    for (int i=0; i < mProblemCases.size(); i++) {
-        if (mStop)
-            break;
-        POJProblemCase problemCase = mProblemCases[i];
-        runCase(i,problemCase);
-    }
+    int total = mProblemCases.count();
+    int maxRunning = std::max(1,std::min(mMaxParallelCases,total));
+    int nextIndex = 0;
+    int finishedCount = 0;
+    QHash<OJProblemCaseProcess*,std::shared_ptr<CaseRun>> runningCases;
+    QEventLoop eventLoop;
+
+    std::function<void()> startCases;
+    auto flushOutput = [this](const std::shared_ptr<CaseRun>& caseRun) {
+        if (!caseRun->buffer.isEmpty()) {
+            if (caseRun->outputFile.isOpen())
+                caseRun->outputFile.write(caseRun->buffer);
+            int previewSize = std::min(caseRun->buffer.length(),
+                                       OJ_CASE_PREVIEW_SIZE - caseRun->preview.length());
+            if (previewSize>0) {
+                QByteArray newOutput = caseRun->buffer.left(previewSize);
+                emit newOutputGetted(caseRun->problemCase->getId(),QString::fromLocal8Bit(newOutput));
+                caseRun->preview.append(newOutput);
+            }
+            caseRun->buffer.clear();
+        }
+        caseRun->refreshTimer.restart();
+    };
+    auto finishCase = [&](OJProblemCaseProcess* process) {
+        std::shared_ptr<CaseRun> caseRun = runningCases.take(process);
+        if (!caseRun)
+            return;
+        caseRun->buffer.append(process->readAll());
+        flushOutput(caseRun);
+        POJProblemCase problemCase = caseRun->problemCase;
+        problemCase->output = QString::fromLocal8Bit(caseRun->preview);
+        if (caseRun->outputFile.isOpen()) {
+            problemCase->outputTruncated = caseRun->outputFile.size() > caseRun->preview.length();
+            caseRun->outputFile.close();
+        }
+        process->collectUsage();
+        problemCase->runningTime = caseRun->wallTimer.elapsed();
+        problemCase->cpuTime = process->cpuTime();
+        problemCase->peakMemory = process->peakMemory();
+        problemCase->timeLimitExceeded = mTimeLimit>0
+                && (caseRun->killedByTimer
+                    || problemCase->cpuTime > mTimeLimit
+                    || (process->exitStatus()==QProcess::CrashExit
+                        && problemCase->runningTime > mTimeLimit));
+        problemCase->memoryLimitExceeded = mMemoryLimit>0
+                && problemCase->peakMemory > (qint64)mMemoryLimit*1024;
+        process->deleteLater();
+        finishedCount++;
+        emit caseFinished(caseRun->problemCase->getId(), finishedCount, total);
+        startCases();
+    };
+    startCases = [&]() {
+        while (!mStop && runningCases.count()<maxRunning && nextIndex<total) {
+            std::shared_ptr<CaseRun> caseRun = std::make_shared<CaseRun>();
+            caseRun->problemCase = mProblemCases[nextIndex++];
+            caseRun->problemCase->output.clear();
+            caseRun->problemCase->outputTruncated = false;
+            caseRun->killedByTimer = false;
+            openOutputFile(caseRun->problemCase, caseRun->outputFile);
+            emit caseStarted(caseRun->problemCase->getId(), finishedCount, total);
+            OJProblemCaseProcess* process = createCaseProcess(mFilename, splitProcessCommand(mArguments),
+                                                              mTimeLimit, mMemoryLimit);
+            runningCases.insert(process,caseRun);
+            if (!caseRun->problemCase->inputFileName.isEmpty()) {
+                process->setStandardInputFile(caseRun->problemCase->inputFileName);
+            } else {
+                connect(process, &QProcess::started,
+                        process, [process,caseRun](){
+                    process->write(caseRun->problemCase->input.toUtf8());
+                    process->closeWriteChannel();
+                });
+            }
+            connect(process, &QProcess::readyRead,
+                    process, [this,process,caseRun,flushOutput](){
+                caseRun->buffer.append(process->readAll());
+                if (caseRun->buffer.length()>=mBufferSize
+                        || caseRun->refreshTimer.elapsed()>mOutputRefreshTime)
+                    flushOutput(caseRun);
+            });
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    process, [&finishCase,process](){
+                finishCase(process);
+            });
+            connect(process, &QProcess::errorOccurred,
+                    process, [this,&finishCase,process](QProcess::ProcessError error){
+                reportProcessError(error);
+                // finished() is not emitted if the process can't be started
+                if (error == QProcess::FailedToStart)
+                    finishCase(process);
+            });
+            if (mTimeLimit>0) {
+                // kill programs blocked or sleeping far beyond the limit
+                QTimer::singleShot(std::max(mTimeLimit*2, mTimeLimit+1000),
+                                   process, [process,caseRun](){
+                    caseRun->killedByTimer = true;
+                    process->kill();
+                });
+            }
+            caseRun->refreshTimer.start();
+            caseRun->wallTimer.start();
+            process->startCase();
+        }
+        if (runningCases.isEmpty())
+            eventLoop.quit();
+    };
+
+    // completion of cases is signaled by the processes, the timer only checks for stop requests
+    QTimer stopTimer;
+    stopTimer.setInterval(mWaitForFinishTime);
+    connect(&stopTimer, &QTimer::timeout,
+            &stopTimer, [&runningCases,this](){
+        if (!mStop)
+            return;
+        foreach (OJProblemCaseProcess* process, runningCases.keys()) {
+            process->closeWriteChannel();
+            process->kill();
+        }
+    });
+    stopTimer.start();
+
+    startCases();
+    if (!runningCases.isEmpty())
+        eventLoop.exec();
+    stopTimer.stop();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+int OJProblemCasesRunner::timeLimit() const
+{
+    return mTimeLimit;
+}
+
+void OJProblemCasesRunner::setTimeLimit(int newTimeLimit)
+{
+    mTimeLimit = newTimeLimit;
+}
+
+int OJProblemCasesRunner::memoryLimit() const
+{
+    return mMemoryLimit;
+}
+
+void OJProblemCasesRunner::setMemoryLimit(int newMemoryLimit)
+{
+    mMemoryLimit = newMemoryLimit;
+}
+
+int OJProblemCasesRunner::maxParallelCases() const
+{
+    return mMaxParallelCases;
+}
+
+void OJProblemCasesRunner::setMaxParallelCases(int newMaxParallelCases)
+{
+    mMaxParallelCases = newMaxParallelCases;
 }
 
 int OJProblemCasesRunner::waitForFinishTime() const
@@ -19,8 +19,11 @@
 
 #include "runner.h"
 #include <QVector>
+#include <QProcess>
 #include "../problems/ojproblemset.h"
 
+class OJProblemCaseProcess;
+class QFile;
 class OJProblemCasesRunner : public Runner
 {
     Q_OBJECT
@@ -40,21 +43,41 @@ public:
     int waitForFinishTime() const;
     void setWaitForFinishTime(int newWaitForFinishTime);
 
+    //time limit (in milliseconds) of each case, 0 for no limit
+    int timeLimit() const;
+    void setTimeLimit(int newTimeLimit);
+
+    //memory limit (in MB) of each case, 0 for no limit
+    int memoryLimit() const;
+    void setMemoryLimit(int newMemoryLimit);
+
+    //max number of cases running at the same time
+    int maxParallelCases() const;
+    void setMaxParallelCases(int newMaxParallelCases);
+
 signals:
     void caseStarted(const QString& id, int current, int total);
     void caseFinished(const QString& id, int current, int total);
     void newOutputGetted(const QString&id, const QString& newOutputLine);
+protected:
+    OJProblemCaseProcess* createCaseProcess(const QString& program, const QStringList& arguments,
+                                            int timeLimit, int memoryLimit);
+    void reportProcessError(QProcess::ProcessError error);
 private:
-    void runCase(int index, POJProblemCase problemCase);
+    //the whole output of the case is saved to a temp file
+    void openOutputFile(POJProblemCase problemCase, QFile& file);
 private:
     QVector<POJProblemCase> mProblemCases;
 
     // QThread interface
 protected:
     void run() override;
-private:
+protected:
     int mBufferSize;
     int mOutputRefreshTime;
+    int mMaxParallelCases;
+    int mTimeLimit;
+    int mMemoryLimit;
 };
 
 #endif // OJPROBLEMCASESRUNNER_H
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ojproblemstressrunner.h"
+#include "ojproblemcaseprocess.h"
+#include "../problems/problemcasevalidator.h"
+#include "../utils.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <functional>
+
+#define STRESS_PROGRESS_INTERVAL 500
+
+OJProblemStressRunner::OJProblemStressRunner(const QString &filename, const QString &arguments, const QString &workDir,
+                                             const QString &generatorFilename, const QString &bruteForceFilename,
+                                             QObject *parent):
+    OJProblemCasesRunner(filename,arguments,workDir,QVector<POJProblemCase>(),parent),
+    mGeneratorFilename(generatorFilename),
+    mBruteForceFilename(bruteForceFilename),
+    mIgnoreSpaces(false),
+    mFloatTolerance(0)
+{
+}
+
+namespace {
+struct StressSlot {
+    quint32 seed;
+    QString inputFileName;
+    QString outputFileName;
+    QString expectedFileName;
+    OJProblemCaseProcess* answer;
+    OJProblemCaseProcess* bruteForce;
+    int runningCount; // answer and brute force not finished yet
+    bool answerStarted;
+    bool bruteForceStarted;
+    bool answerKilledByTimer;
+    bool bruteForceKilledByTimer;
+};
+}
+
+void OJProblemStressRunner::run()
+{
+    emit started();
+    auto action = finally([this]{
+        emit terminated();
+    });
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        emit runErrorOccurred(tr("Can't create temporary folder for the stress test."));
+        return;
+    }
+    int slotCount = std::max(1,mMaxParallelCases);
+    quint32 seed = QRandomGenerator::global()->generate();
+    qint64 iterations = 0;
+    bool done = false; //failing case found or error occurred
+    int runningSlots = 0;
+    QSet<OJProblemCaseProcess*> processes;
+    QVector<std::shared_ptr<StressSlot>> stressSlots;
+    QEventLoop eventLoop;
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    auto reportIterations = [&]() {
+        qint64 elapsed = std::max<qint64>(1,totalTimer.elapsed());
+        emit iterationsUpdated(iterations, iterations*1000.0/elapsed);
+    };
+    auto finishAll = [&]() {
+        done = true;
+        foreach (OJProblemCaseProcess* process, processes) {
+            process->kill();
+        }
+    };
+    // calls onFinished with false if the process can't be started.
+    // the process should be deleted by onFinished.
+    auto runProcess = [&](OJProblemCaseProcess* process, std::function<void(bool)> onFinished) {
+        processes.insert(process);
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                process, [&processes,process,onFinished](){
+            processes.remove(process);
+            onFinished(true);
+        });
+        connect(process, &QProcess::errorOccurred,
+                process, [&processes,process,onFinished](QProcess::ProcessError error){
+            if (error != QProcess::FailedToStart)
+                return;
+            processes.remove(process);
+            onFinished(false);
+        });
+        process->startCase();
+    };
+
+    std::function<void(std::shared_ptr<StressSlot>)> startIteration;
+    auto endSlot = [&]() {
+        runningSlots--;
+        if (runningSlots==0)
+            eventLoop.quit();
+    };
+    auto checkIteration = [&](std::shared_ptr<StressSlot> slot) {
+        auto cleanUp = finally([slot]{
+            slot->answer->deleteLater();
+            slot->bruteForce->deleteLater();
+        });
+        if (done || mStop) {
+            endSlot();
+            return;
+        }
+        if (!slot->answerStarted || !slot->bruteForceStarted) {
+            emit runErrorOccurred(tr("The program '%1' failed to start.")
+                                  .arg(slot->answerStarted?mBruteForceFilename:mFilename));
+            finishAll();
+            endSlot();
+            return;
+        }
+        if (slot->bruteForceKilledByTimer) {
+            emit runErrorOccurred(tr("The brute force program exceeded the time limit with seed %1.")
+                                  .arg(slot->seed));
+            finishAll();
+            endSlot();
+            return;
+        }
+        if (slot->bruteForce->exitStatus()!=QProcess::NormalExit || slot->bruteForce->exitCode()!=0) {
+            emit runErrorOccurred(tr("The brute force program exited abnormally with seed %1.")
+                                  .arg(slot->seed));
+            finishAll();
+            endSlot();
+            return;
+        }
+        OJProblemCaseProcess* answer = slot->answer;
+        answer->collectUsage();
+        QString reason;
+        if (mTimeLimit>0 && (slot->answerKilledByTimer || answer->cpuTime()>mTimeLimit)) {
+            reason = tr("Time Limit Exceeded");
+        } else if (mMemoryLimit>0 && answer->peakMemory()>(qint64)mMemoryLimit*1024) {
+            reason = tr("Memory Limit Exceeded");
+        } else if (answer->exitStatus()!=QProcess::NormalExit || answer->exitCode()!=0) {
+            reason = tr("Runtime Error");
+        } else {
+            ProblemCaseValidator validator;
+            validator.setFloatTolerance(mFloatTolerance);
+            if (!validator.validateFiles(slot->outputFileName,slot->expectedFileName,mIgnoreSpaces))
+                reason = tr("Wrong Answer at line %1, column %2")
+                        .arg(validator.mismatchLine())
+                        .arg(validator.mismatchColumn());
+        }
+        if (!reason.isEmpty()) {
+            iterations++;
+            POJProblemCase problemCase = createFailingCase(slot->inputFileName,slot->expectedFileName,slot->seed);
+            emit failingCaseFound(problemCase, reason);
+            finishAll();
+            endSlot();
+            return;
+        }
+        iterations++;
+        startIteration(slot);
+    };
+    auto startSolvers = [&](std::shared_ptr<StressSlot> slot) {
+        slot->runningCount = 2;
+        slot->answerKilledByTimer = false;
+        slot->bruteForceKilledByTimer = false;
+        auto onFinished = [&checkIteration,slot]() {
+            slot->runningCount--;
+            if (slot->runningCount==0)
+                checkIteration(slot);
+        };
+        slot->answer = createCaseProcess(mFilename, splitProcessCommand(mArguments),
+                                         mTimeLimit, mMemoryLimit);
+        slot->bruteForce = createCaseProcess(mBruteForceFilename, QStringList(), mTimeLimit, 0);
+        for (OJProblemCaseProcess* process : {slot->answer, slot->bruteForce}) {
+            process->setProcessChannelMode(QProcess::SeparateChannels);
+            process->setStandardInputFile(slot->inputFileName);
+            process->setStandardErrorFile(QProcess::nullDevice());
+        }
+        slot->answer->setStandardOutputFile(slot->outputFileName);
+        slot->bruteForce->setStandardOutputFile(slot->expectedFileName);
+        if (mTimeLimit>0) {
+            // kill programs blocked or sleeping far beyond the limit
+            int killTime = std::max(mTimeLimit*2, mTimeLimit+1000);
+            OJProblemCaseProcess* answer = slot->answer;
+            QTimer::singleShot(killTime, answer, [answer,slot](){
+                // it may have finished while the other program is still running
+                if (answer->state()==QProcess::NotRunning)
+                    return;
+                slot->answerKilledByTimer = true;
+                answer->kill();
+            });
+            OJProblemCaseProcess* bruteForce = slot->bruteForce;
+            QTimer::singleShot(killTime, bruteForce, [bruteForce,slot](){
+                // it may have finished while the other program is still running
+                if (bruteForce->state()==QProcess::NotRunning)
+                    return;
+                slot->bruteForceKilledByTimer = true;
+                bruteForce->kill();
+            });
+        }
+        runProcess(slot->answer, [onFinished,slot](bool started){
+            slot->answerStarted = started;
+            onFinished();
+        });
+        runProcess(slot->bruteForce, [onFinished,slot](bool started){
+            slot->bruteForceStarted = started;
+            onFinished();
+        });
+    };
+    startIteration = [&](std::shared_ptr<StressSlot> slot) {
+        if (done || mStop) {
+            endSlot();
+            return;
+        }
+        slot->seed = seed++;
+        OJProblemCaseProcess* generator = createCaseProcess(
+                    mGeneratorFilename, QStringList{QString::number(slot->seed)}, 0, 0);
+        generator->setProcessChannelMode(QProcess::SeparateChannels);
+        generator->setStandardOutputFile(slot->inputFileName);
+        generator->setStandardErrorFile(QProcess::nullDevice());
+        runProcess(generator, [&,slot,generator](bool started){
+            generator->deleteLater();
+            if (done || mStop) {
+                endSlot();
+                return;
+            }
+            if (!started) {
+                emit runErrorOccurred(tr("The generator '%1' failed to start.").arg(mGeneratorFilename));
+                finishAll();
+                endSlot();
+            } else if (generator->exitStatus()!=QProcess::NormalExit || generator->exitCode()!=0) {
+                emit runErrorOccurred(tr("The generator exited abnormally with seed %1.").arg(slot->seed));
+                finishAll();
+                endSlot();
+            } else {
+                startSolvers(slot);
+            }
+        });
+    };
+
+    // the timer checks for stop requests and reports the throughput
+    QTimer stopTimer;
+    QElapsedTimer progressTimer;
+    stopTimer.setInterval(mWaitForFinishTime);
+    connect(&stopTimer, &QTimer::timeout,
+            &stopTimer, [&,this](){
+        if (progressTimer.elapsed()>=STRESS_PROGRESS_INTERVAL) {
+            reportIterations();
+            progressTimer.restart();
+        }
+        if (mStop)
+            finishAll();
+    });
+    progressTimer.start();
+    stopTimer.start();
+
+    QDir dir(tempDir.path());
+    for (int i=0;i<slotCount;i++) {
+        std::shared_ptr<StressSlot> slot = std::make_shared<StressSlot>();
+        slot->inputFileName = dir.filePath(QString("%1.in").arg(i));
+        slot->outputFileName = dir.filePath(QString("%1.out").arg(i));
+        slot->expectedFileName = dir.filePath(QString("%1.ans").arg(i));
+        slot->answer = nullptr;
+        slot->bruteForce = nullptr;
+        stressSlots.append(slot);
+        runningSlots++;
+    }
+    foreach (const std::shared_ptr<StressSlot>& slot, stressSlots) {
+        startIteration(slot);
+    }
+    if (runningSlots>0)
+        eventLoop.exec();
+    stopTimer.stop();
+    reportIterations();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+POJProblemCase OJProblemStressRunner::createFailingCase(const QString &inputFileName, const QString &expectedFileName, quint32 seed)
+{
+    POJProblemCase problemCase = std::make_shared<OJProblemCase>();
+    problemCase->name = tr("Stress Test %1").arg(seed);
+    // small data is kept in the problem set, large one is copied to the case folder
+    auto keepData = [this,seed](const QString& tempFileName, const QString& suffix,
+            QString& text, QString& fileName) {
+        if (QFileInfo(tempFileName).size()>OJ_CASE_PREVIEW_SIZE && !mCaseDir.isEmpty()) {
+            QString newFileName = QDir(mCaseDir).filePath(QString("stress-%1.%2").arg(seed).arg(suffix));
+            QFile::remove(newFileName);
+            if (QFile::copy(tempFileName,newFileName)) {
+                fileName = newFileName;
+                return;
+            }
+        }
+        text = readProblemCaseFilePreview(tempFileName);
+    };
+    keepData(inputFileName, "in", problemCase->input, problemCase->inputFileName);
+    keepData(expectedFileName, "ans", problemCase->expected, problemCase->expectedOutputFileName);
+    return problemCase;
+}
+
+bool OJProblemStressRunner::ignoreSpaces() const
+{
+    return mIgnoreSpaces;
+}
+
+void OJProblemStressRunner::setIgnoreSpaces(bool newIgnoreSpaces)
+{
+    mIgnoreSpaces = newIgnoreSpaces;
+}
+
+double OJProblemStressRunner::floatTolerance() const
+{
+    return mFloatTolerance;
+}
+
+void OJProblemStressRunner::setFloatTolerance(double newFloatTolerance)
+{
+    mFloatTolerance = newFloatTolerance;
+}
+
+const QString &OJProblemStressRunner::caseDir() const
+{
+    return mCaseDir;
+}
+
+void OJProblemStressRunner::setCaseDir(const QString &newCaseDir)
+{
+    mCaseDir = newCaseDir;
+}
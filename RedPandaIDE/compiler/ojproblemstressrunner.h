@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OJPROBLEMSTRESSRUNNER_H
+#define OJPROBLEMSTRESSRUNNER_H
+
+#include "ojproblemcasesrunner.h"
+
+/**
+ * Stress tests the answer program of a problem.
+ *
+ * In each iteration the generator is run with a new seed as its argument,
+ * its output is fed to both the answer and the brute force program, and the
+ * outputs are compared. Iterations run in parallel until a failing input is
+ * found or the runner is stopped.
+ */
+class OJProblemStressRunner : public OJProblemCasesRunner
+{
+    Q_OBJECT
+public:
+    explicit OJProblemStressRunner(const QString& filename, const QString& arguments, const QString& workDir,
+                                   const QString& generatorFilename, const QString& bruteForceFilename,
+                                   QObject *parent = nullptr);
+
+    bool ignoreSpaces() const;
+    void setIgnoreSpaces(bool newIgnoreSpaces);
+
+    double floatTolerance() const;
+    void setFloatTolerance(double newFloatTolerance);
+
+    //folder to save failing inputs too large to be kept in memory
+    const QString &caseDir() const;
+    void setCaseDir(const QString &newCaseDir);
+
+signals:
+    void iterationsUpdated(qint64 iterations, double iterationsPerSecond);
+    void failingCaseFound(POJProblemCase problemCase, const QString& reason);
+private:
+    POJProblemCase createFailingCase(const QString& inputFileName, const QString& expectedFileName, quint32 seed);
+
+    // QThread interface
+protected:
+    void run() override;
+private:
+    QString mGeneratorFilename;
+    QString mBruteForceFilename;
+    bool mIgnoreSpaces;
+    double mFloatTolerance;
+    QString mCaseDir;
+};
+
+#endif // OJPROBLEMSTRESSRUNNER_H
@@ -21,36 +21,117 @@
 #include "../platform.h"
 #include "../editor.h"
 
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QThread>
+
+#define MAKEFILE_HASH_PREFIX "# Inputs hash: "
+
+// memory a single g++ process may take when compiling a heavy translation unit
+#define MAKE_JOB_MEMORY (512*1024*1024ULL)
 
 ProjectCompiler::ProjectCompiler(std::shared_ptr<Project> project, bool silent, bool onlyCheckSyntax):
     Compiler("",silent,onlyCheckSyntax),
-    mOnlyClean(false)
+    mOnlyClean(false),
+    mMakeJobs(1)
 {
     setProject(project);
 }
 
-void ProjectCompiler::buildMakeFile()
+void ProjectCompiler::buildMakeFile(bool force)
 {
     //we are using custom make file, don't overwrite it
     if (!mProject->options().customMakefile.isEmpty())
         return;
 
+    // Generate the makefile in memory, and hash it together with the inputs
+    // of the generator, which don't all end up in its text.
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
     switch(mProject->options().type) {
     case ProjectType::StaticLib:
-        createStaticMakeFile();
+        createStaticMakeFile(buffer);
         break;
     case ProjectType::DynamicLib:
-        createDynamicMakeFile();
+        createDynamicMakeFile(buffer);
         break;
     default:
-        createStandardMakeFile();
+        createStandardMakeFile(buffer);
+    }
+    buffer.close();
+    QCryptographicHash hasher(QCryptographicHash::Md5);
+    hasher.addData(makeFileInputs());
+    hasher.addData(buffer.data());
+    QByteArray hash = hasher.result().toHex();
+
+    // Don't touch the makefile if nothing changed, or make will think it's newer than the targets
+    if (!force && hash == readMakeFileHash()) {
+        log(tr("Makefile is up to date."));
+        log("");
+        return;
     }
+
+    // Write more information to the log file than before
+    log(tr("Building makefile..."));
+    log("--------");
+    log(tr("- Filename: %1").arg(mProject->makeFileName()));
+    log("");
+
+    QFile file(mProject->makeFileName());
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        throw CompileError(tr("Can't open '%1' for write!").arg(mProject->makeFileName()));
+    writeln(file, MAKEFILE_HASH_PREFIX + hash);
+    file.write(buffer.data());
+}
+
+QByteArray ProjectCompiler::makeFileInputs()
+{
+    QByteArray inputs;
+    QBuffer buffer(&inputs);
+    buffer.open(QBuffer::WriteOnly);
+    // the generator itself
+    writeln(buffer, REDPANDA_CPP_VERSION);
+    writeln(buffer, QString::number(static_cast<int>(mProject->options().type)));
+    writeln(buffer, mOnlyCheckSyntax?"1":"0");
+    // the compiler set
+    Settings::PCompilerSet compilerSet = this->compilerSet();
+    writeln(buffer, compilerSet->name());
+    writeln(buffer, compilerSet->CCompiler());
+    writeln(buffer, compilerSet->cppCompiler());
+    writeln(buffer, compilerSet->resourceCompiler());
+    buffer.write(compilerSet->iniOptions());
+    writeln(buffer);
+    writeln(buffer, compilerSet->useCustomCompileParams()?compilerSet->customCompileParams():"");
+    writeln(buffer, compilerSet->useCustomLinkParams()?compilerSet->customLinkParams():"");
+    writeln(buffer, compilerSet->autoAddCharsetParams()?"1":"0");
+    writeln(buffer, compilerSet->staticLink()?"1":"0");
+    // the saved project options and units
+    QFile projectFile(mProject->filename());
+    if (projectFile.open(QFile::ReadOnly))
+        buffer.write(projectFile.readAll());
+    buffer.close();
+    return inputs;
 }
 
-void ProjectCompiler::createStandardMakeFile()
+QByteArray ProjectCompiler::readMakeFileHash()
 {
     QFile file(mProject->makeFileName());
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+    QByteArray line = file.readLine().trimmed();
+    if (!line.startsWith(MAKEFILE_HASH_PREFIX))
+        return QByteArray();
+    return line.mid(strlen(MAKEFILE_HASH_PREFIX));
+}
+
+void ProjectCompiler::createStandardMakeFile(QIODevice& file)
+{
     newMakeFile(file);
     file.write("$(BIN): $(OBJ)\n");
     if (!mOnlyCheckSyntax) {
@@ -62,9 +143,8 @@ void ProjectCompiler::createStandardMakeFile()
     writeMakeObjFilesRules(file);
 }
 
-void ProjectCompiler::createStaticMakeFile()
+void ProjectCompiler::createStaticMakeFile(QIODevice& file)
 {
-    QFile file(mProject->makeFileName());
     newMakeFile(file);
     writeln(file,"$(BIN): $(LINKOBJ)");
     if (!mOnlyCheckSyntax) {
@@ -74,9 +154,8 @@ void ProjectCompiler::createStaticMakeFile()
     writeMakeObjFilesRules(file);
 }
 
-void ProjectCompiler::createDynamicMakeFile()
+void ProjectCompiler::createDynamicMakeFile(QIODevice& file)
 {
-    QFile file(mProject->makeFileName());
     newMakeFile(file);
     writeln(file,"$(BIN): $(LINKOBJ)");
     if (!mOnlyCheckSyntax) {
@@ -89,22 +168,13 @@ void ProjectCompiler::createDynamicMakeFile()
     writeMakeObjFilesRules(file);
 }
 
-void ProjectCompiler::newMakeFile(QFile& file)
+void ProjectCompiler::newMakeFile(QIODevice& file)
 {
     // Create OBJ output directory
     if (!mProject->options().objectOutput.isEmpty()) {
         QDir(mProject->directory()).mkpath(mProject->options().objectOutput);
     }
 
-    // Write more information to the log file than before
-    log(tr("Building makefile..."));
-    log("--------");
-    log(tr("- Filename: %1").arg(mProject->makeFileName()));
-
-    // Create the actual file
-    if (!file.open(QFile::WriteOnly | QFile::Truncate))
-        throw CompileError(tr("Can't open '%1' for write!").arg(mProject->makeFileName()));
-
     // Write header
     writeMakeHeader(file);
 
@@ -121,7 +191,7 @@ void ProjectCompiler::newMakeFile(QFile& file)
     writeMakeClean(file);
 }
 
-void ProjectCompiler::writeMakeHeader(QFile &file)
+void ProjectCompiler::writeMakeHeader(QIODevice &file)
 {
     writeln(file,"# Project: " + mProject->name());
     writeln(file,QString("# Makefile created by Red Panda C++ ") + REDPANDA_CPP_VERSION);
@@ -133,12 +203,13 @@ void ProjectCompiler::writeMakeHeader(QFile &file)
     }
 }
 
-void ProjectCompiler::writeMakeDefines(QFile &file)
+void ProjectCompiler::writeMakeDefines(QIODevice &file)
 {
     // Get list of object files
     QString Objects;
     QString LinkObjects;
     QString cleanObjects;
+    QString Deps;
 
     // Create a list of object files
     for (int i=0;i<mProject->units().count();i++) {
@@ -157,14 +228,18 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
                 QString relativeObjFile = extractRelativePath(mProject->directory(), changeFileExt(fullObjFile, OBJ_EXT));
                 QString ObjFile = genMakePath2(relativeObjFile);
                 Objects += ' ' + ObjFile;
+                QString relativeDepFile = changeFileExt(relativeObjFile, DEP_EXT);
+                Deps += ' ' + genMakePath2(relativeDepFile);
 
-                cleanObjects += ' ' + genMakePath1(relativeObjFile);
+                cleanObjects += ' ' + genMakePath1(relativeObjFile) + ' ' + genMakePath1(relativeDepFile);
                 if (unit->link()) {
                     LinkObjects += ' ' + genMakePath1(relativeObjFile);
                 }
             } else {
                 Objects += ' ' + genMakePath2(changeFileExt(RelativeName, OBJ_EXT));
-                cleanObjects += ' ' + genMakePath1(changeFileExt(RelativeName, OBJ_EXT));
+                Deps += ' ' + genMakePath2(changeFileExt(RelativeName, DEP_EXT));
+                cleanObjects += ' ' + genMakePath1(changeFileExt(RelativeName, OBJ_EXT))
+                        + ' ' + genMakePath1(changeFileExt(RelativeName, DEP_EXT));
                 if (unit->link())
                     LinkObjects = LinkObjects + ' ' + genMakePath1(changeFileExt(RelativeName, OBJ_EXT));
             }
@@ -173,6 +248,7 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
 
     Objects = Objects.trimmed();
     LinkObjects = LinkObjects.trimmed();
+    Deps = Deps.trimmed();
 
     // Get windres file
     QString ObjResFile;
@@ -219,6 +295,7 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
       writeln(file,"LINKOBJ  = " + LinkObjects);
       writeln(file,"CLEANOBJ  = " + cleanObjects);
     };
+    writeln(file,"DEP      = " + Deps);
     libraryArguments.replace('\\', '/');
     writeln(file,"LIBS     = " + libraryArguments);
     cIncludeArguments.replace('\\', '/');
@@ -254,7 +331,7 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
     writeln(file);
 }
 
-void ProjectCompiler::writeMakeTarget(QFile &file)
+void ProjectCompiler::writeMakeTarget(QIODevice &file)
 {
     if (mOnlyCheckSyntax)
         writeln(file, ".PHONY: all all-before all-after clean clean-custom $(OBJ) $(BIN)");
@@ -270,7 +347,7 @@ void ProjectCompiler::writeMakeTarget(QFile &file)
     }
 }
 
-void ProjectCompiler::writeMakeIncludes(QFile &file)
+void ProjectCompiler::writeMakeIncludes(QIODevice &file)
 {
     foreach(const QString& s, mProject->options().makeIncludes) {
         writeln(file, "include " + genMakePath1(s));
@@ -280,7 +357,7 @@ void ProjectCompiler::writeMakeIncludes(QFile &file)
     }
 }
 
-void ProjectCompiler::writeMakeClean(QFile &file)
+void ProjectCompiler::writeMakeClean(QIODevice &file)
 {
     writeln(file, "clean: clean-custom");
     if (mProject->options().type == ProjectType::DynamicLib)
@@ -290,9 +367,8 @@ void ProjectCompiler::writeMakeClean(QFile &file)
     writeln(file);
 }
 
-void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
+void ProjectCompiler::writeMakeObjFilesRules(QIODevice &file)
 {
-    PCppParser parser = mProject->cppParser();
     QString precompileStr;
     if (mProject->options().usePrecompiledHeader)
         precompileStr = " $(PCH) ";
@@ -307,25 +383,8 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
         QString shortFileName = extractRelativePath(mProject->makeFileName(),unit->fileName());
 
         writeln(file);
+        // header prerequisites come from the dependency files generated by the compiler (-MMD)
         QString objStr=genMakePath2(shortFileName);
-        // if we have scanned it, use scanned info
-        if (parser && parser->scannedFiles().contains(unit->fileName())) {
-            QSet<QString> fileIncludes = parser->getFileIncludes(unit->fileName());
-            foreach (const QString& headerName, fileIncludes) {
-                if (headerName == unit->fileName())
-                    continue;
-                if (!parser->isSystemHeaderFile(headerName)
-                        && ! parser->isProjectHeaderFile(headerName)) {
-                    objStr = objStr + ' ' + genMakePath2(extractRelativePath(mProject->makeFileName(),headerName));
-                }
-            }
-        } else {
-            foreach (const PProjectUnit& u, mProject->units()) {
-                FileType fileType = getFileType(u->fileName());
-                if (fileType == FileType::CHeader || fileType==FileType::CppHeader)
-                    objStr = objStr + ' ' + genMakePath2(extractRelativePath(mProject->makeFileName(),u->fileName()));
-            }
-        }
         QString ObjFileName;
         QString ObjFileName2;
         if (!mProject->options().objectOutput.isEmpty()) {
@@ -378,9 +437,9 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
                     writeln(file, "\t(CC) -c " + genMakePath1(unit->fileName()) + " $(CFLAGS) " + encodingStr);
             } else {
                 if (unit->compileCpp())
-                    writeln(file, "\t$(CPP) -c " + genMakePath1(unit->fileName()) + " -o " + ObjFileName2 + " $(CXXFLAGS) " + encodingStr);
+                    writeln(file, "\t$(CPP) -c " + genMakePath1(unit->fileName()) + " -o " + ObjFileName2 + " -MMD -MP $(CXXFLAGS) " + encodingStr);
                 else
-                    writeln(file, "\t$(CC) -c " + genMakePath1(unit->fileName()) + " -o " + ObjFileName2 + " $(CFLAGS) " + encodingStr);
+                    writeln(file, "\t$(CC) -c " + genMakePath1(unit->fileName()) + " -o " + ObjFileName2 + " -MMD -MP $(CFLAGS) " + encodingStr);
             }
         }
     }
@@ -439,9 +498,14 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
         writeln(file);
     }
 #endif
+
+    if (!mOnlyCheckSyntax) {
+        writeln(file);
+        writeln(file, "-include $(DEP)");
+    }
 }
 
-void ProjectCompiler::writeln(QFile &file, const QString &s)
+void ProjectCompiler::writeln(QIODevice &file, const QString &s)
 {
     if (!s.isEmpty())
         file.write(s.toLocal8Bit());
@@ -466,9 +530,60 @@ QString ProjectCompiler::pipedText()
 bool ProjectCompiler::prepareForRebuild()
 {
     //we use make argument to clean
+    if (mMakeJobs<=1)
+        return true;
+    //"clean all" is not safe in parallel builds, clean first
+    runCommand(mCompiler, QString("-f \"%1\" clean").arg(extractRelativePath(
+                                                            mProject->directory(),
+                                                            mProject->makeFileName())),
+               mDirectory);
     return true;
 }
 
+int ProjectCompiler::makeJobs()
+{
+    int jobs = mProject->options().makeJobs;
+    if (jobs<=0) {
+        jobs = QThread::idealThreadCount();
+        qulonglong freeMemory = availablePhysicalMemory();
+        if (freeMemory>0)
+            jobs = std::min(jobs, (int)std::max(freeMemory / MAKE_JOB_MEMORY, 1ULL));
+        jobs = std::max(jobs,1);
+    }
+    if (jobs>1 && !makeSupportsOutputSync()) {
+        // without --output-sync, diagnostics of different files would be mixed up
+        jobs = 1;
+    }
+    return jobs;
+}
+
+bool ProjectCompiler::makeSupportsOutputSync()
+{
+    // running make --version for every build is slow on windows, so remember
+    // the answer until the make binary is replaced
+    struct MakeVersionInfo {
+        QDateTime modified;
+        bool supportsOutputSync;
+    };
+    static QMutex mutex;
+    static QHash<QString,MakeVersionInfo> cache;
+    QDateTime modified = QFileInfo(mCompiler).lastModified();
+    {
+        QMutexLocker locker(&mutex);
+        auto it = cache.constFind(mCompiler);
+        if (it!=cache.constEnd() && it->modified == modified)
+            return it->supportsOutputSync;
+    }
+    QByteArray output = runAndGetOutput(mCompiler, mProject->directory(), {"--version"});
+    QRegularExpression re("GNU Make (\\d+)\\.");
+    QRegularExpressionMatch match = re.match(QString::fromLocal8Bit(output));
+    // --output-sync was introduced in GNU Make 4.0
+    bool result = match.hasMatch() && match.captured(1).toInt()>=4;
+    QMutexLocker locker(&mutex);
+    cache.insert(mCompiler, {modified, result});
+    return result;
+}
+
 bool ProjectCompiler::prepareForCompile()
 {
     if (!mProject)
@@ -483,24 +598,30 @@ bool ProjectCompiler::prepareForCompile()
     buildMakeFile();
 
     mCompiler = compilerSet()->make();
+    mMakeJobs = mOnlyClean?1:makeJobs();
+    QString jobsArgument;
+    if (mMakeJobs>1)
+        jobsArgument = QString(" -j%1 --output-sync=target").arg(mMakeJobs);
     if (mOnlyClean) {
         mArguments = QString("-f \"%1\" clean").arg(extractRelativePath(
                                                             mProject->directory(),
                                                             mProject->makeFileName()));
-    } else if (mRebuild) {
+    } else if (mRebuild && mMakeJobs<=1) {
         mArguments = QString("-f \"%1\" clean all").arg(extractRelativePath(
                                                             mProject->directory(),
                                                             mProject->makeFileName()));
     } else {
-        mArguments = QString("-f \"%1\" all").arg(extractRelativePath(
+        mArguments = QString("-f \"%1\"%2 all").arg(extractRelativePath(
                                                       mProject->directory(),
-                                                      mProject->makeFileName()));
+                                                      mProject->makeFileName()),
+                                                      jobsArgument);
     }
     mDirectory = mProject->directory();
 
     log(tr("Processing makefile:"));
     log("--------");
     log(tr("- makefile processer: %1").arg(mCompiler));
+    log(tr("- Parallel jobs: %1").arg(mMakeJobs));
     log(tr("- Command: %1 %2").arg(extractFileName(mCompiler)).arg(mArguments));
     log("");
 
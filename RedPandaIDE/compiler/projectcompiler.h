@@ -26,26 +26,31 @@ class ProjectCompiler : public Compiler
     Q_OBJECT
 public:
     ProjectCompiler(std::shared_ptr<Project> project, bool silent,bool onlyCheckSyntax);
-    void buildMakeFile();
+    void buildMakeFile(bool force = false);
 
     bool onlyClean() const;
     void setOnlyClean(bool newOnlyClean);
 
 private:
-    void createStandardMakeFile();
-    void createStaticMakeFile();
-    void createDynamicMakeFile();
-    void newMakeFile(QFile& file);
-    void writeMakeHeader(QFile& file);
-    void writeMakeDefines(QFile& file);
-    void writeMakeTarget(QFile& file);
-    void writeMakeIncludes(QFile& file);
-    void writeMakeClean(QFile& file);
-    void writeMakeObjFilesRules(QFile& file);
-    void writeln(QFile& file, const QString& s="");
+    void createStandardMakeFile(QIODevice& file);
+    void createStaticMakeFile(QIODevice& file);
+    void createDynamicMakeFile(QIODevice& file);
+    QByteArray makeFileInputs();
+    QByteArray readMakeFileHash();
+    void newMakeFile(QIODevice& file);
+    void writeMakeHeader(QIODevice& file);
+    void writeMakeDefines(QIODevice& file);
+    void writeMakeTarget(QIODevice& file);
+    void writeMakeIncludes(QIODevice& file);
+    void writeMakeClean(QIODevice& file);
+    void writeMakeObjFilesRules(QIODevice& file);
+    void writeln(QIODevice& file, const QString& s="");
+    int makeJobs();
+    bool makeSupportsOutputSync();
     // Compiler interface
 private:
     bool mOnlyClean;
+    int mMakeJobs;
 protected:
     bool prepareForCompile() override;
     QString pipedText() override;
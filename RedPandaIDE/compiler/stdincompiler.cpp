@@ -39,8 +39,10 @@ bool StdinCompiler::prepareForCompile()
     if (fileType == FileType::Other)
         fileType = FileType::CppSource;
     QString strFileType;
+    QString charsetArgument;
     if (!mIsAscii)
-        mArguments += getCharsetArgument(pCharsetInfoManager->getDefaultSystemEncoding());
+        charsetArgument = getCharsetArgument(pCharsetInfoManager->getDefaultSystemEncoding());
+    mArguments += charsetArgument;
     switch(fileType) {
     case FileType::CSource:
         mArguments += " -x c - ";
@@ -52,14 +54,21 @@ bool StdinCompiler::prepareForCompile()
         break;
     case FileType::CppSource:
     case FileType::CppHeader:
-    case FileType::CHeader:
+    case FileType::CHeader: {
+        mCompiler = compilerSet()->cppCompiler();
+        QString compileArguments = getCppCompileArguments(mOnlyCheckSyntax);
+        QString includeArguments = getCppIncludeArguments() + getProjectIncludeArguments();
         mArguments += " -x c++ - ";
-        mArguments += getCppCompileArguments(mOnlyCheckSyntax);
-        mArguments += getCppIncludeArguments();
-        mArguments += getProjectIncludeArguments();
+        mArguments += compileArguments;
+        if (pSettings->executor().autoPrecompileHeaders()) {
+            mArguments += getPrecompiledHeaderArguments(
+                        mContent,
+                        charsetArgument + compileArguments + includeArguments);
+        }
+        mArguments += includeArguments;
         strFileType = "C++";
-        mCompiler = compilerSet()->cppCompiler();
         break;
+    }
     default:
         throw CompileError(tr("Can't find the compiler for file %1").arg(mFilename));
     }
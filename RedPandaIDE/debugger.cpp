@@ -27,12 +27,76 @@
 #include <QMessageBox>
 #include <QPlainTextEdit>
 #include <QDebug>
+#include <QRegularExpression>
+#include <limits>
 #include <QDir>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include "widgets/signalmessagedialog.h"
 
+static QString quoteMIArgument(const QString& s)
+{
+    QString result = s;
+    result.replace('\\',"\\\\");
+    result.replace('"',"\\\"");
+    return QString("\"%1\"").arg(result);
+}
+
+//split a dprintf log message ("format",arg1,arg2) into MI arguments
+static QStringList splitDprintfArguments(const QString& logMessage)
+{
+    QStringList parts;
+    QString current;
+    int depth = 0;
+    QChar quote;
+    for (int i=0;i<logMessage.length();i++) {
+        QChar ch = logMessage[i];
+        if (!quote.isNull()) {
+            current+=ch;
+            if (ch=='\\' && i+1<logMessage.length()) {
+                current+=logMessage[++i];
+            } else if (ch==quote) {
+                quote = QChar();
+            }
+            continue;
+        }
+        if (ch=='"' || ch=='\'') {
+            quote = ch;
+        } else if (ch=='(' || ch=='[' || ch=='{') {
+            depth++;
+        } else if (ch==')' || ch==']' || ch=='}') {
+            depth--;
+        } else if (ch==',' && depth<=0) {
+            parts.append(current.trimmed());
+            current.clear();
+            continue;
+        }
+        current+=ch;
+    }
+    parts.append(current.trimmed());
+
+    QStringList result;
+    for (int i=0;i<parts.count();i++) {
+        const QString& part = parts[i];
+        if (part.isEmpty())
+            continue;
+        if (i==0) {
+            //the format is a c string, quote it if the user didn't
+            if (part.length()>=2 && part.startsWith('"') && part.endsWith('"'))
+                result.append(part);
+            else
+                result.append(quoteMIArgument(part));
+        } else if (part.startsWith('"') || part.contains(QRegularExpression("\\s"))) {
+            //MI splits arguments at spaces
+            result.append(quoteMIArgument(part));
+        } else {
+            result.append(part);
+        }
+    }
+    return result;
+}
+
 Debugger::Debugger(QObject *parent) : QObject(parent)
 {
     mBreakpointModel=new BreakpointModel(this);
@@ -42,6 +106,8 @@ Debugger::Debugger(QObject *parent) : QObject(parent)
     mMemoryModel = new MemoryModel(8,this);
     connect(mMemoryModel,&MemoryModel::setMemoryData,
             this, &Debugger::setMemoryData);
+    connect(mMemoryModel,&MemoryModel::fetchMemory,
+            this, &Debugger::fetchMemory);
     connect(mWatchModel, &WatchModel::setWatchVarValue,
             this, &Debugger::setWatchVarValue);
     mExecuting = false;
@@ -49,6 +115,8 @@ Debugger::Debugger(QObject *parent) : QObject(parent)
     mTarget = nullptr;
     mCommandChanged = false;
     mLeftPageIndexBackup = -1;
+    mDisassemblyIntelStyle = false;
+    mDisassemblyBlendMode = false;
 
     connect(mWatchModel, &WatchModel::fetchChildren,
             this, &Debugger::fetchVarChildren);
@@ -105,6 +173,7 @@ bool Debugger::start(const QString& inferior)
     }
     mMemoryModel->reset();
     mWatchModel->resetAllVarInfos();
+    mDisassemblyCache.setBinary(inferior);
     if (pSettings->debugger().useGDBServer()) {
         mTarget = new DebugTarget(inferior,compilerSet->debugServer(),pSettings->debugger().GDBServerPort());
         if (pSettings->executor().redirectInput())
@@ -131,10 +200,18 @@ bool Debugger::start(const QString& inferior)
 
     connect(mReader, &DebugReader::breakpointInfoGetted, mBreakpointModel,
             &BreakpointModel::updateBreakpointNumber);
+    connect(mReader, &DebugReader::breakpointHitCountUpdated, mBreakpointModel,
+            &BreakpointModel::updateBreakpointHitCount);
     connect(mReader, &DebugReader::localsUpdated, pMainWindow,
             &MainWindow::onLocalsReady);
-    connect(mReader, &DebugReader::memoryUpdated,this,
-            &Debugger::updateMemory);
+    connect(mReader, &DebugReader::memoryLocated,mMemoryModel,
+            &MemoryModel::locate);
+    connect(mReader, &DebugReader::memoryUpdated,mMemoryModel,
+            &MemoryModel::updateMemory);
+    connect(mReader, &DebugReader::memoryReadFailed,mMemoryModel,
+            &MemoryModel::setUnreadable);
+    connect(mReader, &DebugReader::inferiorContinued,mMemoryModel,
+            &MemoryModel::invalidate);
     connect(mReader, &DebugReader::evalUpdated,this,
             &Debugger::updateEval);
     connect(mReader, &DebugReader::disassemblyUpdate,this,
@@ -147,6 +224,10 @@ bool Debugger::start(const QString& inferior)
             &WatchModel::updateVarInfo);
     connect(mReader, &DebugReader::prepareVarChildren,mWatchModel,
             &WatchModel::prepareVarChildren);
+    connect(mReader, &DebugReader::tracepointInsertFailed,this,
+            &Debugger::onTracepointInsertFailed);
+    connect(mReader, &DebugReader::listVarChildrenFailed,mWatchModel,
+            &WatchModel::cancelFetchVarChildren);
     connect(mReader, &DebugReader::addVarChild,mWatchModel,
             &WatchModel::addVarChild);
     connect(mReader, &DebugReader::varValueUpdated,mWatchModel,
@@ -222,8 +303,7 @@ void Debugger::refreshAll()
 {
     refreshWatchVars();
     sendCommand("-stack-list-variables", "--all-values");
-    if (memoryModel()->startAddress()>0)
-        sendCommand("-data-read-memory",QString("%1 x 1 8 8 ").arg(memoryModel()->startAddress()));
+    mMemoryModel->fetchVisiblePages();
 }
 
 RegisterModel *Debugger::registerModel() const
@@ -278,6 +358,7 @@ void Debugger::addBreakpoint(int line, const QString &filename)
     bp->condition = "";
     bp->enabled = true;
     bp->breakpointType = BreakpointType::Breakpoint;
+    bp->hitCount = 0;
     mBreakpointModel->addBreakpoint(bp);
     if (mExecuting) {
         sendBreakpointCommand(bp);
@@ -348,15 +429,28 @@ PBreakpoint Debugger::breakpointAt(int line, const Editor *editor, int &index)
 void Debugger::setBreakPointCondition(int index, const QString &condition)
 {
     PBreakpoint breakpoint=mBreakpointModel->setBreakPointCondition(index,condition);
+    if (breakpoint->number<0)
+        return;
     if (condition.isEmpty()) {
         sendCommand("-break-condition",
-                    QString("%1").arg(breakpoint->line));
+                    QString("%1").arg(breakpoint->number));
     } else {
         sendCommand("-break-condition",
-                    QString("%1 %2").arg(breakpoint->line).arg(condition));
+                    QString("%1 %2").arg(breakpoint->number).arg(condition));
     }
 }
 
+void Debugger::setBreakPointLogMessage(int index, const QString &logMessage)
+{
+    PBreakpoint breakpoint = mBreakpointModel->breakpoint(index);
+    if (!breakpoint)
+        return;
+    //gdb can't change the kind of a breakpoint, so insert it again
+    sendClearBreakpointCommand(breakpoint);
+    mBreakpointModel->setBreakPointLogMessage(index,logMessage);
+    sendBreakpointCommand(breakpoint);
+}
+
 void Debugger::sendAllBreakpointsToDebugger()
 {
     for (PBreakpoint breakpoint:mBreakpointModel->breakpoints()) {
@@ -416,10 +510,11 @@ void Debugger::refreshWatchVars()
     }
 }
 
-void Debugger::fetchVarChildren(const QString &varName)
+void Debugger::fetchVarChildren(const QString &varName, int from, int to)
 {
     if (mExecuting) {
-        sendCommand("-var-list-children",varName);
+        sendCommand("-var-list-children",QString("\"%1\" %2 %3")
+                    .arg(varName).arg(from).arg(to));
     }
 }
 
@@ -449,6 +544,19 @@ void Debugger::removeWatchVar(const QModelIndex &index)
     mWatchModel->removeWatchVar(index);
 }
 
+void Debugger::collapseWatchVar(const QModelIndex &index)
+{
+    if (!index.isValid())
+        return;
+    WatchVar* var = static_cast<WatchVar*>(index.internalPointer());
+    if (var->children.isEmpty())
+        return;
+    //delete the children var objects, so -var-update only works on expanded vars
+    if (mExecuting && !var->name.isEmpty())
+        sendCommand("-var-delete",QString("-c %1").arg(var->name));
+    mWatchModel->releaseVarChildren(index);
+}
+
 void Debugger::sendAllWatchVarsToDebugger()
 {
     for (PWatchVar var:mWatchModel->watchVars()) {
@@ -496,10 +604,21 @@ void Debugger::sendBreakpointCommand(PBreakpoint breakpoint)
         }
         QString filename = breakpoint->filename;
         filename.replace('\\','/');
-        sendCommand("-break-insert",
-                    QString("%1 --source \"%2\" --line %3")
-                    .arg(condition,filename)
-                    .arg(breakpoint->line));
+        breakpoint->hitCount = 0;
+        if (breakpoint->breakpointType == BreakpointType::Tracepoint) {
+            // dprintf prints the log message in gdb and continues,
+            // the inferior is not stopped
+            sendCommand("-dprintf-insert",
+                        QString("%1 --source \"%2\" --line %3 %4")
+                        .arg(condition,filename)
+                        .arg(breakpoint->line)
+                        .arg(splitDprintfArguments(breakpoint->logMessage).join(' ')));
+        } else {
+            sendCommand("-break-insert",
+                        QString("%1 --source \"%2\" --line %3")
+                        .arg(condition,filename)
+                        .arg(breakpoint->line));
+        }
     }
 }
 
@@ -600,10 +719,18 @@ void Debugger::setWatchVarValue(const QString &name, const QString &value)
     refreshAll();
 }
 
-void Debugger::updateMemory(const QStringList &value)
+void Debugger::fetchMemory(qulonglong address, int length)
+{
+    if (mExecuting)
+        sendCommand("-data-read-memory-bytes",QString("%1 %2").arg(address).arg(length));
+}
+
+void Debugger::onTracepointInsertFailed(const QString &filename, int line, const QString &message)
 {
-    mMemoryModel->updateMemory(value);
-    emit memoryExamineReady(value);
+    QMessageBox::critical(pMainWindow,
+                          tr("Tracepoint"),
+                          tr("Can't set the tracepoint at line %1 of \"%2\":").arg(line).arg(filename)
+                          +"<br /><br />"+message);
 }
 
 void Debugger::updateEval(const QString &value)
@@ -613,11 +740,71 @@ void Debugger::updateEval(const QString &value)
 
 void Debugger::updateDisassembly(const QString& file, const QString& func, const QStringList &value)
 {
+    bool isCurrent;
+    PDisassemblyFunction function = DisassemblyCache::parse(value,
+                                                            mDisassemblyIntelStyle,
+                                                            mDisassemblyBlendMode,
+                                                            isCurrent);
+    if (!function)
+        return;
+    //a prefetch may hit a function that is already cached
+    PDisassemblyFunction oldFunction = mDisassemblyCache.find(function->startAddress,
+                                                              function->intelStyle,
+                                                              function->blendMode);
+    if (oldFunction && oldFunction->startAddress == function->startAddress)
+        return;
+    mDisassemblyCache.add(function);
+    //prefetched functions don't contain the current instruction
+    if (!isCurrent)
+        return;
+    function->filename = file;
+    function->funcName = func;
+    if (pMainWindow->cpuDialog() && mReader) {
+        pMainWindow->cpuDialog()->setDisassembly(function,mReader->currentAddress());
+    }
+    //functions are usually 16 bytes aligned
+    prefetchDisassembly(function->startAddress-1);
+    prefetchDisassembly((function->endAddress+16) & ~(qulonglong)15);
+}
+
+void Debugger::requestDisassembly(bool intelStyle, bool blendMode)
+{
+    if (!mExecuting || !mReader)
+        return;
+    qulonglong address = mReader->currentAddress();
+    PDisassemblyFunction function = mDisassemblyCache.find(address,intelStyle,blendMode);
+    mDisassemblyIntelStyle = intelStyle;
+    mDisassemblyBlendMode = blendMode;
+    if (!function) {
+        if (blendMode)
+            sendCommand("disas", "/s");
+        else
+            sendCommand("disas", "");
+        return;
+    }
+    //function is prefetched
+    if (function->funcName.isEmpty()) {
+        function->filename = mReader->currentFile();
+        function->funcName = mReader->currentFunc();
+    }
     if (pMainWindow->cpuDialog()) {
-        pMainWindow->cpuDialog()->setDisassembly(file,func,value);
+        pMainWindow->cpuDialog()->setDisassembly(function,address);
     }
 }
 
+void Debugger::prefetchDisassembly(qulonglong address)
+{
+    if (address == 0 || address == std::numeric_limits<qulonglong>::max())
+        return;
+    if (mDisassemblyCache.find(address,mDisassemblyIntelStyle,mDisassemblyBlendMode))
+        return;
+    //heartbeat commands don't disable the debug actions
+    if (mDisassemblyBlendMode)
+        sendCommand("disas", QString("/s 0x%1").arg(address,0,16), DebugCommandSource::HeartBeat);
+    else
+        sendCommand("disas", QString("0x%1").arg(address,0,16), DebugCommandSource::HeartBeat);
+}
+
 void Debugger::onChangeDebugConsoleLastline(const QString& text)
 {
     //pMainWindow->changeDebugOutputLastline(text);
@@ -791,7 +978,10 @@ void DebugReader::processResult(const QByteArray &result)
         handleEvaluation(multiValues["value"].value());
         return;
     case GDBMIResultType::Memory:
-        handleMemory(multiValues["memory"].array());
+        handleMemory(multiValues);
+        return;
+    case GDBMIResultType::MemoryBytes:
+        handleMemoryBytes(multiValues["memory"].array());
         return;
     case GDBMIResultType::RegisterNames:
         handleRegisterNames(multiValues["register-names"].array());
@@ -851,7 +1041,7 @@ void DebugReader::processExecAsyncRecord(const QByteArray &line)
         GDBMIResultParser::ParseValue frame(multiValues["frame"]);
         if (frame.isValid()) {
             GDBMIResultParser::ParseObject frameObj = frame.object();
-            mCurrentAddress = frameObj["addr"].hexValue();
+            mCurrentAddress = frameObj["addr"].addressValue();
             mCurrentLine = frameObj["line"].intValue();
             mCurrentFile = frameObj["fullname"].pathValue();
             mCurrentFunc = frameObj["func"].value();
@@ -869,9 +1059,50 @@ void DebugReader::processExecAsyncRecord(const QByteArray &line)
     }
 }
 
+void DebugReader::processNotifyAsyncRecord(const QByteArray &line)
+{
+    QByteArray result;
+    GDBMIResultParser::ParseObject multiValues;
+    GDBMIResultParser parser;
+    if (!parser.parseAsyncResult(line,result,multiValues))
+        return;
+    if (result == "breakpoint-modified") {
+        GDBMIResultParser::ParseObject breakpoint = multiValues["bkpt"].object();
+        int number = breakpoint["number"].intValue();
+        int hitCount = breakpoint["times"].intValue(0);
+        if (number>=0)
+            mBreakpointHitCounts.insert(number,hitCount);
+    }
+}
+
 void DebugReader::processError(const QByteArray &errorLine)
 {
     mConsoleOutput.append(QString::fromLocal8Bit(errorLine));
+    if (mCurrentCmd && mCurrentCmd->command == "-var-list-children") {
+        //let the var fetch its children again later
+        QString parentName = listVarChildrenParentName();
+        if (!parentName.isEmpty())
+            emit listVarChildrenFailed(parentName);
+    } else if (mCurrentCmd && mCurrentCmd->command == "-dprintf-insert") {
+        //params is: [-c condition] --source "filename" --line linenum format args
+        QRegularExpression re("--source \"([^\"]*)\" --line (\\d+)");
+        QRegularExpressionMatch match = re.match(mCurrentCmd->params);
+        GDBMIResultParser parser;
+        GDBMIResultType resultType;
+        GDBMIResultParser::ParseObject multiValues;
+        QString message;
+        int pos = errorLine.indexOf(',');
+        if (pos>=0 && parser.parse(errorLine.mid(pos+1), mCurrentCmd->command, resultType, multiValues))
+            message = multiValues["msg"].value();
+        emit tracepointInsertFailed(match.captured(1),match.captured(2).toInt(),message);
+    } else if (mCurrentCmd && mCurrentCmd->command == "-data-read-memory-bytes") {
+        //params is: address length
+        bool ok;
+        qulonglong address = mCurrentCmd->params.section(' ',0,0).toULongLong(&ok);
+        int length = mCurrentCmd->params.section(' ',1,1).toInt();
+        if (ok && length>0)
+            emit memoryReadFailed(address,length);
+    }
 }
 
 void DebugReader::processResultRecord(const QByteArray &line)
@@ -945,11 +1176,18 @@ void DebugReader::processDebugOutput(const QByteArray& debugOutput)
          case '*': // exec async output
              processExecAsyncRecord(line);
              break;
-         case '+': // status async output
          case '=': // notify async output
+             processNotifyAsyncRecord(line);
+             break;
+         case '+': // status async output
              break;
          }
     }
+    //tracepoints may be hit many times in one output, only report the last count
+    for (auto it=mBreakpointHitCounts.begin();it!=mBreakpointHitCounts.end();++it) {
+        emit breakpointHitCountUpdated(it.key(),it.value());
+    }
+    mBreakpointHitCounts.clear();
     emit parseFinished();
     mConsoleOutput.clear();
     mFullOutput.clear();
@@ -997,7 +1235,8 @@ void DebugReader::runNextCmd()
         params = " - @ "+params;
     } else if (pCmd->command == "-var-list-children") {
         //hack for list variable children,to easy remember var expression
-        params = " --all-values \"" + params+'\"';
+        //params is: "var name" from to
+        params = " --all-values " + params;
     }
     s+=" "+params;
     s+= "\n";
@@ -1165,20 +1404,22 @@ void DebugReader::handleEvaluation(const QString &value)
     emit evalUpdated(value);
 }
 
-void DebugReader::handleMemory(const QList<GDBMIResultParser::ParseValue> &rows)
+void DebugReader::handleMemory(const GDBMIResultParser::ParseObject &multiVars)
 {
-    QStringList memory;
-    foreach (const GDBMIResultParser::ParseValue& row, rows) {
-        GDBMIResultParser::ParseObject rowObject = row.object();
-        QList<GDBMIResultParser::ParseValue> data = rowObject["data"].array();
-        QStringList values;
-        foreach (const GDBMIResultParser::ParseValue& val, data) {
-            values.append(val.value());
-        }
-        memory.append(QString("%1 %2")
-                            .arg(rowObject["addr"].value(),values.join(" ")));
+    //-data-read-memory is only used to get the address of an expression
+    GDBMIResultParser::ParseValue addr = multiVars["addr"];
+    if (addr.isValid())
+        emit memoryLocated(addr.addressValue());
+}
+
+void DebugReader::handleMemoryBytes(const QList<GDBMIResultParser::ParseValue> &blocks)
+{
+    foreach (const GDBMIResultParser::ParseValue& block, blocks) {
+        GDBMIResultParser::ParseObject blockObject = block.object();
+        qulonglong address = blockObject["begin"].addressValue();
+        QByteArray datas = QByteArray::fromHex(blockObject["contents"].value());
+        emit memoryUpdated(address, datas);
     }
-    emit memoryUpdated(memory);
 }
 
 void DebugReader::handleRegisterNames(const QList<GDBMIResultParser::ParseValue> &names)
@@ -1223,13 +1464,14 @@ void DebugReader::handleCreateVar(const GDBMIResultParser::ParseObject &multiVar
 
 void DebugReader::handleListVarChildren(const GDBMIResultParser::ParseObject &multiVars)
 {
-    if (!mCurrentCmd)
+    QString parentName = listVarChildrenParentName();
+    if (parentName.isEmpty())
         return;
-    QString parentName = mCurrentCmd->params;
-    int parentNumChild = multiVars["numchild"].intValue(0);
+    const QString& params = mCurrentCmd->params;
+    int from = params.mid(params.lastIndexOf('"')+1).trimmed().section(' ',0,0).toInt();
     QList<GDBMIResultParser::ParseValue> children = multiVars["children"].array();
     bool hasMore = multiVars["has_more"].value()!="0";
-    emit prepareVarChildren(parentName,parentNumChild,hasMore);
+    emit prepareVarChildren(parentName,from,hasMore);
     foreach(const GDBMIResultParser::ParseValue& child, children) {
         GDBMIResultParser::ParseObject childObj = child.object();
         QString name = childObj["name"].value();
@@ -1248,6 +1490,18 @@ void DebugReader::handleListVarChildren(const GDBMIResultParser::ParseObject &mu
     }
 }
 
+QString DebugReader::listVarChildrenParentName() const
+{
+    if (!mCurrentCmd)
+        return QString();
+    //params is: "var name" from to
+    const QString& params = mCurrentCmd->params;
+    int nameEnd = params.lastIndexOf('"');
+    if (nameEnd<1)
+        return QString();
+    return params.mid(1,nameEnd-1);
+}
+
 void DebugReader::handleUpdateVarValue(const QList<GDBMIResultParser::ParseValue> &changes)
 {
     foreach (const GDBMIResultParser::ParseValue& value, changes) {
@@ -1287,6 +1541,21 @@ void DebugReader::asyncUpdate()
     mAsyncUpdated = false;
 }
 
+qulonglong DebugReader::currentAddress() const
+{
+    return mCurrentAddress;
+}
+
+const QString &DebugReader::currentFile() const
+{
+    return mCurrentFile;
+}
+
+const QString &DebugReader::currentFunc() const
+{
+    return mCurrentFunc;
+}
+
 const QString &DebugReader::signalMeaning() const
 {
     return mSignalMeaning;
@@ -1451,7 +1720,7 @@ int BreakpointModel::rowCount(const QModelIndex &) const
 
 int BreakpointModel::columnCount(const QModelIndex &) const
 {
-    return 3;
+    return 5;
 }
 
 QVariant BreakpointModel::data(const QModelIndex &index, int role) const
@@ -1476,6 +1745,10 @@ QVariant BreakpointModel::data(const QModelIndex &index, int role) const
                 return "";
         case 2:
             return breakpoint->condition;
+        case 3:
+            return breakpoint->hitCount;
+        case 4:
+            return breakpoint->logMessage;
         default:
             return QVariant();
         }
@@ -1490,6 +1763,10 @@ QVariant BreakpointModel::data(const QModelIndex &index, int role) const
                 return "";
         case 2:
             return breakpoint->condition;
+        case 3:
+            return breakpoint->hitCount;
+        case 4:
+            return breakpoint->logMessage;
         default:
             return QVariant();
         }
@@ -1508,6 +1785,10 @@ QVariant BreakpointModel::headerData(int section, Qt::Orientation orientation, i
             return tr("Line");
         case 2:
             return tr("Condition");
+        case 3:
+            return tr("Hit Count");
+        case 4:
+            return tr("Log Message");
         }
     }
     return QVariant();
@@ -1550,6 +1831,18 @@ PBreakpoint BreakpointModel::setBreakPointCondition(int index, const QString &co
     return breakpoint;
 }
 
+PBreakpoint BreakpointModel::setBreakPointLogMessage(int index, const QString &logMessage)
+{
+    PBreakpoint breakpoint = mList[index];
+    breakpoint->logMessage = logMessage;
+    if (logMessage.isEmpty())
+        breakpoint->breakpointType = BreakpointType::Breakpoint;
+    else
+        breakpoint->breakpointType = BreakpointType::Tracepoint;
+    emit dataChanged(createIndex(index,0),createIndex(index,4));
+    return breakpoint;
+}
+
 const QList<PBreakpoint> &BreakpointModel::breakpoints() const
 {
     return mList;
@@ -1574,6 +1867,7 @@ void BreakpointModel::save(const QString &filename)
             obj["condition"]=breakpoint->condition;
             obj["enabled"]=breakpoint->enabled;
             obj["breakpoint_type"] = static_cast<int>(breakpoint->breakpointType);
+            obj["log_message"] = breakpoint->logMessage;
             array.append(obj);
         }
         QJsonDocument doc;
@@ -1614,6 +1908,9 @@ void BreakpointModel::load(const QString &filename)
             breakpoint->condition = obj["condition"].toString();
             breakpoint->enabled = obj["enabled"].toBool();
             breakpoint->breakpointType = static_cast<BreakpointType>(obj["breakpoint_type"].toInt());
+            breakpoint->logMessage = obj["log_message"].toString();
+            breakpoint->number = -1;
+            breakpoint->hitCount = 0;
 
             addBreakpoint(breakpoint);
         }
@@ -1633,6 +1930,18 @@ void BreakpointModel::updateBreakpointNumber(const QString& filename, int line,
     }
 }
 
+void BreakpointModel::updateBreakpointHitCount(int number, int hitCount)
+{
+    for (int i=0;i<mList.count();i++) {
+        PBreakpoint bp = mList[i];
+        if (bp->number == number) {
+            bp->hitCount = hitCount;
+            emit dataChanged(createIndex(i,3),createIndex(i,3));
+            return;
+        }
+    }
+}
+
 void BreakpointModel::onFileDeleteLines(const QString& filename, int startLine, int count)
 {
     for (int i = mList.count()-1;i>=0;i--){
@@ -1927,6 +2236,11 @@ void WatchModel::resetAllVarInfos()
         var->children.clear();
     }
     mVarIndex.clear();
+    mFetchingVars.clear();
+    //the replies of the old var objects won't come
+    mPendingVarChildren.clear();
+    mVarGenerations.clear();
+    mDroppedReplyParent.clear();
     endResetModel();
 }
 
@@ -1947,24 +2261,40 @@ void WatchModel::updateVarInfo(const QString &expression, const QString &name, i
     emit dataChanged(idx,createIndex(idx.row(),2,var.get()));
 }
 
-void WatchModel::prepareVarChildren(const QString &parentName, int numChild, bool hasMore)
+void WatchModel::prepareVarChildren(const QString &parentName, int from, bool hasMore)
 {
+    //the var was collapsed or removed after the children were requested
+    if (!takeVarChildrenReply(parentName)) {
+        mDroppedReplyParent = parentName;
+        return;
+    }
+    mDroppedReplyParent.clear();
     PWatchVar var = mVarIndex.value(parentName,PWatchVar());
     if (var) {
-        var->numChild = numChild;
         var->hasMore = hasMore;
-        if (var->children.count()>0) {
+        //the first page is (re)listed, drop the old children
+        if (from==0 && var->children.count()>0) {
             beginRemoveRows(index(var),0,var->children.count()-1);
+            foreach (const PWatchVar& child, var->children) {
+                removeVarIndexes(child.get());
+            }
             var->children.clear();
             endRemoveRows();
         }
     }
 }
 
+void WatchModel::cancelFetchVarChildren(const QString &parentName)
+{
+    takeVarChildrenReply(parentName);
+}
+
 void WatchModel::addVarChild(const QString &parentName, const QString &name,
                              const QString &exp, int numChild, const QString &value,
                              const QString &type, bool hasMore)
 {
+    if (parentName == mDroppedReplyParent)
+        return;
     PWatchVar var = mVarIndex.value(parentName,PWatchVar());
     if (!var)
         return;
@@ -1978,6 +2308,9 @@ void WatchModel::addVarChild(const QString &parentName, const QString &name,
     child->hasMore = hasMore;
     child->parent = var.get();
     var->children.append(child);
+    //dynamic var objects (pretty printers) don't report the children count
+    if (var->numChild<var->children.count())
+        var->numChild = var->children.count();
     endInsertRows();
     mVarIndex.insert(name,child);
 }
@@ -1998,11 +2331,15 @@ void WatchModel::updateVarValue(const QString &name, const QString &val, const Q
     QModelIndex idx = index(var);
     bool oldHasMore = var->hasMore;
     var->hasMore = hasMore;
+    //only refresh children of expanded vars
     if (newNumChildren>=0
             && var->numChild!=newNumChildren) {
         var->numChild = newNumChildren;
-        fetchMore(idx);
-    } else  if (!oldHasMore && hasMore) {
+        if (!var->children.isEmpty() && !mFetchingVars.contains(var->name)) {
+            requestVarChildren(var->name,0,
+                               std::max(var->children.count(),WATCH_VAR_CHILDREN_PAGE_SIZE));
+        }
+    } else  if (!oldHasMore && hasMore && !var->children.isEmpty()) {
         fetchMore(idx);
     }
     emit dataChanged(idx,createIndex(idx.row(),2,var.get()));
@@ -2020,6 +2357,11 @@ void WatchModel::clearAllVarInfos()
         var->children.clear();
     }
     mVarIndex.clear();
+    mFetchingVars.clear();
+    //the replies of the old var objects won't come
+    mPendingVarChildren.clear();
+    mVarGenerations.clear();
+    mDroppedReplyParent.clear();
     endResetModel();
 }
 
@@ -2055,6 +2397,22 @@ void WatchModel::notifyUpdated(PWatchVar var)
     emit dataChanged(createIndex(row,0,var.get()),createIndex(row,0,var.get()));
 }
 
+void WatchModel::releaseVarChildren(const QModelIndex &index)
+{
+    if (!index.isValid())
+        return;
+    WatchVar* var = static_cast<WatchVar*>(index.internalPointer());
+    dropPendingVarChildren(var->name);
+    if (var->children.isEmpty())
+        return;
+    beginRemoveRows(this->index(var),0,var->children.count()-1);
+    foreach (const PWatchVar& child, var->children) {
+        removeVarIndexes(child.get());
+    }
+    var->children.clear();
+    endRemoveRows();
+}
+
 void WatchModel::save(const QString &filename)
 {
     QFile file(filename);
@@ -2148,6 +2506,44 @@ QModelIndex WatchModel::index(WatchVar* pVar) const {
     }
 }
 
+void WatchModel::removeVarIndexes(WatchVar *var)
+{
+    foreach (const PWatchVar& child, var->children) {
+        removeVarIndexes(child.get());
+    }
+    mVarIndex.remove(var->name);
+    dropPendingVarChildren(var->name);
+}
+
+void WatchModel::requestVarChildren(const QString &name, int from, int to)
+{
+    mFetchingVars.insert(name);
+    mPendingVarChildren[name].enqueue(mVarGenerations.value(name,0));
+    emit fetchChildren(name, from, to);
+}
+
+bool WatchModel::takeVarChildrenReply(const QString &name)
+{
+    //gdb answers the requests of a var in order
+    auto it = mPendingVarChildren.find(name);
+    if (it == mPendingVarChildren.end() || it->isEmpty())
+        return false;
+    int generation = it->dequeue();
+    if (it->isEmpty())
+        mPendingVarChildren.erase(it);
+    if (generation != mVarGenerations.value(name,0))
+        return false;
+    mFetchingVars.remove(name);
+    return true;
+}
+
+void WatchModel::dropPendingVarChildren(const QString &name)
+{
+    mFetchingVars.remove(name);
+    if (mPendingVarChildren.contains(name))
+        mVarGenerations[name] = mVarGenerations.value(name,0)+1;
+}
+
 bool WatchModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
     if (!index.isValid()) {
@@ -2197,9 +2593,10 @@ void WatchModel::fetchMore(const QModelIndex &parent)
         return;
     }
     WatchVar* item = static_cast<WatchVar*>(parent.internalPointer());
-    item->hasMore = false;
-    item->numChild = item->children.count();
-    emit fetchChildren(item->name);
+    if (item->name.isEmpty() || mFetchingVars.contains(item->name))
+        return;
+    int from = item->children.count();
+    requestVarChildren(item->name, from, from + WATCH_VAR_CHILDREN_PAGE_SIZE);
 }
 
 bool WatchModel::canFetchMore(const QModelIndex &parent) const
@@ -2208,6 +2605,8 @@ bool WatchModel::canFetchMore(const QModelIndex &parent) const
         return false;
     }
     WatchVar* item = static_cast<WatchVar*>(parent.internalPointer());
+    if (mFetchingVars.contains(item->name))
+        return false;
     return item->numChild>item->children.count() || item->hasMore;
 }
 
@@ -2217,7 +2616,7 @@ bool WatchModel::hasChildren(const QModelIndex &parent) const
         return true;
     }
     WatchVar* item = static_cast<WatchVar*>(parent.internalPointer());
-    return item->numChild>0;
+    return item->numChild>0 || item->hasMore;
 }
 
 RegisterModel::RegisterModel(QObject *parent):QAbstractTableModel(parent)
@@ -2411,65 +2810,223 @@ void DebugTarget::run()
     }
 }
 
+DisassemblyCache::DisassemblyCache()
+{
+
+}
+
+PDisassemblyFunction DisassemblyCache::find(qulonglong address, bool intelStyle, bool blendMode) const
+{
+    auto it = mFunctions.upperBound(address);
+    if (it == mFunctions.begin())
+        return PDisassemblyFunction();
+    --it;
+    PDisassemblyFunction function = it.value();
+    if (address > function->endAddress
+            || function->intelStyle != intelStyle
+            || function->blendMode != blendMode)
+        return PDisassemblyFunction();
+    return function;
+}
+
+void DisassemblyCache::add(PDisassemblyFunction function)
+{
+    mFunctions.insert(function->startAddress,function);
+}
+
+void DisassemblyCache::setBinary(const QString &filename)
+{
+    //disassembly of an old binary is useless
+    QDateTime modified = QFileInfo(filename).lastModified();
+    if (filename != mBinary || modified != mBinaryModified) {
+        clear();
+        mBinary = filename;
+        mBinaryModified = modified;
+    }
+}
+
+void DisassemblyCache::clear()
+{
+    mFunctions.clear();
+}
+
+PDisassemblyFunction DisassemblyCache::parse(const QStringList &lines, bool intelStyle, bool blendMode, bool &isCurrent)
+{
+    static QRegularExpression instructionReg("^(=>)?\\s+0x([0-9a-fA-F]+)\\s");
+    isCurrent = false;
+    PDisassemblyFunction function = std::make_shared<DisassemblyFunction>();
+    function->startAddress = std::numeric_limits<qulonglong>::max();
+    function->endAddress = 0;
+    function->intelStyle = intelStyle;
+    function->blendMode = blendMode;
+    foreach (const QString& line, lines) {
+        qulonglong address = 0;
+        QRegularExpressionMatch match = instructionReg.match(line);
+        if (match.hasMatch()) {
+            address = match.captured(2).toULongLong(nullptr,16);
+            function->startAddress = std::min(function->startAddress,address);
+            function->endAddress = std::max(function->endAddress,address);
+        }
+        //the current instruction is highlighted by the dialog
+        if (line.startsWith("=>")) {
+            isCurrent = true;
+            function->lines.append("  "+line.mid(2));
+        } else {
+            function->lines.append(line);
+        }
+        function->lineAddresses.append(address);
+    }
+    if (function->endAddress == 0)
+        return PDisassemblyFunction();
+    return function;
+}
+
 MemoryModel::MemoryModel(int dataPerLine, QObject *parent):
     QAbstractTableModel(parent),
     mDataPerLine(dataPerLine),
-    mStartAddress(0)
+    mStartAddress(0),
+    mWindowStart(0),
+    mLocated(false),
+    mFirstVisibleRow(0),
+    mLastVisibleRow(-1)
 {
 }
 
-void MemoryModel::updateMemory(const QStringList &value)
+void MemoryModel::locate(qulonglong address)
 {
-    QRegExp delimiter("(\\s+)");
-    QList<PMemoryLine> newModel;
-    for (int i=0;i<value.length();i++) {
-        QString line = value[i].trimmed();
-        QStringList dataLst = line.split(delimiter,QString::SkipEmptyParts);
-        PMemoryLine memoryLine = std::make_shared<MemoryLine>();
-        memoryLine->startAddress = -1;
-        if (dataLst.length()>0) {
-            memoryLine->startAddress = stringToHex(dataLst[0],0);
-            for (int j=1;j<dataLst.length();j++) {
-                qulonglong data = stringToHex(dataLst[j],-1);
-                if (data>=0)
-                    memoryLine->datas.append((unsigned char)data);
+    beginResetModel();
+    mStartAddress = address;
+    //the window is centered at the page containing the address
+    qulonglong pageAddress = address - address % MEMORY_PAGE_SIZE;
+    if (pageAddress < MEMORY_VIEW_WINDOW_SIZE/2) {
+        mWindowStart = 0;
+    } else {
+        qulonglong lastWindowStart = std::numeric_limits<qulonglong>::max() - MEMORY_VIEW_WINDOW_SIZE + 1;
+        mWindowStart = std::min(pageAddress - MEMORY_VIEW_WINDOW_SIZE/2, lastWindowStart);
+    }
+    mLocated = true;
+    mPages.clear();
+    mFirstVisibleRow = 0;
+    mLastVisibleRow = -1;
+    endResetModel();
+}
+
+void MemoryModel::updateMemory(qulonglong address, const QByteArray &datas)
+{
+    if (!mLocated || datas.isEmpty())
+        return;
+    int firstRow = rowOf(address);
+    int lastRow = rowOf(address+datas.length()-1);
+    if (firstRow<0 && lastRow<0)
+        return;
+    PMemoryPage currentPage;
+    for (int i=0;i<datas.length();i++) {
+        qulonglong dataAddress = address+i;
+        int offset = dataAddress % MEMORY_PAGE_SIZE;
+        if (!currentPage || offset == 0) {
+            currentPage = page(dataAddress - offset);
+            if (!currentPage->upToDate) {
+                currentPage->validDatas.fill(false);
+                currentPage->changedDatas.fill(false);
+                currentPage->upToDate = true;
             }
         }
-        newModel.append(memoryLine);
+        currentPage->datas[offset] = datas[i];
+        currentPage->validDatas.setBit(offset);
+        currentPage->changedDatas.setBit(offset,
+                    currentPage->oldValidDatas.testBit(offset)
+                    && currentPage->oldDatas[offset]!=datas[i]);
     }
-    if (newModel.count()>0 && newModel.count()== mLines.count() &&
-            newModel[0]->startAddress == mLines[0]->startAddress) {
-        for (int i=0;i<newModel.count();i++) {
-            PMemoryLine newLine = newModel[i];
-            PMemoryLine oldLine = mLines[i];
-            for (int j=0;j<newLine->datas.count();j++) {
-                if (j>=oldLine->datas.count())
-                    break;
-                if (newLine->datas[j]!=oldLine->datas[j])
-                    newLine->changedDatas.insert(j);
-            }
+    if (firstRow<0)
+        firstRow = 0;
+    if (lastRow<0)
+        lastRow = rowCount(QModelIndex())-1;
+    emit dataChanged(createIndex(firstRow,0),
+                     createIndex(lastRow,mDataPerLine-1));
+}
+
+void MemoryModel::setUnreadable(qulonglong address, int length)
+{
+    if (!mLocated || length<=0)
+        return;
+    //the pages are read, there are just no valid datas in them
+    qulonglong lastAddress = address+length-1;
+    qulonglong pageAddress = address - address % MEMORY_PAGE_SIZE;
+    while (true) {
+        PMemoryPage memoryPage = page(pageAddress);
+        memoryPage->validDatas.fill(false);
+        memoryPage->changedDatas.fill(false);
+        memoryPage->upToDate = true;
+        memoryPage->requested = false;
+        if (lastAddress - pageAddress < MEMORY_PAGE_SIZE)
+            break;
+        pageAddress += MEMORY_PAGE_SIZE;
+    }
+    int firstRow = rowOf(address);
+    int lastRow = rowOf(lastAddress);
+    if (firstRow<0 && lastRow<0)
+        return;
+    if (firstRow<0)
+        firstRow = 0;
+    if (lastRow<0)
+        lastRow = rowCount(QModelIndex())-1;
+    emit dataChanged(createIndex(firstRow,0),
+                     createIndex(lastRow,mDataPerLine-1));
+}
+
+void MemoryModel::setVisibleRows(int firstRow, int lastRow)
+{
+    mFirstVisibleRow = firstRow;
+    mLastVisibleRow = lastRow;
+    fetchVisiblePages();
+}
+
+void MemoryModel::fetchVisiblePages()
+{
+    if (!mLocated)
+        return;
+    int rowsPerPage = MEMORY_PAGE_SIZE / mDataPerLine;
+    for (int row = mFirstVisibleRow - mFirstVisibleRow % rowsPerPage;
+         row<=mLastVisibleRow;
+         row+=rowsPerPage) {
+        qulonglong pageAddress = rowAddress(row);
+        PMemoryPage memoryPage = page(pageAddress);
+        if (!memoryPage->upToDate && !memoryPage->requested) {
+            memoryPage->requested = true;
+            emit fetchMemory(pageAddress, MEMORY_PAGE_SIZE);
         }
-        mLines = newModel;
-        emit dataChanged(createIndex(0,0),
-                         createIndex(mLines.count()-1,mDataPerLine-1));
-    } else {
-        beginResetModel();
-        mLines = newModel;
-        endResetModel();
     }
-    if (mLines.count()>0) {
-        mStartAddress = mLines[0]->startAddress;
-    } else {
-        mStartAddress = 0;
+}
+
+void MemoryModel::invalidate()
+{
+    //keep the datas of the last stop, to find changed datas
+    foreach (const PMemoryPage& memoryPage, mPages) {
+        if (memoryPage->upToDate) {
+            memoryPage->oldDatas = memoryPage->datas;
+            memoryPage->oldValidDatas = memoryPage->validDatas;
+        }
+        memoryPage->upToDate = false;
+        memoryPage->requested = false;
     }
- }
+}
 
-int MemoryModel::rowCount(const QModelIndex &parent) const
+int MemoryModel::rowOf(qulonglong address) const
 {
-    return mLines.count();
+    if (!mLocated || address<mWindowStart
+            || address - mWindowStart >= MEMORY_VIEW_WINDOW_SIZE)
+        return -1;
+    return (address - mWindowStart) / mDataPerLine;
 }
 
-int MemoryModel::columnCount(const QModelIndex &parent) const
+int MemoryModel::rowCount(const QModelIndex &) const
+{
+    if (!mLocated)
+        return 0;
+    return MEMORY_VIEW_WINDOW_SIZE / mDataPerLine;
+}
+
+int MemoryModel::columnCount(const QModelIndex &) const
 {
     return mDataPerLine;
 }
@@ -2478,24 +3035,34 @@ QVariant MemoryModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid())
         return QVariant();
-    if (index.row()<0 || index.row()>=mLines.count())
+    if (index.row()<0 || index.row()>=rowCount(QModelIndex()))
         return QVariant();
-    PMemoryLine line = mLines[index.row()];
     int col = index.column();
-    if (col<0  || col>=line->datas.count())
+    if (col<0  || col>=mDataPerLine)
+        return QVariant();
+    qulonglong address = rowAddress(index.row())+col;
+    int offset = address % MEMORY_PAGE_SIZE;
+    PMemoryPage memoryPage = mPages.value(address - offset,PMemoryPage());
+    if (!memoryPage)
         return QVariant();
-    if (role == Qt::DisplayRole)
-        return QString("%1").arg(line->datas[col],2,16,QChar('0'));
+    if (role == Qt::DisplayRole) {
+        if (memoryPage->validDatas.testBit(offset))
+            return QString("%1").arg((unsigned char)memoryPage->datas[offset],2,16,QChar('0'));
+        if (memoryPage->upToDate)
+            return "??";
+    } else if (role == Qt::ForegroundRole) {
+        if (memoryPage->changedDatas.testBit(offset))
+            return pMainWindow->palette().color(QPalette::Highlight);
+    }
     return QVariant();
 }
 
 QVariant MemoryModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation == Qt::Vertical && role ==  Qt::DisplayRole) {
-        if (section<0 || section>=mLines.count())
+        if (section<0 || section>=rowCount(QModelIndex()))
             return QVariant();
-        PMemoryLine line = mLines[section];
-        return QString("0x%1").arg(line->startAddress,0,16,QChar('0'));
+        return QString("0x%1").arg(rowAddress(section),0,16,QChar('0'));
     }
     return QVariant();
 }
@@ -2504,27 +3071,31 @@ bool MemoryModel::setData(const QModelIndex &index, const QVariant &value, int r
 {
     if (!index.isValid())
         return false;
-    if (index.row()<0 || index.row()>=mLines.count())
+    if (index.row()<0 || index.row()>=rowCount(QModelIndex()))
         return false;
-    PMemoryLine line = mLines[index.row()];
     int col = index.column();
-    if (col<0  || col>=line->datas.count())
+    if (col<0  || col>=mDataPerLine)
         return false;
-    if (role == Qt::EditRole && mStartAddress>0) {
+    if (role == Qt::EditRole && mLocated) {
         bool ok;
         unsigned char val = ("0x"+value.toString()).toUInt(&ok,16);
         if (!ok || val>255)
             return false;
-        emit setMemoryData(mStartAddress+mDataPerLine*index.row()+col,val);
+        qulonglong address = rowAddress(index.row())+col;
+        //read the page again after it's written
+        PMemoryPage memoryPage = page(address - address % MEMORY_PAGE_SIZE);
+        memoryPage->upToDate = false;
+        memoryPage->requested = false;
+        emit setMemoryData(address,val);
         return true;
     }
     return false;
 }
 
-Qt::ItemFlags MemoryModel::flags(const QModelIndex &index) const
+Qt::ItemFlags MemoryModel::flags(const QModelIndex &) const
 {
     Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
-    if (mStartAddress!=0)
+    if (mLocated)
         flags |= Qt::ItemIsEditable;
     return flags;
 }
@@ -2536,6 +3107,34 @@ qulonglong MemoryModel::startAddress() const
 
 void MemoryModel::reset()
 {
+    beginResetModel();
     mStartAddress=0;
-    mLines.clear();
+    mWindowStart=0;
+    mLocated=false;
+    mFirstVisibleRow=0;
+    mLastVisibleRow=-1;
+    mPages.clear();
+    endResetModel();
+}
+
+qulonglong MemoryModel::rowAddress(int row) const
+{
+    return mWindowStart + (qulonglong)row * mDataPerLine;
+}
+
+PMemoryPage MemoryModel::page(qulonglong pageAddress)
+{
+    PMemoryPage memoryPage = mPages.value(pageAddress,PMemoryPage());
+    if (!memoryPage) {
+        memoryPage = std::make_shared<MemoryPage>();
+        memoryPage->datas = QByteArray(MEMORY_PAGE_SIZE,0);
+        memoryPage->validDatas = QBitArray(MEMORY_PAGE_SIZE);
+        memoryPage->oldDatas = QByteArray(MEMORY_PAGE_SIZE,0);
+        memoryPage->oldValidDatas = QBitArray(MEMORY_PAGE_SIZE);
+        memoryPage->changedDatas = QBitArray(MEMORY_PAGE_SIZE);
+        memoryPage->upToDate = false;
+        memoryPage->requested = false;
+        mPages.insert(pageAddress,memoryPage);
+    }
+    return memoryPage;
 }
@@ -18,6 +18,8 @@
 #define DEBUGGER_H
 
 #include <QAbstractTableModel>
+#include <QBitArray>
+#include <QDateTime>
 #include <QList>
 #include <QList>
 #include <QMap>
@@ -33,6 +35,13 @@
 #include <memory>
 #include "gdbmiresultparser.h"
 
+// children of a watch var are listed from gdb in pages of this size
+#define WATCH_VAR_CHILDREN_PAGE_SIZE 100
+// memory view reads inferior memory in aligned pages of this size
+#define MEMORY_PAGE_SIZE 256
+// size of the address range shown in the memory view
+#define MEMORY_VIEW_WINDOW_SIZE (64*1024)
+
 enum class DebugCommandSource {
     Console,
     HeartBeat,
@@ -63,7 +72,8 @@ enum class BreakpointType {
     Breakpoint,
     Watchpoint,
     ReadWatchpoint,
-    WriteWatchpoint
+    WriteWatchpoint,
+    Tracepoint // log and continue, without stopping the inferior
 };
 
 struct Breakpoint {
@@ -75,6 +85,8 @@ struct Breakpoint {
     QString condition;
     bool enabled;
     BreakpointType breakpointType;
+    QString logMessage; // dprintf format and arguments of tracepoint
+    int hitCount;
 };
 
 using PBreakpoint = std::shared_ptr<Breakpoint>;
@@ -118,12 +130,14 @@ public:
     void clear();
     void removeBreakpoint(int index);
     PBreakpoint setBreakPointCondition(int index, const QString& condition);
+    PBreakpoint setBreakPointLogMessage(int index, const QString& logMessage);
     const QList<PBreakpoint>& breakpoints() const;
     PBreakpoint breakpoint(int index) const;
     void save(const QString& filename);
     void load(const QString& filename);
 public slots:
     void updateBreakpointNumber(const QString& filename, int line, int number);
+    void updateBreakpointHitCount(int number, int hitCount);
     void invalidateAllBreakpointNumbers(); // call this when gdb is stopped
     void onFileDeleteLines(const QString& filename, int startLine, int count);
     void onFileInsertLines(const QString& filename, int startLine, int count);
@@ -176,6 +190,7 @@ public:
     void beginUpdate();
     void endUpdate();
     void notifyUpdated(PWatchVar var);
+    void releaseVarChildren(const QModelIndex& index);
     void save(const QString& filename);
     void load(const QString& filename);
 signals:
@@ -187,7 +202,8 @@ public  slots:
                     const QString& value,
                     const QString& type,
                     bool hasMore);
-    void prepareVarChildren(const QString& parentName, int numChild, bool hasMore);
+    void prepareVarChildren(const QString& parentName, int from, bool hasMore);
+    void cancelFetchVarChildren(const QString& parentName);
     void addVarChild(const QString& parentName, const QString& name,
                      const QString& exp, int numChild,
                      const QString& value, const QString& type,
@@ -197,13 +213,23 @@ public  slots:
                          const QString& newType, int newNumChildren,
                          bool hasMore);
 signals:
-    void fetchChildren(const QString& name);
+    void fetchChildren(const QString& name, int from, int to);
 private:
     QModelIndex index(PWatchVar var) const;
     QModelIndex index(WatchVar* pVar) const;
+    void removeVarIndexes(WatchVar* var);
+    void requestVarChildren(const QString& name, int from, int to);
+    bool takeVarChildrenReply(const QString& name);
+    void dropPendingVarChildren(const QString& name);
 private:
     QList<PWatchVar> mWatchVars;
     QHash<QString,PWatchVar> mVarIndex;
+    QSet<QString> mFetchingVars;
+    // generations of the -var-list-children requests waiting for a reply, by var name
+    QHash<QString,QQueue<int>> mPendingVarChildren;
+    // bumped when a var's children are released, replies of older generations are dropped
+    QHash<QString,int> mVarGenerations;
+    QString mDroppedReplyParent; // children of this reply are dropped
     int mUpdateCount;
 
     // QAbstractItemModel interface
@@ -212,25 +238,36 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 };
 
-struct MemoryLine {
-    uintptr_t startAddress;
-    QList<unsigned char> datas;
-    QSet<int> changedDatas;
+struct MemoryPage {
+    QByteArray datas;
+    QBitArray validDatas;
+    QByteArray oldDatas; // datas when the inferior continued
+    QBitArray oldValidDatas;
+    QBitArray changedDatas;
+    bool upToDate; // read after the inferior stopped
+    bool requested;
 };
 
-using PMemoryLine = std::shared_ptr<MemoryLine>;
+using PMemoryPage = std::shared_ptr<MemoryPage>;
 
 class MemoryModel: public QAbstractTableModel{
     Q_OBJECT
 public:
     explicit MemoryModel(int dataPerLine,QObject* parent=nullptr);
 
-    void updateMemory(const QStringList& value);
+    void locate(qulonglong address);
+    void updateMemory(qulonglong address, const QByteArray& datas);
+    void setUnreadable(qulonglong address, int length);
+    void setVisibleRows(int firstRow, int lastRow);
+    void fetchVisiblePages();
+    void invalidate();
+    int rowOf(qulonglong address) const;
     qulonglong startAddress() const;
     void reset();
     // QAbstractItemModel interface
 signals:
     void setMemoryData(qlonglong address, unsigned char data);
+    void fetchMemory(qulonglong address, int length);
 public:
     int rowCount(const QModelIndex &parent) const override;
     int columnCount(const QModelIndex &parent) const override;
@@ -239,12 +276,46 @@ public:
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 
+private:
+    qulonglong rowAddress(int row) const;
+    PMemoryPage page(qulonglong pageAddress);
 private:
     int mDataPerLine;
-    QList<PMemoryLine> mLines;
     qulonglong mStartAddress;
+    qulonglong mWindowStart;
+    bool mLocated;
+    int mFirstVisibleRow;
+    int mLastVisibleRow;
+    QHash<qulonglong,PMemoryPage> mPages;
+};
+
+
+struct DisassemblyFunction {
+    qulonglong startAddress;
+    qulonglong endAddress;
+    QString filename;
+    QString funcName;
+    QStringList lines;
+    QList<qulonglong> lineAddresses; // 0 for lines that are not instructions
+    bool intelStyle;
+    bool blendMode;
 };
 
+using PDisassemblyFunction = std::shared_ptr<DisassemblyFunction>;
+
+class DisassemblyCache {
+public:
+    explicit DisassemblyCache();
+    PDisassemblyFunction find(qulonglong address, bool intelStyle, bool blendMode) const;
+    void add(PDisassemblyFunction function);
+    void setBinary(const QString& filename);
+    void clear();
+    static PDisassemblyFunction parse(const QStringList& lines, bool intelStyle, bool blendMode, bool& isCurrent);
+private:
+    QMap<qulonglong,PDisassemblyFunction> mFunctions; //key is the start address
+    QString mBinary;
+    QDateTime mBinaryModified;
+};
 
 class DebugReader;
 class DebugTarget;
@@ -277,14 +348,19 @@ public:
     PBreakpoint breakpointAt(int line, const QString& filename, int &index);
     PBreakpoint breakpointAt(int line, const Editor* editor, int &index);
     void setBreakPointCondition(int index, const QString& condition);
+    void setBreakPointLogMessage(int index, const QString& logMessage);
     void sendAllBreakpointsToDebugger();
 
+    //disassembly
+    void requestDisassembly(bool intelStyle, bool blendMode);
+
     //watch vars
     void addWatchVar(const QString& expression);
     void modifyWatchVarExpression(const QString& oldExpr, const QString& newExpr);
 
     void removeWatchVars(bool deleteparent);
     void removeWatchVar(const QModelIndex& index);
+    void collapseWatchVar(const QModelIndex& index);
     void sendAllWatchVarsToDebugger();
     PWatchVar findWatchVar(const QString& expression);
 //    void notifyWatchVarUpdated(PWatchVar var);
@@ -304,7 +380,6 @@ public:
 
 signals:
     void evalValueReady(const QString& s);
-    void memoryExamineReady(const QStringList& s);
     void localsReady(const QStringList& s);
 public slots:
     void stop();
@@ -316,12 +391,13 @@ private:
     void sendBreakpointCommand(PBreakpoint breakpoint);
     void sendClearBreakpointCommand(int index);
     void sendClearBreakpointCommand(PBreakpoint breakpoint);
+    void prefetchDisassembly(qulonglong address);
 
 private slots:
     void syncFinishedParsing();
     void setMemoryData(qulonglong address, unsigned char data);
     void setWatchVarValue(const QString& name, const QString& value);
-    void updateMemory(const QStringList& value);
+    void fetchMemory(qulonglong address, int length);
     void updateEval(const QString& value);
     void updateDisassembly(const QString& file, const QString& func,const QStringList& value);
     void onChangeDebugConsoleLastline(const QString& text);
@@ -329,7 +405,8 @@ private slots:
     void updateRegisterNames(const QStringList& registerNames);
     void updateRegisterValues(const QHash<int,QString>& values);
     void refreshWatchVars();
-    void fetchVarChildren(const QString& varName);
+    void fetchVarChildren(const QString& varName, int from, int to);
+    void onTracepointInsertFailed(const QString& filename, int line, const QString& message);
 private:
     bool mExecuting;
     bool mCommandChanged;
@@ -341,6 +418,9 @@ private:
     DebugReader *mReader;
     DebugTarget *mTarget;
     int mLeftPageIndexBackup;
+    DisassemblyCache mDisassemblyCache;
+    bool mDisassemblyIntelStyle;
+    bool mDisassemblyBlendMode;
 };
 
 class DebugTarget: public QThread {
@@ -422,6 +502,12 @@ public:
 
     const QString &signalMeaning() const;
 
+    qulonglong currentAddress() const;
+
+    const QString &currentFile() const;
+
+    const QString &currentFunc() const;
+
 signals:
     void parseStarted();
     void invalidateAllVars();
@@ -433,11 +519,15 @@ signals:
     void cmdFinished();
 
     void breakpointInfoGetted(const QString& filename, int line, int number);
+    void breakpointHitCountUpdated(int number, int hitCount);
+    void tracepointInsertFailed(const QString& filename, int line, const QString& message);
     void inferiorContinued();
     void inferiorStopped(const QString& filename, int line, bool setFocus);
     void localsUpdated(const QStringList& localsValue);
     void evalUpdated(const QString& value);
-    void memoryUpdated(const QStringList& memoryValues);
+    void memoryLocated(qulonglong address);
+    void memoryUpdated(qulonglong address, const QByteArray& datas);
+    void memoryReadFailed(qulonglong address, int length);
     void disassemblyUpdate(const QString& filename, const QString& funcName, const QStringList& result);
     void registerNamesUpdated(const QStringList& registerNames);
     void registerValuesUpdated(const QHash<int,QString>& values);
@@ -447,7 +537,8 @@ signals:
                     const QString& value,
                     const QString& type,
                     bool hasMore);
-    void prepareVarChildren(const QString& parentName,int numChild, bool hasMore);
+    void prepareVarChildren(const QString& parentName,int from, bool hasMore);
+    void listVarChildrenFailed(const QString& parentName);
     void addVarChild(const QString& parentName, const QString& name,
                      const QString& exp, int numChild,
                      const QString& value, const QString& type,
@@ -467,15 +558,18 @@ private:
     void handleStack(const QList<GDBMIResultParser::ParseValue> & stack);
     void handleLocalVariables(const QList<GDBMIResultParser::ParseValue> & variables);
     void handleEvaluation(const QString& value);
-    void handleMemory(const QList<GDBMIResultParser::ParseValue> & rows);
+    void handleMemory(const GDBMIResultParser::ParseObject& multiVars);
+    void handleMemoryBytes(const QList<GDBMIResultParser::ParseValue> & blocks);
     void handleRegisterNames(const QList<GDBMIResultParser::ParseValue> & names);
     void handleRegisterValue(const QList<GDBMIResultParser::ParseValue> & values);
     void handleCreateVar(const GDBMIResultParser::ParseObject& multiVars);
     void handleListVarChildren(const GDBMIResultParser::ParseObject& multiVars);
+    QString listVarChildrenParentName() const;
     void handleUpdateVarValue(const QList<GDBMIResultParser::ParseValue> &changes);
     void processConsoleOutput(const QByteArray& line);
     void processResult(const QByteArray& result);
     void processExecAsyncRecord(const QByteArray& line);
+    void processNotifyAsyncRecord(const QByteArray& line);
     void processError(const QByteArray& errorLine);
     void processResultRecord(const QByteArray& line);
     void processDebugOutput(const QByteArray& debugOutput);
@@ -511,11 +605,12 @@ private:
     bool mReceivedSFWarning;
 
     int mCurrentLine;
-    int mCurrentAddress;
+    qulonglong mCurrentAddress;
     QString mCurrentFunc;
     QString mCurrentFile;
     QStringList mConsoleOutput;
     QStringList mFullOutput;
+    QHash<int,int> mBreakpointHitCounts;
     bool mStop;
     // QThread interface
 protected:
@@ -49,6 +49,7 @@
 #include "editorlist.h"
 #include <QDebug>
 #include "project.h"
+#include "undojournal.h"
 
 using namespace std;
 
@@ -94,14 +95,23 @@ Editor::Editor(QWidget *parent, const QString& filename,
   mCurrentHighlightedWord(),
   mSaving(false)
 {
+    mLargeFileMode = false;
     mCurrentLineModified = false;
     mUseCppSyntax = pSettings->editor().defaultFileCpp();
+    mTodoLineCache = std::make_shared<TodoLineCache>(lines());
+    mRecoveryJournal = std::make_shared<RecoveryJournal>(lines());
     if (mFilename.isEmpty()) {
         mFilename = tr("untitled")+QString("%1").arg(getNewFileNumber());
     }
+    if (isNew)
+        mRecoveryJournal->resetUntitledBase(mFilename);
     QFileInfo fileInfo(mFilename);
     PSynHighlighter highlighter;
     if (!isNew) {
+        mLargeFileMode = pSettings->editor().enableLargeFileMode()
+                && fileInfo.size() > (qint64)pSettings->editor().largeFileSize()*1024*1024;
+        lines()->setKeepFileMapped(mLargeFileMode);
+        setLazyRangeScan(mLargeFileMode);
         loadFile();
         highlighter = highlighterManager.getHighlighter(mFilename);
     } else {
@@ -114,7 +124,7 @@ Editor::Editor(QWidget *parent, const QString& filename,
 
     if (highlighter) {
         setHighlighter(highlighter);
-        setUseCodeFolding(true);
+        setUseCodeFolding(!mLargeFileMode);
     } else {
         setUseCodeFolding(false);
     }
@@ -123,6 +133,8 @@ Editor::Editor(QWidget *parent, const QString& filename,
         mParser = pMainWindow->project()->cppParser();
     } else {
         initParser();
+        if (mLargeFileMode)
+            mParser->setEnabled(false);
     }
 
     if (pSettings->editor().readOnlySytemHeader()
@@ -131,9 +143,6 @@ Editor::Editor(QWidget *parent, const QString& filename,
         setReadOnly(true);
     }
 
-    mCompletionPopup = pMainWindow->completionPopup();
-    mHeaderCompletionPopup = pMainWindow->headerCompletionPopup();
-
     applySettings();
     applyColorScheme(pSettings->editor().colorScheme());
 
@@ -172,6 +181,10 @@ Editor::Editor(QWidget *parent, const QString& filename,
     if (!isNew && parentPageControl!=nullptr) {
         resetBookmarks();
         resetBreakpoints();
+        if (pSettings->editor().persistentUndo() && !mLargeFileMode) {
+            UndoJournal journal(mFilename, (qint64)pSettings->editor().undoJournalSize()*1024*1024);
+            journal.restore(this);
+        }
     }
     mStatementColors = pMainWindow->statementColors();
     if (mParentPageControl!=nullptr) {
@@ -194,6 +207,7 @@ Editor::~Editor() {
 void Editor::loadFile(QString filename) {
     if (filename.isEmpty()) {
         this->lines()->loadFromFile(mFilename,mEncodingOption,mFileEncoding);
+        mRecoveryJournal->resetBase(mFilename);
     } else {
         filename = QFileInfo(filename).absoluteFilePath();
         this->lines()->loadFromFile(filename,mEncodingOption,mFileEncoding);
@@ -253,6 +267,7 @@ bool Editor::save(bool force, bool doReparse) {
         pMainWindow->fileSystemWatcher()->addPath(mFilename);
         setModified(false);
         mIsNew = false;
+        mRecoveryJournal->resetBase(mFilename);
         this->updateCaption();
     }  catch (SaveException& exception) {
         if (!force) {
@@ -333,6 +348,7 @@ bool Editor::saveAs(const QString &name, bool fromProject){
         saveFile(mFilename);
         mIsNew = false;
         setModified(false);
+        mRecoveryJournal->resetBase(mFilename);
         this->updateCaption();
     }  catch (SaveException& exception) {
         QMessageBox::critical(pMainWindow,tr("Error"),
@@ -354,7 +370,7 @@ bool Editor::saveAs(const QString &name, bool fromProject){
     //update (reassign highlighter)
     PSynHighlighter newHighlighter = HighlighterManager().getHighlighter(mFilename);
     if (newHighlighter) {
-        setUseCodeFolding(true);
+        setUseCodeFolding(!mLargeFileMode);
     } else {
         setUseCodeFolding(false);
     }
@@ -537,7 +553,7 @@ void Editor::focusOutEvent(QFocusEvent *event)
     //pMainWindow->updateClassBrowserForEditor(nullptr);
     pMainWindow->updateStatusbarForLineCol();
     pMainWindow->updateForStatusbarModeInfo();
-    pMainWindow->functionTip()->hide();
+    pMainWindow->hideFunctionTip();
 }
 
 void Editor::keyPressEvent(QKeyEvent *event)
@@ -643,13 +659,13 @@ void Editor::keyPressEvent(QKeyEvent *event)
             invalidateLine(caretY());
             clearUserCodeInTabStops();
         }
-        pMainWindow->functionTip()->hide();
+        pMainWindow->hideFunctionTip();
         return;
     case Qt::Key_Tab:
         tab();
         return;
     case Qt::Key_Up:
-        if (pMainWindow->functionTip()->isVisible()) {
+        if (pMainWindow->isFunctionTipVisible()) {
             handled = true;
             pMainWindow->functionTip()->previousTip();
         } else {
@@ -658,7 +674,7 @@ void Editor::keyPressEvent(QKeyEvent *event)
         }
         return;
     case Qt::Key_Down:
-        if (pMainWindow->functionTip()->isVisible()) {
+        if (pMainWindow->isFunctionTipVisible()) {
             handled = true;
             pMainWindow->functionTip()->nextTip();
         } else {
@@ -959,9 +975,9 @@ bool Editor::event(QEvent *event)
 {
     if ((event->type() == QEvent::HoverEnter || event->type() == QEvent::HoverMove)
             && pSettings->editor().enableTooltips()
-            && !pMainWindow->completionPopup()->isVisible()
-            && !pMainWindow->functionTip()->isVisible()
-            && !pMainWindow->headerCompletionPopup()->isVisible()) {
+            && !pMainWindow->isCompletionPopupVisible()
+            && !pMainWindow->isFunctionTipVisible()
+            && !pMainWindow->isHeaderCompletionPopupVisible()) {
         QHoverEvent *helpEvent = static_cast<QHoverEvent *>(event);
         BufferCoord p;
         TipType reason = getTipType(helpEvent->pos(),p);
@@ -995,8 +1011,8 @@ bool Editor::event(QEvent *event)
             if (pMainWindow->debugger()->executing() && !pMainWindow->debugger()->inferiorRunning())
                 s = getWordAtPosition(this,p, pBeginPos,pEndPos, WordPurpose::wpEvaluation); // debugging
             else if (//devEditor.ParserHints and
-                     !mCompletionPopup->isVisible()
-                     && !mHeaderCompletionPopup->isVisible()) {
+                     !pMainWindow->isCompletionPopupVisible()
+                     && !pMainWindow->isHeaderCompletionPopupVisible()) {
                 expression = getExpressionAtPosition(p);
                 s = expression.join(""); // information during coding
             }
@@ -1040,16 +1056,16 @@ bool Editor::event(QEvent *event)
                 if (pSettings->editor().enableHeaderToolTips())
                     hint = getFileHint(s);
             } else if (//devEditor.ParserHints and
-                     !mCompletionPopup->isVisible()
-                     && !mHeaderCompletionPopup->isVisible()) {
+                     !pMainWindow->isCompletionPopupVisible()
+                     && !pMainWindow->isHeaderCompletionPopupVisible()) {
                 if (pSettings->editor().enableIdentifierToolTips())
                     hint = getParserHint(QStringList(),s,p.Line);
             }
             break;
         case TipType::Identifier:
         case TipType::Selection:
-            if (!mCompletionPopup->isVisible()
-                    && !mHeaderCompletionPopup->isVisible()) {
+            if (!pMainWindow->isCompletionPopupVisible()
+                    && !pMainWindow->isHeaderCompletionPopupVisible()) {
                 if (pMainWindow->debugger()->executing()
                         && (pSettings->editor().enableDebugTooltips())) {
                     showDebugHint(s,p.Line);
@@ -1074,8 +1090,8 @@ bool Editor::event(QEvent *event)
             } else if (cursor() == Qt::PointingHandCursor) {
                 updateMouseCursor();
             }
-            if (pMainWindow->functionTip()->isVisible()) {
-                pMainWindow->functionTip()->hide();
+            if (pMainWindow->isFunctionTipVisible()) {
+                pMainWindow->hideFunctionTip();
             }
             QToolTip::showText(mapToGlobal(helpEvent->pos()),hint);
             event->ignore();
@@ -1140,7 +1156,7 @@ void Editor::inputMethodEvent(QInputMethodEvent *event)
     QString s = event->commitString();
     if (s.isEmpty())
         return;
-    if (pMainWindow->completionPopup()->isVisible()) {
+    if (pMainWindow->isCompletionPopupVisible()) {
         onCompletionInputMethod(event);
         return;
     } else {
@@ -1177,12 +1193,7 @@ void Editor::inputMethodEvent(QInputMethodEvent *event)
 
 void Editor::closeEvent(QCloseEvent *)
 {
-    if (mHeaderCompletionPopup)
-        mHeaderCompletionPopup->hide();
-    if (mCompletionPopup)
-        mCompletionPopup->hide();
-    if (pMainWindow->functionTip())
-        pMainWindow->functionTip()->hide();
+    pMainWindow->hideCompletionPopups();
 }
 
 void Editor::showEvent(QShowEvent */*event*/)
@@ -2257,7 +2268,7 @@ bool Editor::handleGlobalIncludeSkip()
 
 bool Editor::handleCodeCompletion(QChar key)
 {
-    if (!mCompletionPopup->isEnabled())
+    if (!pMainWindow->completionPopup()->isEnabled())
         return false;
     if (mParser) {
         switch(key.unicode()) {
@@ -2428,6 +2439,8 @@ void Editor::reparse()
 {
     if (!highlighter())
         return;
+    if (mLargeFileMode)
+        return;
     if (highlighter()->language() != SynHighlighterLanguage::Cpp
              && highlighter()->language() != SynHighlighterLanguage::GLSL)
         return;
@@ -2438,7 +2451,9 @@ void Editor::reparseTodo()
 {
     if (!highlighter())
         return;
-    pMainWindow->todoParser()->parseFile(mFilename);
+    if (mLargeFileMode)
+        return;
+    pMainWindow->todoParser()->parseEditor(this);
 }
 
 void Editor::insertString(const QString &value, bool moveCursor)
@@ -2631,8 +2646,8 @@ void Editor::exportAsHTML(const QString &htmlFilename)
 
 void Editor::showCompletion(const QString& preWord,bool autoComplete)
 {
-    if (pMainWindow->functionTip()->isVisible()) {
-        pMainWindow->functionTip()->hide();
+    if (pMainWindow->isFunctionTipVisible()) {
+        pMainWindow->hideFunctionTip();
     }
     if (!pSettings->codeCompletion().enabled())
         return;
@@ -2642,7 +2657,7 @@ void Editor::showCompletion(const QString& preWord,bool autoComplete)
     if (!highlighter())
         return;
 
-    if (mCompletionPopup->isVisible()) // already in search, don't do it again
+    if (pMainWindow->isCompletionPopupVisible()) // already in search, don't do it again
         return;
 
     QString word="";
@@ -2678,35 +2693,35 @@ void Editor::showCompletion(const QString& preWord,bool autoComplete)
     // Position it at the top of the next line
     QPoint p = rowColumnToPixels(displayXY());
     p+=QPoint(0,textHeight()+2);
-    mCompletionPopup->move(mapToGlobal(p));
+    pMainWindow->completionPopup()->move(mapToGlobal(p));
 
-    mCompletionPopup->setRecordUsage(pSettings->codeCompletion().recordUsage());
-    mCompletionPopup->setSortByScope(pSettings->codeCompletion().sortByScope());
-    mCompletionPopup->setShowKeywords(pSettings->codeCompletion().showKeywords());
-    mCompletionPopup->setShowCodeSnippets(pSettings->codeCompletion().showCodeIns());
+    pMainWindow->completionPopup()->setRecordUsage(pSettings->codeCompletion().recordUsage());
+    pMainWindow->completionPopup()->setSortByScope(pSettings->codeCompletion().sortByScope());
+    pMainWindow->completionPopup()->setShowKeywords(pSettings->codeCompletion().showKeywords());
+    pMainWindow->completionPopup()->setShowCodeSnippets(pSettings->codeCompletion().showCodeIns());
     if (pSettings->codeCompletion().showCodeIns()) {
-        mCompletionPopup->setCodeSnippets(pMainWindow->codeSnippetManager()->snippets());
+        pMainWindow->completionPopup()->setCodeSnippets(pMainWindow->codeSnippetManager()->snippets());
     }
-    mCompletionPopup->setIgnoreCase(pSettings->codeCompletion().ignoreCase());
-    mCompletionPopup->resize(pSettings->codeCompletion().width(),
+    pMainWindow->completionPopup()->setIgnoreCase(pSettings->codeCompletion().ignoreCase());
+    pMainWindow->completionPopup()->resize(pSettings->codeCompletion().width(),
                              pSettings->codeCompletion().height());
 //    fCompletionBox.CodeInsList := dmMain.CodeInserts.ItemList;
 //    fCompletionBox.SymbolUsage := dmMain.SymbolUsage;
 //    fCompletionBox.ShowCount := devCodeCompletion.MaxCount;
     //Set Font size;
-    mCompletionPopup->setFont(font());
+    pMainWindow->completionPopup()->setFont(font());
     // Redirect key presses to completion box if applicable
     //todo:
-    mCompletionPopup->setKeypressedCallback([this](QKeyEvent *event)->bool{
+    pMainWindow->completionPopup()->setKeypressedCallback([this](QKeyEvent *event)->bool{
         return onCompletionKeyPressed(event);
     });
-    mCompletionPopup->setParser(mParser);
-    mCompletionPopup->setUseCppKeyword(mUseCppSyntax);
-    pMainWindow->functionTip()->hide();
-    mCompletionPopup->show();
+    pMainWindow->completionPopup()->setParser(mParser);
+    pMainWindow->completionPopup()->setUseCppKeyword(mUseCppSyntax);
+    pMainWindow->hideFunctionTip();
+    pMainWindow->completionPopup()->show();
 
     // Scan the current function body
-    mCompletionPopup->setCurrentStatement(
+    pMainWindow->completionPopup()->setCurrentStatement(
                 mParser->findAndScanBlockAt(mFilename, caretY())
                 );
 
@@ -2735,7 +2750,7 @@ void Editor::showCompletion(const QString& preWord,bool autoComplete)
                     memberExpression);
 //        qDebug()<<ownerExpression<<memberExpression;
         word = memberExpression.join("");
-        mCompletionPopup->prepareSearch(
+        pMainWindow->completionPopup()->prepareSearch(
                     preWord,
                     ownerExpression,
                     memberOperator,
@@ -2746,14 +2761,14 @@ void Editor::showCompletion(const QString& preWord,bool autoComplete)
     } else {
         QStringList memberExpression;
         memberExpression.append(word);
-        mCompletionPopup->prepareSearch(preWord,
+        pMainWindow->completionPopup()->prepareSearch(preWord,
                                         QStringList(),
                                         "",
                                         memberExpression, mFilename, caretY(),keywords);
     }
 
     // Filter the whole statement list
-    if (mCompletionPopup->search(word, autoComplete)) { //only one suggestion and it's not input while typing
+    if (pMainWindow->completionPopup()->search(word, autoComplete)) { //only one suggestion and it's not input while typing
         completionInsert(pSettings->codeCompletion().appendFunc());
     }
 }
@@ -2765,26 +2780,26 @@ void Editor::showHeaderCompletion(bool autoComplete)
 //    if not devCodeCompletion.Enabled then
 //      Exit;
 
-    if (mHeaderCompletionPopup->isVisible()) // already in search, don't do it again
+    if (pMainWindow->isHeaderCompletionPopupVisible()) // already in search, don't do it again
         return;
 
     // Position it at the top of the next line
     QPoint p = rowColumnToPixels(displayXY());
     p.setY(p.y() + textHeight() + 2);
-    mHeaderCompletionPopup->move(mapToGlobal(p));
+    pMainWindow->headerCompletionPopup()->move(mapToGlobal(p));
 
 
-    mHeaderCompletionPopup->setIgnoreCase(pSettings->codeCompletion().ignoreCase());
-    mHeaderCompletionPopup->resize(pSettings->codeCompletion().width(),
+    pMainWindow->headerCompletionPopup()->setIgnoreCase(pSettings->codeCompletion().ignoreCase());
+    pMainWindow->headerCompletionPopup()->resize(pSettings->codeCompletion().width(),
                              pSettings->codeCompletion().height());
     //Set Font size;
-    mHeaderCompletionPopup->setFont(font());
+    pMainWindow->headerCompletionPopup()->setFont(font());
 
     // Redirect key presses to completion box if applicable
-    mHeaderCompletionPopup->setKeypressedCallback([this](QKeyEvent* event)->bool{
+    pMainWindow->headerCompletionPopup()->setKeypressedCallback([this](QKeyEvent* event)->bool{
         return onHeaderCompletionKeyPressed(event);
     });
-    mHeaderCompletionPopup->setParser(mParser);
+    pMainWindow->headerCompletionPopup()->setParser(mParser);
 
     BufferCoord pBeginPos,pEndPos;
     QString word = getWordAtPosition(this,caretXY(),pBeginPos,pEndPos,
@@ -2798,15 +2813,15 @@ void Editor::showHeaderCompletion(bool autoComplete)
     if (word.lastIndexOf('"')>0 || word.lastIndexOf('>')>0)
         return;
 
-    pMainWindow->functionTip()->hide();
-    mHeaderCompletionPopup->show();
-    mHeaderCompletionPopup->setSearchLocal(word.startsWith('"'));
+    pMainWindow->hideFunctionTip();
+    pMainWindow->headerCompletionPopup()->show();
+    pMainWindow->headerCompletionPopup()->setSearchLocal(word.startsWith('"'));
     word.remove(0,1);
 
-    mHeaderCompletionPopup->prepareSearch(word, mFilename);
+    pMainWindow->headerCompletionPopup()->prepareSearch(word, mFilename);
 
     // Filter the whole statement list
-    if (mHeaderCompletionPopup->search(word, autoComplete)) //only one suggestion and it's not input while typing
+    if (pMainWindow->headerCompletionPopup()->search(word, autoComplete)) //only one suggestion and it's not input while typing
         headerCompletionInsert(); // if only have one suggestion, just use it
 }
 
@@ -2853,7 +2868,7 @@ bool Editor::testInFunc(int x, int y)
 
 void Editor::completionInsert(bool appendFunc)
 {
-    PStatement statement = mCompletionPopup->selectedStatement();
+    PStatement statement = pMainWindow->completionPopup()->selectedStatement();
     if (!statement)
         return;
 
@@ -2919,12 +2934,12 @@ void Editor::completionInsert(bool appendFunc)
 //              end;
         }
     }
-    mCompletionPopup->hide();
+    pMainWindow->completionPopup()->hide();
 }
 
 void Editor::headerCompletionInsert()
 {
-    QString headerName = mHeaderCompletionPopup->selectedFilename();
+    QString headerName = pMainWindow->headerCompletionPopup()->selectedFilename();
     if (headerName.isEmpty())
         return;
 
@@ -2947,15 +2962,15 @@ void Editor::headerCompletionInsert()
 
     setSelText(headerName);
 
-    mCompletionPopup->hide();
+    pMainWindow->completionPopup()->hide();
 }
 
 bool Editor::onCompletionKeyPressed(QKeyEvent *event)
 {
     bool processed = false;
-    if (!mCompletionPopup->isEnabled())
+    if (!pMainWindow->completionPopup()->isEnabled())
         return false;
-    QString oldPhrase = mCompletionPopup->memberPhrase();
+    QString oldPhrase = pMainWindow->completionPopup()->memberPhrase();
     WordPurpose purpose = WordPurpose::wpCompletion;
     if (oldPhrase.startsWith('#')) {
         purpose = WordPurpose::wpDirective;
@@ -2976,20 +2991,20 @@ bool Editor::onCompletionKeyPressed(QKeyEvent *event)
                     SynEditorCommand::ecDeleteLastChar,
                     QChar(), nullptr); // Simulate backspace in editor
         if (purpose == WordPurpose::wpCompletion) {
-            phrase = getWordForCompletionSearch(caretXY(), mCompletionPopup->memberOperator()=="::");
+            phrase = getWordForCompletionSearch(caretXY(), pMainWindow->completionPopup()->memberOperator()=="::");
         } else
             phrase = getWordAtPosition(this,caretXY(),
                                             pBeginPos,pEndPos,
                                             purpose);
         mLastIdCharPressed = phrase.length();
         if (phrase.isEmpty()) {
-            mCompletionPopup->hide();
+            pMainWindow->completionPopup()->hide();
         } else {
-            mCompletionPopup->search(phrase, false);
+            pMainWindow->completionPopup()->search(phrase, false);
         }
         return true;
     case Qt::Key_Escape:
-        mCompletionPopup->hide();
+        pMainWindow->completionPopup()->hide();
         return true;
     case Qt::Key_Return:
     case Qt::Key_Enter:
@@ -2999,7 +3014,7 @@ bool Editor::onCompletionKeyPressed(QKeyEvent *event)
     default:
         if (event->text().isEmpty()) {
             //stop completion
-            mCompletionPopup->hide();
+            pMainWindow->completionPopup()->hide();
             keyPressEvent(event);
             return true;
         }
@@ -3008,17 +3023,17 @@ bool Editor::onCompletionKeyPressed(QKeyEvent *event)
     if (isIdentChar(ch)) {
         setSelText(ch);
         if (purpose == WordPurpose::wpCompletion) {
-            phrase = getWordForCompletionSearch(caretXY(),mCompletionPopup->memberOperator()=="::");
+            phrase = getWordForCompletionSearch(caretXY(),pMainWindow->completionPopup()->memberOperator()=="::");
         } else
             phrase = getWordAtPosition(this,caretXY(),
                                             pBeginPos,pEndPos,
                                             purpose);
         mLastIdCharPressed = phrase.length();
-        mCompletionPopup->search(phrase, false);
+        pMainWindow->completionPopup()->search(phrase, false);
         return true;
     } else {
         //stop completion
-        mCompletionPopup->hide();
+        pMainWindow->completionPopup()->hide();
         keyPressEvent(event);
         return true;
     }
@@ -3028,7 +3043,7 @@ bool Editor::onCompletionKeyPressed(QKeyEvent *event)
 bool Editor::onHeaderCompletionKeyPressed(QKeyEvent *event)
 {
     bool processed = false;
-    if (!mHeaderCompletionPopup->isEnabled())
+    if (!pMainWindow->headerCompletionPopup()->isEnabled())
         return false;
     QString phrase;
     BufferCoord pBeginPos,pEndPos;
@@ -3041,23 +3056,23 @@ bool Editor::onHeaderCompletionKeyPressed(QKeyEvent *event)
                                    pBeginPos,pEndPos,
                                    WordPurpose::wpHeaderCompletion);
         mLastIdCharPressed = phrase.length();
-        mHeaderCompletionPopup->search(phrase, false);
+        pMainWindow->headerCompletionPopup()->search(phrase, false);
         return true;
     case Qt::Key_Escape:
-        mHeaderCompletionPopup->hide();
+        pMainWindow->headerCompletionPopup()->hide();
         return true;
     case Qt::Key_Return:
     case Qt::Key_Enter:
     case Qt::Key_Tab:
         headerCompletionInsert();
-        mHeaderCompletionPopup->hide();
+        pMainWindow->headerCompletionPopup()->hide();
         return true;
     case Qt::Key_Shift:
         return false;
     default:
         if (event->text().isEmpty()) {
             //stop completion
-            mHeaderCompletionPopup->hide();
+            pMainWindow->headerCompletionPopup()->hide();
             keyPressEvent(event);
             return true;
         }
@@ -3071,11 +3086,11 @@ bool Editor::onHeaderCompletionKeyPressed(QKeyEvent *event)
                                             pBeginPos,pEndPos,
                                             WordPurpose::wpHeaderCompletion);
         mLastIdCharPressed = phrase.length();
-        mHeaderCompletionPopup->search(phrase, false);
+        pMainWindow->headerCompletionPopup()->search(phrase, false);
         return true;
     } else {
         //stop completion
-        mHeaderCompletionPopup->hide();
+        pMainWindow->headerCompletionPopup()->hide();
         keyPressEvent(event);
         return true;
     }
@@ -3085,13 +3100,13 @@ bool Editor::onHeaderCompletionKeyPressed(QKeyEvent *event)
 bool Editor::onCompletionInputMethod(QInputMethodEvent *event)
 {
     bool processed = false;
-    if (!mCompletionPopup->isVisible())
+    if (!pMainWindow->isCompletionPopupVisible())
         return processed;
     QString s=event->commitString();
     if (!s.isEmpty()) {
-        QString phrase = getWordForCompletionSearch(caretXY(),mCompletionPopup->memberOperator()=="::");
+        QString phrase = getWordForCompletionSearch(caretXY(),pMainWindow->completionPopup()->memberOperator()=="::");
         mLastIdCharPressed = phrase.length();
-        mCompletionPopup->search(phrase, false);
+        pMainWindow->completionPopup()->search(phrase, false);
         return true;
     }
     return processed;
@@ -3202,8 +3217,8 @@ void Editor::showDebugHint(const QString &s, int line)
     }
     if (pMainWindow->debugger()->commandRunning())
         return;
-    if (pMainWindow->functionTip()->isVisible()) {
-        pMainWindow->functionTip()->hide();
+    if (pMainWindow->isFunctionTipVisible()) {
+        pMainWindow->hideFunctionTip();
     }
     connect(pMainWindow->debugger(), &Debugger::evalValueReady,
                this, &Editor::onTipEvalValueReady);
@@ -3243,8 +3258,8 @@ QString Editor::getHintForFunction(const PStatement &statement, const PStatement
 
 void Editor::updateFunctionTip()
 {
-    if (pMainWindow->completionPopup()->isVisible()) {
-        pMainWindow->functionTip()->hide();
+    if (pMainWindow->isCompletionPopupVisible()) {
+        pMainWindow->hideFunctionTip();
         return;
     }
     if (!highlighter())
@@ -3253,7 +3268,7 @@ void Editor::updateFunctionTip()
     bool isFunction = false;
     auto action = finally([&isFunction]{
         if (!isFunction)
-            pMainWindow->functionTip()->hide();
+            pMainWindow->hideFunctionTip();
     });
     const int maxLines=10;
     BufferCoord caretPos = caretXY();
@@ -3431,7 +3446,7 @@ void Editor::updateFunctionTip()
 
     // If we can't find it in our database, hide
     if (pMainWindow->functionTip()->tipCount()<=0) {
-        pMainWindow->functionTip()->hide();
+        pMainWindow->hideFunctionTip();
         return;
     }
     // Position it at the top of the next line
@@ -3496,7 +3511,7 @@ void Editor::onExportedFormatToken(PSynHighlighter syntaxHighlighter, int Line,
     if (token.isEmpty())
         return;
     //don't do this
-    if (mCompletionPopup->isVisible() || mHeaderCompletionPopup->isVisible())
+    if (pMainWindow->isCompletionPopupVisible() || pMainWindow->isHeaderCompletionPopupVisible())
         return;
 
     if (mParser && (attr == syntaxHighlighter->identifierAttribute())) {
@@ -3963,7 +3978,7 @@ void Editor::reformat()
 #endif
     //we must remove all breakpoints and syntax issues
     onLinesDeleted(1,lines()->count());
-    QByteArray content = text().toUtf8();
+    QByteArray content = lines()->textBytes();
     QStringList args = pSettings->codeFormatter().getArguments();
 #ifdef Q_OS_WIN
     QByteArray newContent = runAndGetOutput("astyle.exe",
@@ -3979,12 +3994,12 @@ void Editor::reformat()
     int oldTopLine = topLine();
     BufferCoord mOldCaret = caretXY();
 
-    selectAll();
     SynEditorOptions oldOptions = getOptions();
     SynEditorOptions newOptions = oldOptions;
     newOptions.setFlag(SynEditorOption::eoAutoIndent,false);
     setOptions(newOptions);
-    setSelText(QString::fromUtf8(newContent));
+    //only the reformatted lines are replaced, so undo keeps just those
+    replaceContents(textToLines(QString::fromUtf8(newContent)));
     setCaretXY(mOldCaret);
     setTopLine(oldTopLine);
     setOptions(oldOptions);
@@ -3998,6 +4013,8 @@ void Editor::checkSyntaxInBack()
 {
     if (readOnly())
         return;
+    if (mLargeFileMode)
+        return;
     if (!highlighter())
         return;
     if (highlighter()->language()!=SynHighlighterLanguage::Cpp)
@@ -4011,6 +4028,21 @@ const PCppParser &Editor::parser()
     return mParser;
 }
 
+const PTodoLineCache &Editor::todoLineCache() const
+{
+    return mTodoLineCache;
+}
+
+const PRecoveryJournal &Editor::recoveryJournal() const
+{
+    return mRecoveryJournal;
+}
+
+bool Editor::largeFileMode() const
+{
+    return mLargeFileMode;
+}
+
 void Editor::tab()
 {
     if (mUserCodeInTabStops.count()>0) {
@@ -4159,6 +4191,9 @@ void Editor::applySettings()
     options.setFlag(eoShowRainbowColor, pSettings->editor().rainbowParenthesis());
     setOptions(options);
 
+    setUndoLimit(pSettings->editor().undoLimit());
+    setUndoMemoryUsage((qint64)pSettings->editor().undoMemoryUsage()*1024*1024);
+
     setTabWidth(pSettings->editor().tabWidth());
     setInsertCaret(pSettings->editor().caretForInsert());
     setOverwriteCaret(pSettings->editor().caretForOverwrite());
@@ -24,6 +24,8 @@
 #include "colorscheme.h"
 #include "common.h"
 #include "parser/cppparser.h"
+#include "todoparser.h"
+#include "recoveryjournal.h"
 #include "widgets/codecompletionpopup.h"
 #include "widgets/headercompletionpopup.h"
 
@@ -222,6 +224,12 @@ public:
 
     const PCppParser &parser();
 
+    const PTodoLineCache &todoLineCache() const;
+
+    const PRecoveryJournal &recoveryJournal() const;
+
+    bool largeFileMode() const;
+
     void tab() override;
 signals:
     void renamed(const QString& oldName, const QString& newName, bool firstSave);
@@ -304,8 +312,10 @@ private:
     QSet<int> mBookmarkLines;
     int mActiveBreakpointLine;
     PCppParser mParser;
-    std::shared_ptr<CodeCompletionPopup> mCompletionPopup;
-    std::shared_ptr<HeaderCompletionPopup> mHeaderCompletionPopup;
+    PTodoLineCache mTodoLineCache;
+    PRecoveryJournal mRecoveryJournal;
+    //the file is kept mapped, and parsing, syntax checking and folding are off
+    bool mLargeFileMode;
     int mLastIdCharPressed;
     bool mUseCppSyntax;
     QString mCurrentWord;
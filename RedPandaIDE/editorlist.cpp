@@ -23,6 +23,7 @@
 #include "settings.h"
 #include "project.h"
 #include "systemconsts.h"
+#include "undojournal.h"
 #include <QApplication>
 
 EditorList::EditorList(QTabWidget* leftPageWidget,
@@ -170,6 +171,20 @@ bool EditorList::closeEditor(Editor* editor, bool transferFocus, bool force) {
 //        //todo: activate & focus the previous editor
 //    }
 
+    if (pSettings->editor().persistentUndo()
+            && !editor->isNew() && !editor->modified() && !editor->largeFileMode()) {
+        UndoJournal journal(editor->filename(), (qint64)pSettings->editor().undoJournalSize()*1024*1024);
+        journal.save(editor);
+    }
+    //changes not saved by now are thrown away
+    editor->recoveryJournal()->discard();
+
+    //the file's content is what's on the disk now
+    if (editor->inProject() && pMainWindow->project())
+        pMainWindow->todoParser()->parseFiles(QStringList{editor->filename()});
+    else
+        pMainWindow->todoParser()->removeFile(editor->filename());
+
     if (editor->inProject() && pMainWindow->project()) {
         int projIndex = pMainWindow->project()->indexInUnits(editor);
         if (projIndex>=0) {
@@ -19,10 +19,12 @@
 #include <QFileInfo>
 #include <QList>
 #include <QDebug>
+#include <cstring>
 
 GDBMIResultParser::GDBMIResultParser()
 {
     mResultTypes.insert("-break-insert",GDBMIResultType::Breakpoint);
+    mResultTypes.insert("-dprintf-insert",GDBMIResultType::Breakpoint);
     //mResultTypes.insert("BreakpointTable",GDBMIResultType::BreakpointTable);
     mResultTypes.insert("-stack-list-frames",GDBMIResultType::FrameStack);
     mResultTypes.insert("-stack-list-variables", GDBMIResultType::LocalVariables);
@@ -32,6 +34,7 @@ GDBMIResultParser::GDBMIResultParser()
 //    mResultTypes.insert("register-names",GDBMIResultType::RegisterNames);
 //    mResultTypes.insert("register-values",GDBMIResultType::RegisterValues);
     mResultTypes.insert("-data-read-memory",GDBMIResultType::Memory);
+    mResultTypes.insert("-data-read-memory-bytes",GDBMIResultType::MemoryBytes);
     mResultTypes.insert("-data-list-register-names",GDBMIResultType::RegisterNames);
     mResultTypes.insert("-data-list-register-values",GDBMIResultType::RegisterValues);
     mResultTypes.insert("-var-create",GDBMIResultType::CreateVar);
@@ -41,8 +44,12 @@ GDBMIResultParser::GDBMIResultParser()
 
 bool GDBMIResultParser::parse(const QByteArray &record, const QString& command, GDBMIResultType &type, ParseObject& multiValues)
 {
-    const char* p = record.data();
-    bool result = parseMultiValues(p,multiValues);
+    PParseDocument document = std::make_shared<ParseDocument>();
+    document->record = record;
+    // a rough guess: one node for every 16 bytes of the record
+    document->nodes.reserve(record.length()/16+1);
+    const char* p = document->record.constData();
+    bool result = parseMultiValues(p,*document);
     if (!result)
         return false;
 //    if (*p!=0)
@@ -50,106 +57,38 @@ bool GDBMIResultParser::parse(const QByteArray &record, const QString& command,
     if (!mResultTypes.contains(command))
         return false;
     type = mResultTypes[command];
+    multiValues = ParseObject(document,0);
     return true;
 }
 
 bool GDBMIResultParser::parseAsyncResult(const QByteArray &record, QByteArray &result, ParseObject &multiValue)
 {
-    const char* p =record.data();
-    if (*p!='*')
+    PParseDocument document = std::make_shared<ParseDocument>();
+    document->record = record;
+    const char* p =document->record.constData();
+    //exec async record or notify async record
+    if (*p!='*' && *p!='=')
         return false;
     p++;
     const char* start=p;
     while (*p && *p!=',')
         p++;
     result = QByteArray(start,p-start);
-    if (*p==0)
-        return true;
-    p++;
-    return parseMultiValues(p,multiValue);
-}
-
-bool GDBMIResultParser::parseMultiValues(const char* p, ParseObject &multiValue)
-{
-    while (*p) {
-        QByteArray propName;
-        ParseValue propValue;
-        bool result = parseNameAndValue(p,propName,propValue);
-        if (result) {
-            multiValue[propName]=propValue;
-        } else {
-            return false;
-        }
-        skipSpaces(p);
-        if (*p==0)
-            break;
-        if (*p!=',')
-            return false;
-        p++; //skip ','
-        skipSpaces(p);
-    }
-    return true;
-}
-
-bool GDBMIResultParser::parseNameAndValue(const char *&p, QByteArray &name, ParseValue &value)
-{
-    skipSpaces(p);
-    const char* nameStart =p;
-    while (*p!=0 && isNameChar(*p)) {
+    if (*p!=0)
         p++;
-    }
-    if (*p==0)
-        return false;
-    name = QByteArray(nameStart,p-nameStart);
-    skipSpaces(p);
-    if (*p!='=')
-        return false;
-    p++;
-    return parseValue(p,value);
-}
-
-bool GDBMIResultParser::parseValue(const char *&p, ParseValue &value)
-{
-    skipSpaces(p);
-    bool result;
-    switch (*p) {
-    case '{': {
-        ParseObject obj;
-        result = parseObject(p,obj);
-        value = obj;
-        break;
-    }
-    case '[': {
-        QList<ParseValue> array;
-        result = parseArray(p,array);
-        value = array;
-        break;
-    }
-    case '"': {
-        QByteArray s;
-        result = parseStringValue(p,s);
-        value = s;
-        break;
-    }
-    default:
+    if (!parseMultiValues(p,*document))
         return false;
-    }
-    if (!result)
-        return false;
-    skipSpaces(p);
+    multiValue = ParseObject(document,0);
     return true;
 }
 
-bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue)
+QByteArray GDBMIResultParser::decodeStringValue(const char *p, int length)
 {
-    if (*p!='"')
-        return false;
-    p++;
-    stringValue.clear();
-    while (*p!=0) {
-        if (*p == '"') {
-            break;
-        } else if (*p=='\\' && *(p+1)!=0) {
+    QByteArray stringValue;
+    stringValue.reserve(length);
+    const char* end = p + length;
+    while (p<end) {
+        if (*p=='\\' && p+1<end) {
             p++;
             switch (*p) {
             case '\'':
@@ -206,13 +145,12 @@ bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue
             case '7':
             {
                 int i=0;
-                for (i=0;i<3;i++) {
+                unsigned char ch=0;
+                for (i=0;i<3 && p+i<end;i++) {
                     if (*(p+i)<'0' || *(p+i)>'7')
                         break;
+                    ch = ch*8 + (*(p+i)-'0');
                 }
-                QByteArray numStr(p,i);
-                bool ok;
-                unsigned char ch = numStr.toInt(&ok,8);
                 stringValue+=ch;
                 p+=i;
                 break;
@@ -223,26 +161,124 @@ bool GDBMIResultParser::parseStringValue(const char *&p, QByteArray& stringValue
             p++;
         }
     }
+    return stringValue;
+}
+
+bool GDBMIResultParser::parseMultiValues(const char* p, ParseDocument& document)
+{
+    int root = newNode(document, ParseValueType::Object);
+    int lastChild = -1;
+    while (*p) {
+        int child;
+        bool result = parseNameAndValue(p,document,child);
+        if (result) {
+            appendChild(document,root,lastChild,child);
+        } else {
+            return false;
+        }
+        skipSpaces(p);
+        if (*p==0)
+            break;
+        if (*p!=',')
+            return false;
+        p++; //skip ','
+        skipSpaces(p);
+    }
+    return true;
+}
+
+bool GDBMIResultParser::parseNameAndValue(const char *&p, ParseDocument& document, int& index)
+{
+    skipSpaces(p);
+    const char* nameStart =p;
+    while (*p!=0 && isNameChar(*p)) {
+        p++;
+    }
+    if (*p==0)
+        return false;
+    int nameLength = p-nameStart;
+    skipSpaces(p);
+    if (*p!='=')
+        return false;
+    p++;
+    if (!parseValue(p,document,index))
+        return false;
+    ParseNode& node = document.nodes[index];
+    node.nameStart = nameStart - document.record.constData();
+    node.nameLength = nameLength;
+    return true;
+}
+
+bool GDBMIResultParser::parseValue(const char *&p, ParseDocument& document, int& index)
+{
+    skipSpaces(p);
+    bool result;
+    switch (*p) {
+    case '{': {
+        index = newNode(document, ParseValueType::Object);
+        result = parseObject(p,document,index);
+        break;
+    }
+    case '[': {
+        index = newNode(document, ParseValueType::Array);
+        result = parseArray(p,document,index);
+        break;
+    }
+    case '"': {
+        index = newNode(document, ParseValueType::Value);
+        result = parseStringValue(p,document,index);
+        break;
+    }
+    default:
+        return false;
+    }
+    if (!result)
+        return false;
+    skipSpaces(p);
+    return true;
+}
+
+bool GDBMIResultParser::parseStringValue(const char *&p, ParseDocument& document, int index)
+{
+    if (*p!='"')
+        return false;
+    p++;
+    const char* start = p;
+    bool escaped = false;
+    while (*p!=0) {
+        if (*p == '"') {
+            break;
+        } else if (*p=='\\' && *(p+1)!=0) {
+            escaped = true;
+            p+=2;
+        } else {
+            p++;
+        }
+    }
     if (*p=='"') {
+        ParseNode& node = document.nodes[index];
+        node.valueStart = start - document.record.constData();
+        node.valueLength = p - start;
+        node.escaped = escaped;
         p++; //skip '"'
         return true;
     }
     return false;
 }
 
-bool GDBMIResultParser::parseObject(const char *&p, ParseObject &obj)
+bool GDBMIResultParser::parseObject(const char *&p, ParseDocument& document, int index)
 {
     if (*p!='{')
         return false;
     p++;
 
+    int lastChild = -1;
     if (*p!='}') {
         while (*p!=0) {
-            QByteArray propName;
-            ParseValue propValue;
-            bool result = parseNameAndValue(p,propName,propValue);
+            int child;
+            bool result = parseNameAndValue(p,document,child);
             if (result) {
-                obj[propName]=propValue;
+                appendChild(document,index,lastChild,child);
             } else {
                 return false;
             }
@@ -263,33 +299,28 @@ bool GDBMIResultParser::parseObject(const char *&p, ParseObject &obj)
     return false;
 }
 
-bool GDBMIResultParser::parseArray(const char *&p, QList<GDBMIResultParser::ParseValue> &array)
+bool GDBMIResultParser::parseArray(const char *&p, ParseDocument& document, int index)
 {
     if (*p!='[')
         return false;
     p++;
+    int lastChild = -1;
     if (*p!=']') {
         while (*p!=0) {
             skipSpaces(p);
+            int child;
+            bool result;
             if (*p=='{' || *p=='"' || *p=='[') {
-                ParseValue val;
-                bool result = parseValue(p,val);
-                if (result) {
-                    array.append(val);
-                } else {
-                    return false;
-                }
+                result = parseValue(p,document,child);
             } else {
-                QByteArray name;
-                ParseValue val;
-                bool result = parseNameAndValue(p,name,val);
-                if (result) {
-                    array.append(val);
-                } else {
-                    return false;
-                }
+                result = parseNameAndValue(p,document,child);
+            }
+            if (result) {
+                appendChild(document,index,lastChild,child);
+            } else {
+                return false;
             }
-            skipSpaces(p);            
+            skipSpaces(p);
             if (*p==']')
                 break;
             if (*p!=',')
@@ -305,6 +336,32 @@ bool GDBMIResultParser::parseArray(const char *&p, QList<GDBMIResultParser::Pars
     return false;
 }
 
+int GDBMIResultParser::newNode(ParseDocument &document, ParseValueType type)
+{
+    ParseNode node;
+    node.type = type;
+    node.escaped = false;
+    node.nameStart = -1;
+    node.nameLength = 0;
+    node.valueStart = -1;
+    node.valueLength = 0;
+    node.childCount = 0;
+    node.firstChild = -1;
+    node.nextSibling = -1;
+    document.nodes.append(node);
+    return document.nodes.length()-1;
+}
+
+void GDBMIResultParser::appendChild(ParseDocument &document, int parent, int &lastChild, int child)
+{
+    if (lastChild<0)
+        document.nodes[parent].firstChild = child;
+    else
+        document.nodes[lastChild].nextSibling = child;
+    document.nodes[parent].childCount++;
+    lastChild = child;
+}
+
 bool GDBMIResultParser::isNameChar(char ch)
 {
     if (ch=='-')
@@ -334,28 +391,51 @@ void GDBMIResultParser::skipSpaces(const char *&p)
         p++;
 }
 
-const QByteArray &GDBMIResultParser::ParseValue::value() const
+QByteArray GDBMIResultParser::ParseValue::value() const
 {
-    return mValue;
+    if (type()!=ParseValueType::Value)
+        return QByteArray();
+    const ParseNode& n = node();
+    if (n.escaped)
+        return decodeStringValue(rawData(),n.valueLength);
+    return QByteArray(rawData(),n.valueLength);
 }
 
-const QList<::GDBMIResultParser::ParseValue> &GDBMIResultParser::ParseValue::array() const
+QList<GDBMIResultParser::ParseValue> GDBMIResultParser::ParseValue::array() const
 {
-    return mArray;
+    QList<ParseValue> result;
+    if (type()!=ParseValueType::Array)
+        return result;
+    const ParseNode& n = node();
+    result.reserve(n.childCount);
+    int child = n.firstChild;
+    while (child>=0) {
+        result.append(ParseValue(mDocument,child));
+        child = mDocument->nodes[child].nextSibling;
+    }
+    return result;
 }
 
-const GDBMIResultParser::ParseObject &GDBMIResultParser::ParseValue::object() const
+GDBMIResultParser::ParseObject GDBMIResultParser::ParseValue::object() const
 {
-    return mObject;
+    if (type()!=ParseValueType::Object)
+        return ParseObject();
+    return ParseObject(mDocument,mIndex);
 }
 
 int GDBMIResultParser::ParseValue::intValue(int defaultValue) const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
+    if (type()!=ParseValueType::Value)
+        return defaultValue;
     bool ok;
-    int value = QString(mValue).toInt(&ok);
+    int result;
+    if (node().escaped)
+        result = value().toInt(&ok);
+    else
+        result = QByteArray::fromRawData(rawData(),node().valueLength).toInt(&ok);
     if (ok)
-        return value;
+        return result;
     else
         return defaultValue;
 }
@@ -363,10 +443,28 @@ int GDBMIResultParser::ParseValue::intValue(int defaultValue) const
 int GDBMIResultParser::ParseValue::hexValue(int defaultValue) const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
+    if (type()!=ParseValueType::Value)
+        return defaultValue;
+    bool ok;
+    int result;
+    if (node().escaped)
+        result = value().toInt(&ok,16);
+    else
+        result = QByteArray::fromRawData(rawData(),node().valueLength).toInt(&ok,16);
+    if (ok)
+        return result;
+    else
+        return defaultValue;
+}
+
+qulonglong GDBMIResultParser::ParseValue::addressValue(qulonglong defaultValue) const
+{
+    if (type()!=ParseValueType::Value)
+        return defaultValue;
     bool ok;
-    int value = QString(mValue).toInt(&ok,16);
+    qulonglong result = value().toULongLong(&ok,16);
     if (ok)
-        return value;
+        return result;
     else
         return defaultValue;
 }
@@ -374,113 +472,83 @@ int GDBMIResultParser::ParseValue::hexValue(int defaultValue) const
 QString GDBMIResultParser::ParseValue::pathValue() const
 {
     //Q_ASSERT(mType == ParseValueType::Value);
-    return QFileInfo(QString::fromLocal8Bit(mValue)).absoluteFilePath();
+    return QFileInfo(QString::fromLocal8Bit(value())).absoluteFilePath();
 }
 
 GDBMIResultParser::ParseValueType GDBMIResultParser::ParseValue::type() const
 {
-    return mType;
+    if (!isValid())
+        return ParseValueType::NotAssigned;
+    return node().type;
 }
 
 bool GDBMIResultParser::ParseValue::isValid() const
 {
-    return mType!=ParseValueType::NotAssigned;
-}
-
-GDBMIResultParser::ParseValue::ParseValue():
-    mType(ParseValueType::NotAssigned) {
-
-}
-
-GDBMIResultParser::ParseValue::ParseValue(const QByteArray &value):
-    mValue(value),
-    mType(ParseValueType::Value)
-{
-}
-
-GDBMIResultParser::ParseValue::ParseValue(const ParseObject &object):
-    mObject(object),
-    mType(ParseValueType::Object)
-{
-}
-
-GDBMIResultParser::ParseValue::ParseValue(const QList<ParseValue> &array):
-    mArray(array),
-    mType(ParseValueType::Array)
-{
+    return mDocument && mIndex>=0;
 }
 
-GDBMIResultParser::ParseValue::ParseValue(const ParseValue &value):
-    mValue(value.mValue),
-    mArray(value.mArray),
-    mObject(value.mObject),
-    mType(value.mType)
+const GDBMIResultParser::ParseNode &GDBMIResultParser::ParseValue::node() const
 {
+    return mDocument->nodes[mIndex];
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const GDBMIResultParser::ParseValue &value)
+const char *GDBMIResultParser::ParseValue::rawData() const
 {
-    mType = value.mType;
-    mValue = value.mValue;
-    mArray = value.mArray;
-    mObject = value.mObject;
-    return *this;
+    return mDocument->record.constData()+node().valueStart;
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const QByteArray &value)
-{
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Value;
-    mValue = value;
-    return *this;
-}
+GDBMIResultParser::ParseValue::ParseValue():
+    mIndex(-1) {
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const ParseObject& object)
-{
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Object;
-    mObject = object;
-    return *this;
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseValue::operator=(const QList<ParseValue>& array)
+GDBMIResultParser::ParseValue::ParseValue(const PParseDocument &document, int index):
+    mDocument(document),
+    mIndex(index)
 {
-    Q_ASSERT(mType == ParseValueType::NotAssigned);
-    mType = ParseValueType::Array;
-    mArray = array;
-    return *this;
 }
 
-
-GDBMIResultParser::ParseObject::ParseObject()
+GDBMIResultParser::ParseObject::ParseObject():
+    mIndex(-1)
 {
 
 }
 
-GDBMIResultParser::ParseObject::ParseObject(const ParseObject &object):
-    mProps(object.mProps)
+GDBMIResultParser::ParseObject::ParseObject(const PParseDocument &document, int index):
+    mDocument(document),
+    mIndex(index)
 {
 
 }
 
 GDBMIResultParser::ParseValue GDBMIResultParser::ParseObject::operator[](const QByteArray &name) const
 {
-    if (mProps.contains(name)) {
-        ParseValue value(mProps[name]);
-        return value;
+    if (!mDocument || mIndex<0)
+        return ParseValue();
+    const char* record = mDocument->record.constData();
+    int child = mDocument->nodes[mIndex].firstChild;
+    //the last value wins if a name is repeated, like inserting them into a hash
+    int found = -1;
+    while (child>=0) {
+        const ParseNode& node = mDocument->nodes[child];
+        if (node.nameLength == name.length()
+                && memcmp(record+node.nameStart,name.constData(),node.nameLength)==0)
+            found = child;
+        child = node.nextSibling;
     }
-    return ParseValue();
+    if (found<0)
+        return ParseValue();
+    return ParseValue(mDocument,found);
 }
 
-GDBMIResultParser::ParseObject &GDBMIResultParser::ParseObject::operator=(const ParseObject &object)
+bool GDBMIResultParser::ParseObject::contains(const QByteArray &name) const
 {
-    mProps = object.mProps;
-    return *this;
+    return (*this)[name].isValid();
 }
 
-GDBMIResultParser::ParseValue &GDBMIResultParser::ParseObject::operator[](const QByteArray &name) {
-    if (!mProps.contains(name))
-        mProps[name]=ParseValue();
-    return mProps[name];
+int GDBMIResultParser::ParseObject::count() const
+{
+    if (!mDocument || mIndex<0)
+        return 0;
+    return mDocument->nodes[mIndex].childCount;
 }
-
@@ -20,6 +20,7 @@
 #include <QByteArray>
 #include <QHash>
 #include <QList>
+#include <QVector>
 #include <memory>
 
 
@@ -35,6 +36,7 @@ enum class GDBMIResultType {
     RegisterNames,
     RegisterValues,
     Memory,
+    MemoryBytes,
     CreateVar,
     ListVarChildren,
     UpdateVarValue
@@ -51,59 +53,80 @@ public:
         NotAssigned
     };
 
+    /*
+     * A parsed record is stored as a flat array of nodes.
+     * Nodes only hold offsets into the original record buffer,
+     * string values are decoded when they are read.
+     */
+    struct ParseNode {
+        ParseValueType type;
+        bool escaped; // string value contains '\' escapes
+        int nameStart;
+        int nameLength;
+        int valueStart;
+        int valueLength;
+        int childCount;
+        int firstChild;
+        int nextSibling;
+    };
+
+    struct ParseDocument {
+        QByteArray record;
+        QVector<ParseNode> nodes;
+    };
+
+    using PParseDocument = std::shared_ptr<ParseDocument>;
+
     class ParseValue;
 
     class ParseObject {
     public:
         explicit ParseObject();
-        ParseObject(const ParseObject& object);
+        ParseObject(const PParseDocument& document, int index);
         ParseValue operator[](const QByteArray& name) const;
-        ParseValue& operator[](const QByteArray& name);
-        ParseObject& operator=(const ParseObject& object);
+        bool contains(const QByteArray& name) const;
+        int count() const;
     private:
-        QHash<QByteArray, ParseValue> mProps;
+        PParseDocument mDocument;
+        int mIndex;
     };
 
     class ParseValue {
     public:
         explicit ParseValue();
-        explicit ParseValue(const QByteArray& value);
-        explicit ParseValue(const ParseObject &object);
-        explicit ParseValue(const QList<ParseValue>& array);
-        ParseValue(const ParseValue& value);
-        const QByteArray &value() const;
-        const QList<ParseValue> &array() const;
-        const ParseObject &object() const;
+        ParseValue(const PParseDocument& document, int index);
+        QByteArray value() const;
+        QList<ParseValue> array() const;
+        ParseObject object() const;
         int intValue(int defaultValue=-1) const;
         int hexValue(int defaultValue=-1) const;
+        qulonglong addressValue(qulonglong defaultValue=0) const;
 
         QString pathValue() const;
         ParseValueType type() const;
         bool isValid() const;
-        ParseValue& operator=(const QByteArray& value);
-        ParseValue& operator=(const ParseObject& object);
-        ParseValue& operator=(const QList<ParseValue>& array);
-        ParseValue& operator=(const ParseValue& value);
     private:
-        QByteArray mValue;
-        QList<ParseValue> mArray;
-        ParseObject mObject;
-        ParseValueType mType;
+        const ParseNode& node() const;
+        const char* rawData() const;
+    private:
+        PParseDocument mDocument;
+        int mIndex;
     };
 
-    using PParseValue = std::shared_ptr<ParseValue>;
-
 public:
     GDBMIResultParser();
     bool parse(const QByteArray& record, const QString& command, GDBMIResultType& type, ParseObject& multiValues);
     bool parseAsyncResult(const QByteArray& record, QByteArray& result, ParseObject& multiValue);
+    static QByteArray decodeStringValue(const char* p, int length);
 private:
-    bool parseMultiValues(const char*p, ParseObject& multiValue);
-    bool parseNameAndValue(const char *&p,QByteArray& name, ParseValue& value);
-    bool parseValue(const char* &p, ParseValue& value);
-    bool parseStringValue(const char*&p, QByteArray& stringValue);
-    bool parseObject(const char*&p, ParseObject& obj);
-    bool parseArray(const char*&p, QList<ParseValue>& array);
+    bool parseMultiValues(const char*p, ParseDocument& document);
+    bool parseNameAndValue(const char *&p, ParseDocument& document, int& index);
+    bool parseValue(const char* &p, ParseDocument& document, int& index);
+    bool parseStringValue(const char*&p, ParseDocument& document, int index);
+    bool parseObject(const char*&p, ParseDocument& document, int index);
+    bool parseArray(const char*&p, ParseDocument& document, int index);
+    int newNode(ParseDocument& document, ParseValueType type);
+    void appendChild(ParseDocument& document, int parent, int& lastChild, int child);
     void skipSpaces(const char* &p);
     bool isNameChar(char ch);
     bool isSpaceChar(char ch);
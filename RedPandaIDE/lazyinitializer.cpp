@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "lazyinitializer.h"
+#include "startupprofiler.h"
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QWidget>
+
+LazyInitializer::LazyInitializer(const QString &name,
+                                 std::function<void ()> initializer,
+                                 QObject *parent) : QObject(parent),
+    mName(name),
+    mInitializer(initializer),
+    mInitialized(false)
+{
+
+}
+
+void LazyInitializer::ensure()
+{
+    if (mInitialized)
+        return;
+    //set it first, so the initializer can use the guarded accessors
+    mInitialized = true;
+    foreach (QObject* obj, mWatchedWidgets) {
+        obj->removeEventFilter(this);
+    }
+    mWatchedWidgets.clear();
+    QElapsedTimer timer;
+    timer.start();
+    mInitializer();
+    if (pStartupProfiler)
+        pStartupProfiler->addDeferredInitialization(mName, timer.elapsed());
+}
+
+void LazyInitializer::initializeOnShow(QWidget *widget)
+{
+    if (mInitialized)
+        return;
+    if (widget->isVisible()) {
+        ensure();
+        return;
+    }
+    widget->installEventFilter(this);
+    mWatchedWidgets.append(widget);
+    connect(widget, &QObject::destroyed,
+            this, [this](QObject* obj){
+        mWatchedWidgets.removeAll(obj);
+    });
+}
+
+bool LazyInitializer::initialized() const
+{
+    return mInitialized;
+}
+
+bool LazyInitializer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Show && mWatchedWidgets.contains(watched)) {
+        ensure();
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LAZYINITIALIZER_H
+#define LAZYINITIALIZER_H
+
+#include <QObject>
+#include <functional>
+
+class QWidget;
+
+/**
+ * Runs an initializer exactly once, the first time its result is needed:
+ * either when ensure() is called before a use, or when one of the watched
+ * widgets is shown for the first time.
+ *
+ * Used to keep panels and managers which are not needed to show the first
+ * editor out of the startup path.
+ */
+class LazyInitializer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LazyInitializer(const QString& name,
+                             std::function<void ()> initializer,
+                             QObject *parent = nullptr);
+    void ensure();
+    void initializeOnShow(QWidget* widget);
+    bool initialized() const;
+
+    // QObject interface
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+private:
+    QString mName;
+    std::function<void ()> mInitializer;
+    bool mInitialized;
+    QList<QObject*> mWatchedWidgets;
+};
+
+#endif // LAZYINITIALIZER_H
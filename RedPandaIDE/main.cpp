@@ -28,13 +28,18 @@
 #include <QDesktopWidget>
 #include <QDir>
 #include <QScreen>
+#include <QTextStream>
+#include <QTimer>
 #include "common.h"
 #include "colorscheme.h"
 #include "iconsmanager.h"
 #include "autolinkmanager.h"
+#include "compiler/compilecache.h"
+#include "problems/ojproblemset.h"
 #include "platform.h"
 #include "parser/parserutils.h"
 #include "editorlist.h"
+#include "startupprofiler.h"
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
@@ -107,8 +112,14 @@ int main(int argc, char *argv[])
 {
     //QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication app(argc, argv);
+    StartupProfiler startupProfiler;
+    pStartupProfiler = &startupProfiler;
+    QStringList arguments = app.arguments();
+    arguments.pop_front();
+    bool profileStartup = arguments.removeAll("--profile-startup")>0;
 
     //Translation must be loaded first
+    startupProfiler.startPhase("Load translations");
     QTranslator trans,transQt;
     QString settingFilename = getSettingFilename();
     if (!isGreenEdition()) {
@@ -131,9 +142,11 @@ int main(int argc, char *argv[])
 
     qRegisterMetaType<PCompileIssue>("PCompileIssue");
     qRegisterMetaType<PCompileIssue>("PCompileIssue&");
+    qRegisterMetaType<POJProblemCase>("POJProblemCase");
     qRegisterMetaType<QVector<int>>("QVector<int>");
     qRegisterMetaType<QHash<int,QString>>("QHash<int,QString>");
 
+    startupProfiler.startPhase("Init parser");
     initParser();
 
     try {
@@ -143,13 +156,20 @@ int main(int argc, char *argv[])
         pCharsetInfoManager = new CharsetInfoManager();
         auto charsetInfoManager = std::unique_ptr<CharsetInfoManager>(pCharsetInfoManager);
         //load settings
+        startupProfiler.startPhase("Load settings and compiler sets");
         pSettings = new Settings(settingFilename);
         auto settings = std::unique_ptr<Settings>(pSettings);
+        startupProfiler.setLogFilename(includeTrailingPathDelimiter(pSettings->dirs().config())
+                                       + DEV_STARTUP_PROFILE_FILE);
 
         //Color scheme settings must be loaded after translation
+        startupProfiler.startPhase("Load color schemes and icons");
         pColorManager = new ColorManager();
         pIconsManager = new IconsManager();
+        startupProfiler.startPhase("Load autolinks and compile cache");
         pAutolinkManager = new AutolinkManager();
+        pCompileCache = new CompileCache();
+        auto compileCache = std::unique_ptr<CompileCache>(pCompileCache);
         try {
             pAutolinkManager->load();
         } catch (FileError e) {
@@ -164,10 +184,9 @@ int main(int argc, char *argv[])
 
         MainWindow mainWindow;
         pMainWindow = &mainWindow;
-        if (app.arguments().count()>1) {
-            QStringList filesToOpen = app.arguments();
-            filesToOpen.pop_front();
-            pMainWindow->openFiles(filesToOpen);
+        startupProfiler.startPhase("Open files");
+        if (!arguments.isEmpty()) {
+            pMainWindow->openFiles(arguments);
         } else {
             if (pSettings->editor().autoLoadLastFiles())
                 pMainWindow->loadLastOpens();
@@ -181,7 +200,18 @@ int main(int argc, char *argv[])
         if (mainWindow.screen())
             setScreenDPI(mainWindow.screen()->logicalDotsPerInch());
 #endif
+        startupProfiler.startPhase("Show main window");
         mainWindow.show();
+        if (!profileStartup)
+            QTimer::singleShot(0, &mainWindow, &MainWindow::recoverUnsavedFiles);
+        if (profileStartup) {
+            QObject::connect(&startupProfiler, &StartupProfiler::profileFinished,
+                             &app, [&startupProfiler](){
+                QTextStream(stdout)<<startupProfiler.report();
+                QApplication::exit(0);
+            });
+        }
+        startupProfiler.watchFirstPaint(&mainWindow);
 #ifdef Q_OS_WIN
         WindowLogoutEventFilter filter;
         app.installNativeEventFilter(&filter);
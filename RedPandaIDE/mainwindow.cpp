@@ -54,6 +54,7 @@
 #include <QMessageBox>
 #include <QMimeData>
 #include <QScreen>
+#include <QScrollBar>
 #include <QTcpSocket>
 #include <QTemporaryFile>
 #include <QTextBlock>
@@ -67,6 +68,9 @@
 #include <QMessageBox>
 #include <QTextCodec>
 #include "cpprefacter.h"
+#include "startupprofiler.h"
+#include "lazyinitializer.h"
+#include "undojournal.h"
 
 #include <widgets/searchdialog.h>
 
@@ -98,6 +102,7 @@ MainWindow::MainWindow(QWidget *parent)
       mOpenningFiles(false),
       mSystemTurnedOff(false)
 {
+    pStartupProfiler->startPhase("Main window: setup ui");
     ui->setupUi(this);
     addActions( this->findChildren<QAction *>(QString(), Qt::FindChildrenRecursively));
     // status bar
@@ -134,14 +139,27 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::onCompilerSetChanged);
     //updateCompilerSet();
 
+    pStartupProfiler->startPhase("Main window: compiler and debugger");
     mCompilerManager = new CompilerManager(this);
     mDebugger = new Debugger(this);
 
     ui->tblBreakpoints->setModel(mDebugger->breakpointModel());
     ui->tblStackTrace->setModel(mDebugger->backtraceModel());
     ui->watchView->setModel(mDebugger->watchModel());
+    connect(ui->watchView, &QTreeView::collapsed,
+            mDebugger, &Debugger::collapseWatchVar);
     ui->tblMemoryView->setModel(mDebugger->memoryModel());
     ui->tblMemoryView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    connect(ui->tblMemoryView->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::updateMemoryViewVisibleRows);
+    connect(mDebugger->memoryModel(), &QAbstractItemModel::modelReset,
+            [this](){
+        int row = mDebugger->memoryModel()->rowOf(mDebugger->memoryModel()->startAddress());
+        if (row>=0)
+            ui->tblMemoryView->scrollTo(mDebugger->memoryModel()->index(row,0),
+                                        QAbstractItemView::PositionAtTop);
+        updateMemoryViewVisibleRows();
+    });
 
     try {
         mDebugger->breakpointModel()->load(includeTrailingPathDelimiter(pSettings->dirs().config())
@@ -164,6 +182,7 @@ MainWindow::MainWindow(QWidget *parent)
 //    ui->actionIndent->setShortcut(Qt::Key_Tab);
 //    ui->actionUnIndent->setShortcut(Qt::Key_Tab | Qt::ShiftModifier);
 
+    pStartupProfiler->startPhase("Main window: menus");
     mMenuNew = new QMenu();
     mMenuNew->setTitle(tr("New"));
     mMenuNew->addAction(ui->actionNew);
@@ -214,24 +233,12 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->cbMemoryAddress->lineEdit(), &QLineEdit::returnPressed,
             this, &MainWindow::onDebugMemoryAddressInput);
 
+    pStartupProfiler->startPhase("Main window: tools and bookmarks");
     mTodoParser = std::make_shared<TodoParser>();
-    mSymbolUsageManager = std::make_shared<SymbolUsageManager>();
-    try {
-        mSymbolUsageManager->load();
-    } catch (FileError &e) {
-        QMessageBox::warning(nullptr,
-                         tr("Error"),
-                         e.reason());
-    }
-
-    mCodeSnippetManager = std::make_shared<CodeSnippetsManager>();
-    try {
-        mCodeSnippetManager->load();
-    } catch (FileError &e) {
-        QMessageBox::warning(nullptr,
-                             tr("Error"),
-                             e.reason());
-    }
+    connect(mTodoParser.get(), &TodoParser::todosUpdated,
+            &mTodoModel, &TodoModel::setItems);
+    connect(mTodoParser.get(), &TodoParser::todosRemoved,
+            &mTodoModel, &TodoModel::removeItems);
     mToolsManager = std::make_shared<ToolsManager>();
     try {
         mToolsManager->load();
@@ -249,6 +256,7 @@ MainWindow::MainWindow(QWidget *parent)
                              tr("Error"),
                              e.reason());
     }
+    pStartupProfiler->startPhase("Main window: views and popups");
     ui->tableBookmark->setModel(mBookmarkModel.get());
     mSearchResultTreeModel = std::make_shared<SearchResultTreeModel>(&mSearchResultModel);
     mSearchResultListModel = std::make_shared<SearchResultListModel>(&mSearchResultModel);
@@ -285,12 +293,6 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::updateProblemTitle);
 
     //files view
-    ui->treeFiles->setModel(&mFileSystemModel);
-    mFileSystemModel.setReadOnly(false);
-    setFilesViewRoot(pSettings->environment().currentFolder());
-    for (int i=1;i<mFileSystemModel.columnCount();i++) {
-        ui->treeFiles->hideColumn(i);
-    }
     connect(ui->cbFilesPath->lineEdit(),&QLineEdit::returnPressed,
             this,&MainWindow::onFilesViewPathChanged);
     connect(ui->cbFilesPath, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -304,10 +306,7 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::onFileChanged);
 
     mStatementColors = std::make_shared<QHash<StatementKind, PColorSchemeItem> >();
-    mCompletionPopup = std::make_shared<CodeCompletionPopup>();
-    mCompletionPopup->setColors(mStatementColors);
-    mHeaderCompletionPopup = std::make_shared<HeaderCompletionPopup>();
-    mFunctionTip = std::make_shared<FunctionTooltipWidget>();
+    setupLazyInitializers();
 
     mClassBrowserModel.setColors(mStatementColors);
 
@@ -323,6 +322,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->actionEGE_Manual->setVisible(pSettings->environment().language()=="zh_CN");
 
+    pStartupProfiler->startPhase("Main window: apply settings");
     buildContextMenus();
     updateAppTitle();
     //applySettings();
@@ -509,6 +509,7 @@ void MainWindow::updateCompileActions()
         ui->actionRebuild->setEnabled(false);
         ui->actionDebug->setEnabled(false);
         ui->btnRunAllProblemCases->setEnabled(false);
+        ui->btnRunStressTest->setEnabled(false);
     } else {
         ui->actionCompile->setEnabled(true);
         ui->actionCompile_Run->setEnabled(true);
@@ -516,6 +517,7 @@ void MainWindow::updateCompileActions()
         ui->actionRebuild->setEnabled(true);
         ui->actionDebug->setEnabled(true);
         ui->btnRunAllProblemCases->setEnabled(true);
+        ui->btnRunStressTest->setEnabled(true);
     }
     if (!mDebugger->executing()) {
         disableDebugActions();
@@ -537,15 +539,9 @@ void MainWindow::updateEditorColorSchemes()
     mEditorList->applyColorSchemes(pSettings->editor().colorScheme());
     QString schemeName = pSettings->editor().colorScheme();
     pColorManager->updateStatementColors(mStatementColors,schemeName);
-    //color for code completion popup
+    updateCompletionPopupColors();
     PColorSchemeItem item;
     QColor baseColor = palette().color(QPalette::Base);
-    item = pColorManager->getItem(schemeName, SYNS_AttrPreprocessor);
-    if (item) {
-        mHeaderCompletionPopup->setSuggestionColor(item->foreground());
-    } else  {
-        mHeaderCompletionPopup->setSuggestionColor(palette().color(QPalette::Text));
-    }
     item = pColorManager->getItem(schemeName, COLOR_SCHEME_ERROR);
     if (item && haveGoodContrast(item->foreground(), baseColor)) {
         mErrorColor = item->foreground();
@@ -564,17 +560,36 @@ void MainWindow::updateEditorColorSchemes()
         QPalette pal = palette();
         pal.setColor(QPalette::Base,item->background());
         pal.setColor(QPalette::Text,item->foreground());
-        mCompletionPopup->setPalette(pal);
-        mHeaderCompletionPopup->setPalette(pal);
         ui->classBrowser->setPalette(pal);
     } else {
         QPalette pal = palette();
-        mCompletionPopup->setPalette(pal);
-        mHeaderCompletionPopup->setPalette(pal);
         ui->classBrowser->setPalette(pal);
     }
 }
 
+void MainWindow::updateCompletionPopupColors()
+{
+    if (!mCompletionPopupsInitializer->initialized())
+        return;
+    QString schemeName = pSettings->editor().colorScheme();
+    //color for code completion popup
+    PColorSchemeItem item;
+    item = pColorManager->getItem(schemeName, SYNS_AttrPreprocessor);
+    if (item) {
+        mHeaderCompletionPopup->setSuggestionColor(item->foreground());
+    } else  {
+        mHeaderCompletionPopup->setSuggestionColor(palette().color(QPalette::Text));
+    }
+    item = pColorManager->getItem(schemeName, COLOR_SCHEME_TEXT);
+    QPalette pal = palette();
+    if (item) {
+        pal.setColor(QPalette::Base,item->background());
+        pal.setColor(QPalette::Text,item->foreground());
+    }
+    mCompletionPopup->setPalette(pal);
+    mHeaderCompletionPopup->setPalette(pal);
+}
+
 void MainWindow::applySettings()
 {
     ThemeManager themeManager;
@@ -978,6 +993,8 @@ void MainWindow::updateForStatusbarModeInfo()
         } else {
             msg = tr("Overwrite");
         }
+        if (e->largeFileMode())
+            msg = tr("%1 (Large File)").arg(msg);
         mFileModeStatus->setText(msg);
     } else {
         mFileModeStatus->setText("");
@@ -1038,6 +1055,55 @@ void MainWindow::openFile(const QString &filename, QTabWidget* page)
     }
 }
 
+void MainWindow::recoverUnsavedFiles()
+{
+    foreach (const RecoveryJournal::PendingJournal& journal, RecoveryJournal::pendingJournals()) {
+        //the file was changed after the journal was written, the changes don't apply
+        if (!journal.baseValid) {
+            removeFile(journal.journalFilename);
+            continue;
+        }
+        if (QMessageBox::question(this,
+                                  tr("Recover unsaved changes"),
+                                  tr("Red Panda C++ didn't close normally while \"%1\" had unsaved changes.")
+                                  .arg(journal.sourceFilename)
+                                  +"<br /><br />"+tr("Do you want to recover them?"),
+                                  QMessageBox::Yes | QMessageBox::No,
+                                  QMessageBox::Yes) != QMessageBox::Yes) {
+            removeFile(journal.journalFilename);
+            continue;
+        }
+        Editor* e;
+        QStringList lines;
+        if (journal.untitled) {
+            newEditor();
+            e = mEditorList->getEditor();
+            //the changes start from the empty buffer, not the new file template
+            for (int i=0;i<journal.baseLineCount;i++)
+                lines.append(QString());
+        } else {
+            openFile(journal.sourceFilename);
+            e = mEditorList->getOpenedEditorByFilename(journal.sourceFilename);
+            if (!e || e->modified()) {
+                continue;
+            }
+            lines = e->contents();
+        }
+        if (!e)
+            continue;
+        if (RecoveryJournal::replay(journal.journalFilename, lines)) {
+            e->replaceContents(lines);
+            //the journal now holds the recovered changes of the editor
+            e->recoveryJournal()->checkpoint();
+            //the new buffer has a journal of its own
+            if (journal.untitled)
+                removeFile(journal.journalFilename);
+        } else {
+            removeFile(journal.journalFilename);
+        }
+    }
+}
+
 void MainWindow::openProject(const QString &filename, bool openFiles)
 {
     if (!fileExists(filename)) {
@@ -1089,6 +1155,7 @@ void MainWindow::openProject(const QString &filename, bool openFiles)
         scanActiveProject(true);
         if (openFiles)
             mProject->doAutoOpen();
+        scanProjectTodos();
 
         //update editor's inproject flag
         for (int i=0;i<mProject->units().count();i++) {
@@ -1315,9 +1382,11 @@ void MainWindow::updateActionIcons()
     pIconsManager->setIcon(ui->btnLoadProblemSet, IconsManager::ACTION_FILE_OPEN_FOLDER);
 
     pIconsManager->setIcon(ui->btnAddProblemCase, IconsManager::ACTION_MISC_ADD);
+    pIconsManager->setIcon(ui->btnAddProblemCaseFromFiles, IconsManager::ACTION_MISC_FOLDER);
     pIconsManager->setIcon(ui->btnRemoveProblemCase, IconsManager::ACTION_MISC_REMOVE);
     pIconsManager->setIcon(ui->btnOpenProblemAnswer, IconsManager::ACTION_PROBLEM_EDIT_SOURCE);
     pIconsManager->setIcon(ui->btnRunAllProblemCases, IconsManager::ACTION_PROBLEM_RUN_CASES);
+    pIconsManager->setIcon(ui->btnRunStressTest, IconsManager::ACTION_RUN_RUN);
     pIconsManager->setIcon(ui->btnCaseValidateOptions, IconsManager::ACTION_MISC_GEAR);
 
     mProblem_Properties->setIcon(pIconsManager->getIcon(IconsManager::ACTION_PROBLEM_PROPERTIES));
@@ -1369,6 +1438,8 @@ void MainWindow::checkSyntaxInBack(Editor *e)
 {
     if (e==nullptr)
         return;
+    if (e->largeFileMode())
+        return;
 
     if (!pSettings->editor().syntaxCheck()) {
         return;
@@ -1496,7 +1567,7 @@ void MainWindow::runExecutable(const QString &exeName,const QString &filename,Ru
         POJProblem problem = mOJProblemModel.problem();
         if (problem) {
             mCompilerManager->runProblem(exeName,params,QFileInfo(exeName).absolutePath(),
-                                         problem->cases);
+                                         problem->cases, problem->timeLimit, problem->memoryLimit);
             openCloseBottomPanel(true);
             ui->tabMessages->setCurrentWidget(ui->tabProblem);
         }
@@ -1504,8 +1575,38 @@ void MainWindow::runExecutable(const QString &exeName,const QString &filename,Ru
         QModelIndex index = ui->lstProblemCases->currentIndex();
         if (index.isValid()) {
             POJProblemCase problemCase =mOJProblemModel.getCase(index.row());
+            POJProblem problem = mOJProblemModel.problem();
             mCompilerManager->runProblem(exeName,params,QFileInfo(exeName).absolutePath(),
-                                     problemCase);
+                                     problemCase, problem->timeLimit, problem->memoryLimit);
+            openCloseBottomPanel(true);
+            ui->tabMessages->setCurrentWidget(ui->tabProblem);
+        }
+    } else if (runType == RunType::StressTest) {
+        POJProblem problem = mOJProblemModel.problem();
+        if (problem) {
+            if (problem->generatorProgram.isEmpty() || problem->bruteForceProgram.isEmpty()) {
+                QMessageBox::critical(this,tr("Stress Test"),
+                                      tr("Please set the generator and the brute force program in the problem's properties."));
+                return;
+            }
+            QString generatorExe = getCompiledExecutableName(problem->generatorProgram);
+            QString bruteForceExe = getCompiledExecutableName(problem->bruteForceProgram);
+            foreach (const QString& source, QStringList({problem->generatorProgram, problem->bruteForceProgram})) {
+                QString exe = getCompiledExecutableName(source);
+                if (!fileExists(exe) || compareFileModifiedTime(source,exe)>=0) {
+                    QMessageBox::critical(this,tr("Stress Test"),
+                                          tr("'%1' is not compiled, or is more recent than its executable.").arg(source)
+                                          +"<br /><br />"+tr("Please compile it first."));
+                    return;
+                }
+            }
+            mStressTestProblem = problem;
+            mCompilerManager->runProblemStressTest(exeName,params,QFileInfo(exeName).absolutePath(),
+                                                   generatorExe, bruteForceExe,
+                                                   problem->timeLimit, problem->memoryLimit);
+            ui->pbProblemCases->setMaximum(0);
+            ui->pbProblemCases->setValue(0);
+            ui->pbProblemCases->setVisible(true);
             openCloseBottomPanel(true);
             ui->tabMessages->setCurrentWidget(ui->tabProblem);
         }
@@ -1892,6 +1993,18 @@ void MainWindow::doAutoSave(Editor *e)
         case assOverwrite:
             e->save();
             return;
+        case assRecoveryJournal:
+            //journal the changed lines, and only save the whole file once editing pauses
+            if (!e->modified())
+                return;
+            //an untitled buffer has no file to save to
+            if (!e->isNew()
+                    && e->lastModifyTime().secsTo(QDateTime::currentDateTime()) >= AUTO_SAVE_IDLE_SECONDS) {
+                e->save();
+            } else {
+                e->recoveryJournal()->checkpoint();
+            }
+            return;
         case assAppendUnixTimestamp:
             filename = parent.filePath(
                         QString("%1.%2.%3")
@@ -2178,9 +2291,17 @@ void MainWindow::buildContextMenus()
         dialog.setName(problem->name);
         dialog.setUrl(problem->url);
         dialog.setDescription(problem->description);
+        dialog.setTimeLimit(problem->timeLimit);
+        dialog.setMemoryLimit(problem->memoryLimit);
+        dialog.setGeneratorProgram(problem->generatorProgram);
+        dialog.setBruteForceProgram(problem->bruteForceProgram);
         if (dialog.exec() == QDialog::Accepted) {
             problem->url = dialog.url();
             problem->description = dialog.description();
+            problem->timeLimit = dialog.timeLimit();
+            problem->memoryLimit = dialog.memoryLimit();
+            problem->generatorProgram = dialog.generatorProgram();
+            problem->bruteForceProgram = dialog.bruteForceProgram();
             if (problem == mOJProblemModel.problem()) {
                 updateProblemTitle();
             }
@@ -2424,6 +2545,30 @@ void MainWindow::buildContextMenus()
             }
         }
     });
+    mBreakpointViewLogMessageAction = createActionFor(
+                tr("Tracepoint log message..."),
+                ui->tblBreakpoints);
+    connect(mBreakpointViewLogMessageAction,&QAction::triggered,
+            [this](){
+        int index =ui->tblBreakpoints->selectionModel()->currentIndex().row();
+
+        PBreakpoint breakpoint = debugger()->breakpointModel()->breakpoint(
+                    index
+                    );
+        if (breakpoint) {
+            bool isOk;
+            QString s=QInputDialog::getText(this,
+                                      tr("Tracepoint log message"),
+                                      tr("Enter the dprintf format and arguments (e.g. \"i=%d\\n\",i).")
+                                      +"\n"
+                                      +tr("The program won't stop at a tracepoint. Leave it empty to use a normal breakpoint."),
+                                    QLineEdit::Normal,
+                                    breakpoint->logMessage,&isOk);
+            if (isOk) {
+                pMainWindow->debugger()->setBreakPointLogMessage(index,s.trimmed());
+            }
+        }
+    });
     mBreakpointViewRemoveAllAction = createActionFor(
                 tr("Remove All Breakpoints"),
                 ui->tblBreakpoints);
@@ -2914,9 +3059,11 @@ void MainWindow::onBreakpointsViewContextMenu(const QPoint &pos)
 {
     QMenu menu(this);
     menu.addAction(mBreakpointViewPropertyAction);
+    menu.addAction(mBreakpointViewLogMessageAction);
     menu.addAction(mBreakpointViewRemoveAllAction);
     menu.addAction(mBreakpointViewRemoveAction);
     mBreakpointViewPropertyAction->setEnabled(ui->tblBreakpoints->currentIndex().isValid());
+    mBreakpointViewLogMessageAction->setEnabled(ui->tblBreakpoints->currentIndex().isValid());
     mBreakpointViewRemoveAction->setEnabled(ui->tblBreakpoints->currentIndex().isValid());
     menu.exec(ui->tblBreakpoints->mapToGlobal(pos));
 }
@@ -3163,17 +3310,30 @@ void MainWindow::onProblemCaseIndexChanged(const QModelIndex &current, const QMo
     QModelIndex idx = current;
     if (previous.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(previous.row());
-        problemCase->input = ui->txtProblemCaseInput->toPlainText();
-        problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
+        if (problemCase->inputFileName.isEmpty())
+            problemCase->input = ui->txtProblemCaseInput->toPlainText();
+        if (problemCase->expectedOutputFileName.isEmpty())
+            problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
     }
     if (idx.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(idx.row());
         if (problemCase) {
             ui->btnRemoveProblemCase->setEnabled(true);
-            ui->txtProblemCaseInput->setPlainText(problemCase->input);
-            ui->txtProblemCaseInput->setReadOnly(false);
-            ui->txtProblemCaseExpected->setPlainText(problemCase->expected);
-            ui->txtProblemCaseExpected->setReadOnly(false);
+            //cases in files are only previewed, and can't be edited here
+            if (problemCase->inputFileName.isEmpty()) {
+                ui->txtProblemCaseInput->setPlainText(problemCase->input);
+                ui->txtProblemCaseInput->setReadOnly(false);
+            } else {
+                ui->txtProblemCaseInput->setPlainText(readProblemCaseFilePreview(problemCase->inputFileName));
+                ui->txtProblemCaseInput->setReadOnly(true);
+            }
+            if (problemCase->expectedOutputFileName.isEmpty()) {
+                ui->txtProblemCaseExpected->setPlainText(problemCase->expected);
+                ui->txtProblemCaseExpected->setReadOnly(false);
+            } else {
+                ui->txtProblemCaseExpected->setPlainText(readProblemCaseFilePreview(problemCase->expectedOutputFileName));
+                ui->txtProblemCaseExpected->setReadOnly(true);
+            }
             ui->txtProblemCaseOutput->clear();
             ui->txtProblemCaseOutput->setPlainText(problemCase->output);
             updateProblemCaseOutput(problemCase);
@@ -3240,6 +3400,8 @@ void MainWindow::onNewProblemConnection()
         POJProblem problem = std::make_shared<OJProblem>();
         problem->name = name;
         problem->url = obj["url"].toString();
+        problem->timeLimit = obj["timeLimit"].toInt();
+        problem->memoryLimit = obj["memoryLimit"].toInt();
         QJsonArray caseArray = obj["tests"].toArray();
         foreach ( const QJsonValue& val, caseArray) {
             QJsonObject caseObj = val.toObject();
@@ -3279,7 +3441,7 @@ void MainWindow::onShowInsertCodeSnippetMenu()
 {
     mMenuInsertCodeSnippet->clear();
     QList<PCodeSnippet> snippets;
-    foreach (const PCodeSnippet& snippet, mCodeSnippetManager->snippets()) {
+    foreach (const PCodeSnippet& snippet, codeSnippetManager()->snippets()) {
         if (snippet->section>=0 && !snippet->caption.isEmpty())
             snippets.append(snippet);
     }
@@ -3497,21 +3659,6 @@ void MainWindow::enableDebugActions()
     }
 }
 
-void MainWindow::onTodoParseStarted(const QString&)
-{
-    mTodoModel.clear();
-}
-
-void MainWindow::onTodoParsing(const QString& filename, int lineNo, int ch, const QString& line)
-{
-    mTodoModel.addItem(filename,lineNo,ch,line);
-}
-
-void MainWindow::onTodoParseFinished()
-{
-
-}
-
 void MainWindow::prepareProjectForCompile()
 {
     if (!mProject)
@@ -3603,10 +3750,28 @@ void MainWindow::closeProject(bool refreshEditor)
             // Clear error browser
             clearIssues();
             updateProjectView();
+            // only keep todos of the opened files
+            mTodoParser->clear();
+            mTodoModel.clear();
+            for (int i=0;i<mEditorList->pageCount();i++) {
+                mTodoParser->parseEditor((*mEditorList)[i]);
+            }
         }
     }
 }
 
+void MainWindow::scanProjectTodos()
+{
+    if (!mProject)
+        return;
+    QStringList files;
+    foreach (const PProjectUnit& unit, mProject->units()) {
+        if (!mEditorList->getOpenedEditorByFilename(unit->fileName()))
+            files.append(unit->fileName());
+    }
+    mTodoParser->parseFiles(files);
+}
+
 void MainWindow::updateProjectView()
 {
     if (mProject) {
@@ -3679,21 +3844,56 @@ void MainWindow::onFilesViewPathChanged()
     ui->cbFilesPath->blockSignals(false);
 }
 
-const std::shared_ptr<HeaderCompletionPopup> &MainWindow::headerCompletionPopup() const
+const std::shared_ptr<HeaderCompletionPopup> &MainWindow::headerCompletionPopup()
 {
+    mCompletionPopupsInitializer->ensure();
     return mHeaderCompletionPopup;
 }
 
-const std::shared_ptr<FunctionTooltipWidget> &MainWindow::functionTip() const
+const std::shared_ptr<FunctionTooltipWidget> &MainWindow::functionTip()
 {
+    mCompletionPopupsInitializer->ensure();
     return mFunctionTip;
 }
 
-const std::shared_ptr<CodeCompletionPopup> &MainWindow::completionPopup() const
+const std::shared_ptr<CodeCompletionPopup> &MainWindow::completionPopup()
 {
+    mCompletionPopupsInitializer->ensure();
     return mCompletionPopup;
 }
 
+bool MainWindow::isCompletionPopupVisible() const
+{
+    //the initializer is marked as initialized before it creates the popups
+    return mCompletionPopup && mCompletionPopup->isVisible();
+}
+
+bool MainWindow::isHeaderCompletionPopupVisible() const
+{
+    return mHeaderCompletionPopup && mHeaderCompletionPopup->isVisible();
+}
+
+bool MainWindow::isFunctionTipVisible() const
+{
+    return mFunctionTip && mFunctionTip->isVisible();
+}
+
+void MainWindow::hideFunctionTip()
+{
+    if (mFunctionTip)
+        mFunctionTip->hide();
+}
+
+void MainWindow::hideCompletionPopups()
+{
+    if (mHeaderCompletionPopup)
+        mHeaderCompletionPopup->hide();
+    if (mCompletionPopup)
+        mCompletionPopup->hide();
+    if (mFunctionTip)
+        mFunctionTip->hide();
+}
+
 SearchDialog *MainWindow::searchDialog() const
 {
     return mSearchDialog;
@@ -3846,6 +4046,10 @@ void MainWindow::closeEvent(QCloseEvent *event) {
         event->ignore();
         return ;
     }
+    //the editors have written their journals by now
+    if (!mShouldRemoveAllSettings && pSettings->editor().persistentUndo())
+        UndoJournal::prune(qMax((qint64)UNDO_JOURNAL_MIN_TOTAL_SIZE,
+                                    (qint64)pSettings->editor().undoJournalSize()*1024*1024*4));
 
     if (!mShouldRemoveAllSettings && pSettings->editor().autoLoadLastFiles()) {
         if (mProject) {
@@ -3857,8 +4061,9 @@ void MainWindow::closeEvent(QCloseEvent *event) {
     mCompilerManager->stopAllRunners();
     mCompilerManager->stopCompile();
     mCompilerManager->stopRun();
-    if (!mShouldRemoveAllSettings)
+    if (!mShouldRemoveAllSettings && mSymbolUsageInitializer->initialized())
         mSymbolUsageManager->save();
+    RecoveryJournal::waitForWrites();
     event->accept();
     return;
 }
@@ -4081,6 +4286,9 @@ void MainWindow::onCompileFinished(bool isCheckSyntax)
             case MainWindow::CompileSuccessionTaskType::RunCurrentProblemCase:
                 runExecutable(mCompileSuccessionTask->filename,QString(),RunType::CurrentProblemCase);
                 break;
+            case MainWindow::CompileSuccessionTaskType::RunStressTest:
+                runExecutable(mCompileSuccessionTask->filename,QString(),RunType::StressTest);
+                break;
             case MainWindow::CompileSuccessionTaskType::Debug:
                 debug();
                 break;
@@ -4149,6 +4357,7 @@ void MainWindow::onRunPausingForFinish()
 
 void MainWindow::onRunProblemFinished()
 {
+    mStressTestProblem.reset();
     updateProblemTitle();
     ui->pbProblemCases->setVisible(false);
     updateCompileActions();
@@ -4165,11 +4374,14 @@ void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total
         POJProblemCase problemCase = mOJProblemModel.getCase(row);
         problemCase->testState = ProblemCaseTestState::Testing;
         mOJProblemModel.update(row);
+        // cases are run in parallel, only select a case if none is selected,
+        // and only clear the output of the selected one
         QModelIndex idx = ui->lstProblemCases->currentIndex();
-        if (!idx.isValid() || row != idx.row()) {
+        if (!idx.isValid()) {
             ui->lstProblemCases->setCurrentIndex(mOJProblemModel.index(row,0));
+        } else if (row == idx.row()) {
+            ui->txtProblemCaseOutput->clear();
         }
-        ui->txtProblemCaseOutput->clear();
     }
 }
 
@@ -4179,22 +4391,63 @@ void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int tot
     if (row>=0) {
         POJProblemCase problemCase = mOJProblemModel.getCase(row);
         ProblemCaseValidator validator;
-        problemCase->testState = validator.validate(problemCase,pSettings->executor().ignoreSpacesWhenValidatingCases())?
-                    ProblemCaseTestState::Passed:
-                    ProblemCaseTestState::Failed;
+        if (pSettings->executor().enableFloatToleranceWhenValidatingCases())
+            validator.setFloatTolerance(pSettings->executor().floatToleranceWhenValidatingCases());
+        problemCase->mismatchLine = 0;
+        problemCase->mismatchColumn = 0;
+        if (problemCase->timeLimitExceeded) {
+            problemCase->testState = ProblemCaseTestState::TimeLimitExceeded;
+        } else if (problemCase->memoryLimitExceeded) {
+            problemCase->testState = ProblemCaseTestState::MemoryLimitExceeded;
+        } else if (validator.validate(problemCase,pSettings->executor().ignoreSpacesWhenValidatingCases())) {
+            problemCase->testState = ProblemCaseTestState::Passed;
+        } else {
+            problemCase->testState = ProblemCaseTestState::Failed;
+            problemCase->mismatchLine = validator.mismatchLine();
+            problemCase->mismatchColumn = validator.mismatchColumn();
+        }
         mOJProblemModel.update(row);
-        updateProblemCaseOutput(problemCase);
+        QModelIndex idx = ui->lstProblemCases->currentIndex();
+        if (idx.isValid() && row == idx.row())
+            updateProblemCaseOutput(problemCase);
     }
     ui->pbProblemCases->setMaximum(total);
     ui->pbProblemCases->setValue(current);
     updateProblemTitle();
 }
 
-void MainWindow::onOJProblemCaseNewOutputGetted(const QString &/* id */, const QString &line)
+void MainWindow::onOJProblemCaseNewOutputGetted(const QString &id, const QString &line)
 {
+    // cases are run in parallel, only show the output of the selected one
+    QModelIndex idx = ui->lstProblemCases->currentIndex();
+    if (!idx.isValid() || mOJProblemModel.getCase(idx.row())->getId()!=id)
+        return;
     ui->txtProblemCaseOutput->appendPlainText(line);
 }
 
+void MainWindow::onOJProblemStressIterationsUpdated(qint64 iterations, double iterationsPerSecond)
+{
+    updateStatusbarMessage(tr("Stress test: %1 iterations, %2 iterations/s")
+                           .arg(iterations)
+                           .arg(iterationsPerSecond,0,'f',1));
+}
+
+void MainWindow::onOJProblemStressCaseFound(POJProblemCase problemCase, const QString &reason)
+{
+    POJProblem problem = mStressTestProblem;
+    if (!problem)
+        return;
+    if (problem == mOJProblemModel.problem()) {
+        mOJProblemModel.addCase(problemCase);
+        ui->lstProblemCases->setCurrentIndex(mOJProblemModel.index(mOJProblemModel.count()-1));
+    } else {
+        problem->cases.append(problemCase);
+    }
+    QMessageBox::information(this,tr("Stress Test"),
+                             tr("Found a failing input: %1.").arg(reason)
+                             +"<br /><br />"+tr("It's saved as the problem case '%1'.").arg(problemCase->name));
+}
+
 void MainWindow::cleanUpCPUDialog()
 {
     CPUDialog* ptr=mCPUDialog;
@@ -4579,10 +4832,21 @@ void MainWindow::onDebugMemoryAddressInput()
     if (!s.isEmpty()) {
 //        connect(mDebugger, &Debugger::memoryExamineReady,
 //                   this, &MainWindow::onMemoryExamineReady);
-        mDebugger->sendCommand("-data-read-memory",QString("%1 x 1 8 8 ").arg(s));
+        mDebugger->sendCommand("-data-read-memory",QString("%1 x 1 1 1").arg(s));
     }
 }
 
+void MainWindow::updateMemoryViewVisibleRows()
+{
+    int firstRow = ui->tblMemoryView->rowAt(0);
+    if (firstRow<0)
+        return;
+    int lastRow = ui->tblMemoryView->rowAt(ui->tblMemoryView->viewport()->height()-1);
+    if (lastRow<0)
+        lastRow = mDebugger->memoryModel()->rowCount(QModelIndex())-1;
+    mDebugger->memoryModel()->setVisibleRows(firstRow,lastRow);
+}
+
 void MainWindow::onParserProgress(const QString &fileName, int total, int current)
 {
     // Mention every 5% progress
@@ -5325,11 +5589,13 @@ const PTodoParser &MainWindow::todoParser() const
 
 PCodeSnippetManager &MainWindow::codeSnippetManager()
 {
+    mCodeSnippetsInitializer->ensure();
     return mCodeSnippetManager;
 }
 
 PSymbolUsageManager &MainWindow::symbolUsageManager()
 {
+    mSymbolUsageInitializer->ensure();
     return mSymbolUsageManager;
 }
 
@@ -5484,6 +5750,7 @@ void MainWindow::invalidateProjectProxyModel()
 
 void MainWindow::onEditorRenamed(const QString &oldFilename, const QString &newFilename, bool firstSave)
 {
+    mTodoParser->removeFile(oldFilename);
     if (firstSave)
         mOJProblemSetModel.updateProblemAnswerFilename(oldFilename, newFilename);
 }
@@ -5502,6 +5769,10 @@ void MainWindow::on_tableTODO_doubleClicked(const QModelIndex &index)
     PTodoItem item = mTodoModel.getItem(index);
     if (item) {
         Editor * editor = mEditorList->getOpenedEditorByFilename(item->filename);
+        if (!editor) {
+            openFile(item->filename);
+            editor = mEditorList->getOpenedEditorByFilename(item->filename);
+        }
         if (editor) {
             editor->setCaretPositionAndActivate(item->lineNo,item->ch+1);
         }
@@ -5612,6 +5883,7 @@ void MainWindow::showSearchReplacePanel(bool show)
 
 void MainWindow::setFilesViewRoot(const QString &path)
 {
+    mFilesViewInitializer->ensure();
     mFileSystemModel.setRootPath(path);
     ui->treeFiles->setRootIndex(mFileSystemModel.index(path));
     pSettings->environment().setCurrentFolder(path);
@@ -5626,6 +5898,57 @@ void MainWindow::setFilesViewRoot(const QString &path)
     ui->cbFilesPath->lineEdit()->setCursorPosition(1);
 }
 
+void MainWindow::setupLazyInitializers()
+{
+    mCompletionPopupsInitializer = new LazyInitializer(
+                "Code completion popups",
+                [this](){
+        mCompletionPopup = std::make_shared<CodeCompletionPopup>();
+        mCompletionPopup->setColors(mStatementColors);
+        mHeaderCompletionPopup = std::make_shared<HeaderCompletionPopup>();
+        mFunctionTip = std::make_shared<FunctionTooltipWidget>();
+        updateCompletionPopupColors();
+    }, this);
+
+    mSymbolUsageInitializer = new LazyInitializer(
+                "Symbol usage manager",
+                [this](){
+        mSymbolUsageManager = std::make_shared<SymbolUsageManager>();
+        try {
+            mSymbolUsageManager->load();
+        } catch (FileError &e) {
+            QMessageBox::warning(nullptr,
+                             tr("Error"),
+                             e.reason());
+        }
+    }, this);
+
+    mCodeSnippetsInitializer = new LazyInitializer(
+                "Code snippets manager",
+                [this](){
+        mCodeSnippetManager = std::make_shared<CodeSnippetsManager>();
+        try {
+            mCodeSnippetManager->load();
+        } catch (FileError &e) {
+            QMessageBox::warning(nullptr,
+                                 tr("Error"),
+                                 e.reason());
+        }
+    }, this);
+
+    mFilesViewInitializer = new LazyInitializer(
+                "Files view",
+                [this](){
+        ui->treeFiles->setModel(&mFileSystemModel);
+        mFileSystemModel.setReadOnly(false);
+        setFilesViewRoot(pSettings->environment().currentFolder());
+        for (int i=1;i<mFileSystemModel.columnCount();i++) {
+            ui->treeFiles->hideColumn(i);
+        }
+    }, this);
+    mFilesViewInitializer->initializeOnShow(ui->treeFiles);
+}
+
 void MainWindow::clearIssues()
 {
     int i = ui->tabMessages->indexOf(ui->tabIssues);
@@ -5645,6 +5968,9 @@ void MainWindow::doCompileRun(RunType runType)
     case RunType::ProblemCases:
         mCompileSuccessionTask->type = CompileSuccessionTaskType::RunProblemCases;
         break;
+    case RunType::StressTest:
+        mCompileSuccessionTask->type = CompileSuccessionTaskType::RunStressTest;
+        break;
     default:
         mCompileSuccessionTask->type = CompileSuccessionTaskType::RunNormal;
     }
@@ -5653,29 +5979,17 @@ void MainWindow::doCompileRun(RunType runType)
 
 void MainWindow::updateProblemCaseOutput(POJProblemCase problemCase)
 {
-    if (problemCase->testState == ProblemCaseTestState::Failed) {
-        QStringList output = textToLines(problemCase->output);
-        QStringList expected = textToLines(problemCase->expected);
-        for (int i=0;i<output.count();i++) {
-            if (i>=expected.count() || output[i]!=expected[i]) {
-                QTextBlock block = ui->txtProblemCaseOutput->document()->findBlockByLineNumber(i);
-                QTextCursor cur(block);
-                cur.select(QTextCursor::LineUnderCursor);
-                QTextCharFormat format = cur.charFormat();
-                format.setUnderlineColor(mErrorColor);
-                format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
-                cur.setCharFormat(format);
-            }
-        }
-        if (output.count()<expected.count()) {
-            QTextBlock block = ui->txtProblemCaseOutput->document()->findBlockByLineNumber(output.count()-1);
-            QTextCursor cur(block);
-            cur.select(QTextCursor::LineUnderCursor);
-            QTextCharFormat format = cur.charFormat();
-            format.setUnderlineColor(mErrorColor);
-            format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
-            cur.setCharFormat(format);
-        }
+    if (problemCase->testState == ProblemCaseTestState::Failed
+            && problemCase->mismatchLine>0) {
+        QTextDocument* document = ui->txtProblemCaseOutput->document();
+        int line = std::min(problemCase->mismatchLine, document->blockCount());
+        QTextBlock block = document->findBlockByNumber(line-1);
+        QTextCursor cur(block);
+        cur.select(QTextCursor::LineUnderCursor);
+        QTextCharFormat format = cur.charFormat();
+        format.setUnderlineColor(mErrorColor);
+        format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        cur.setCharFormat(format);
     }
 }
 
@@ -5685,8 +5999,10 @@ void MainWindow::applyCurrentProblemCaseChanges()
     if (idx.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(idx.row());
         if (problemCase) {
-            problemCase->input = ui->txtProblemCaseInput->toPlainText();
-            problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
+            if (problemCase->inputFileName.isEmpty())
+                problemCase->input = ui->txtProblemCaseInput->toPlainText();
+            if (problemCase->expectedOutputFileName.isEmpty())
+                problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
         }
     }
 }
@@ -6043,12 +6359,46 @@ void MainWindow::on_btnAddProblemCase_clicked()
     ui->lstProblemCases->setCurrentIndex(mOJProblemModel.index(mOJProblemModel.count()-1));
 }
 
+void MainWindow::on_btnAddProblemCaseFromFiles_clicked()
+{
+    QString inputFileName = QFileDialog::getOpenFileName(
+                this,
+                tr("Choose Input File"),
+                QString(),
+                tr("All files (*.*)"));
+    if (inputFileName.isEmpty())
+        return;
+    QString expectedFileName = QFileDialog::getOpenFileName(
+                this,
+                tr("Choose Expected Output File"),
+                QFileInfo(inputFileName).absolutePath(),
+                tr("All files (*.*)"));
+    if (expectedFileName.isEmpty())
+        return;
+    on_btnAddProblemCase_clicked();
+    QModelIndex idx = ui->lstProblemCases->currentIndex();
+    if (!idx.isValid())
+        return;
+    POJProblemCase problemCase = mOJProblemModel.getCase(idx.row());
+    problemCase->name = QFileInfo(inputFileName).completeBaseName();
+    problemCase->inputFileName = inputFileName;
+    problemCase->expectedOutputFileName = expectedFileName;
+    mOJProblemModel.update(idx.row());
+    onProblemCaseIndexChanged(idx, QModelIndex());
+}
+
 void MainWindow::on_btnRunAllProblemCases_clicked()
 {
     applyCurrentProblemCaseChanges();
     runExecutable(RunType::ProblemCases);
 }
 
+void MainWindow::on_btnRunStressTest_clicked()
+{
+    applyCurrentProblemCaseChanges();
+    runExecutable(RunType::StressTest);
+}
+
 
 void MainWindow::on_actionC_Reference_triggered()
 {
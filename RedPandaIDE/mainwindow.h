@@ -51,7 +51,8 @@ enum class CompileTarget {
 enum class RunType {
     Normal,
     CurrentProblemCase,
-    ProblemCases
+    ProblemCases,
+    StressTest
 };
 
 class EditorList;
@@ -65,6 +66,7 @@ class QPlainTextEdit;
 class SearchDialog;
 class Project;
 class ColorSchemeItem;
+class LazyInitializer;
 
 class MainWindow : public QMainWindow
 {
@@ -75,6 +77,7 @@ class MainWindow : public QMainWindow
         RunNormal,
         RunProblemCases,
         RunCurrentProblemCase,
+        RunStressTest,
         Debug,
         Profile
     };
@@ -151,11 +154,18 @@ public:
 
     SearchResultModel* searchResultModel();
 
-    const std::shared_ptr<CodeCompletionPopup> &completionPopup() const;
+    const std::shared_ptr<CodeCompletionPopup> &completionPopup();
 
-    const std::shared_ptr<HeaderCompletionPopup> &headerCompletionPopup() const;
+    const std::shared_ptr<HeaderCompletionPopup> &headerCompletionPopup();
 
-    const std::shared_ptr<FunctionTooltipWidget> &functionTip() const;
+    const std::shared_ptr<FunctionTooltipWidget> &functionTip();
+
+    //these don't create the popups, which can't be visible before they are created
+    bool isCompletionPopupVisible() const;
+    bool isHeaderCompletionPopupVisible() const;
+    bool isFunctionTipVisible() const;
+    void hideFunctionTip();
+    void hideCompletionPopups();
 
     CaretList &caretList();
     void updateCaretActions();
@@ -177,6 +187,7 @@ public:
     const PBookmarkModel &bookmarkModel() const;
 
     void openFile(const QString& filename, QTabWidget* page=nullptr);
+    void recoverUnsavedFiles();
     void openProject(const QString& filename, bool openFiles = true);
     void changeOptions(const QString& widgetName=QString(), const QString& groupName=QString());
 
@@ -195,6 +206,8 @@ public slots:
     void onOJProblemCaseStarted(const QString& id, int current, int total);
     void onOJProblemCaseFinished(const QString& id, int current, int total);
     void onOJProblemCaseNewOutputGetted(const QString& id, const QString& line);
+    void onOJProblemStressIterationsUpdated(qint64 iterations, double iterationsPerSecond);
+    void onOJProblemStressCaseFound(POJProblemCase problemCase, const QString& reason);
     void cleanUpCPUDialog();
     void onDebugCommandInput(const QString& command);
     void onDebugEvaluateInput();
@@ -210,9 +223,6 @@ public slots:
     void onEditorTabContextMenu(QTabWidget* tabWidget, const QPoint& pos);
     void disableDebugActions();
     void enableDebugActions();
-    void onTodoParseStarted(const QString& filename);
-    void onTodoParsing(const QString& filename, int lineNo, int ch, const QString& line);
-    void onTodoParseFinished();
     void setActiveBreakpoint(QString FileName, int Line, bool setFocus);
     void updateDPI();
 
@@ -238,6 +248,9 @@ private:
     void includeOrSkipDirs(const QStringList& dirs, bool skip);
     void showSearchReplacePanel(bool show);
     void setFilesViewRoot(const QString& path);
+    void setupLazyInitializers();
+    void scanProjectTodos();
+    void updateCompletionPopupColors();
     void clearIssues();
     void doCompileRun(RunType runType);
     void updateProblemCaseOutput(POJProblemCase problemCase);
@@ -258,6 +271,7 @@ private slots:
     void onFilesViewPathChanged();
 
     void onWatchViewContextMenu(const QPoint& pos);
+    void updateMemoryViewVisibleRows();
     void onBookmarkContextMenu(const QPoint& pos);
     void onTableIssuesContextMenu(const QPoint& pos);
     void onSearchViewContextMenu(const QPoint& pos);
@@ -511,8 +525,12 @@ private slots:
 
     void on_btnAddProblemCase_clicked();
 
+    void on_btnAddProblemCaseFromFiles_clicked();
+
     void on_btnRunAllProblemCases_clicked();
 
+    void on_btnRunStressTest_clicked();
+
     void on_actionC_Reference_triggered();
 
     void on_btnRemoveProblemCase_clicked();
@@ -596,6 +614,12 @@ private:
     std::shared_ptr<HeaderCompletionPopup> mHeaderCompletionPopup;
     std::shared_ptr<FunctionTooltipWidget> mFunctionTip;
 
+    //subsystems not needed to show the first editor are created on first use
+    LazyInitializer* mCompletionPopupsInitializer;
+    LazyInitializer* mSymbolUsageInitializer;
+    LazyInitializer* mCodeSnippetsInitializer;
+    LazyInitializer* mFilesViewInitializer;
+
     TodoModel mTodoModel;
     SearchResultModel mSearchResultModel;
     PBookmarkModel mBookmarkModel;
@@ -611,6 +635,7 @@ private:
     QFileSystemModel mFileSystemModel;
     OJProblemSetModel mOJProblemSetModel;
     OJProblemModel mOJProblemModel;
+    POJProblem mStressTestProblem;
     int mOJProblemSetNameCounter;
 
     bool mCheckSyntaxInBack;
@@ -648,6 +673,7 @@ private:
 
     //actions for breakpoint view
     QAction * mBreakpointViewPropertyAction;
+    QAction * mBreakpointViewLogMessageAction;
     QAction * mBreakpointViewRemoveAllAction;
     QAction * mBreakpointViewRemoveAction;
 
@@ -16,15 +16,52 @@
  */
 #include "ojproblemset.h"
 
+#include <QFile>
 #include <QUuid>
 
-OJProblemCase::OJProblemCase()
+OJProblemCase::OJProblemCase():
+    testState(ProblemCaseTestState::NotTested),
+    outputTruncated(false),
+    runningTime(0),
+    cpuTime(0),
+    peakMemory(0),
+    timeLimitExceeded(false),
+    memoryLimitExceeded(false),
+    mismatchLine(0),
+    mismatchColumn(0)
 {
     QUuid uid = QUuid::createUuid();
     id = uid.toString();
 }
 
+OJProblemCase::~OJProblemCase()
+{
+    if (!outputFileName.isEmpty())
+        QFile::remove(outputFileName);
+}
+
 const QString &OJProblemCase::getId() const
 {
     return id;
 }
+
+OJProblem::OJProblem():
+    timeLimit(0),
+    memoryLimit(0)
+{
+
+}
+
+QString readProblemCaseFilePreview(const QString &fileName, bool *truncated)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        if (truncated)
+            *truncated = false;
+        return QString();
+    }
+    QByteArray content = file.read(OJ_CASE_PREVIEW_SIZE);
+    if (truncated)
+        *truncated = !file.atEnd();
+    return QString::fromLocal8Bit(content);
+}
@@ -19,21 +19,39 @@
 #include <QString>
 #include <memory>
 #include <QVector>
+#include <QMetaType>
+
+//max size (in bytes) of case data loaded for display
+#define OJ_CASE_PREVIEW_SIZE (256*1024)
 
 enum class ProblemCaseTestState {
     NotTested,
     Testing,
     Passed,
-    Failed
+    Failed,
+    TimeLimitExceeded,
+    MemoryLimitExceeded
 };
 
 struct OJProblemCase {
     QString name;
-    QString input;
-    QString expected;
+    QString input; // not used if inputFileName is set
+    QString expected; // not used if expectedOutputFileName is set
+    QString inputFileName; // read input from the file, instead of keeping it in memory
+    QString expectedOutputFileName;
     ProblemCaseTestState testState; // no persistence
-    QString output; // no persistence
+    QString output; // beginning of the output, no persistence
+    QString outputFileName; // temp file holding the whole output, no persistence
+    bool outputTruncated; // output is shorter than the output file, no persistence
+    qint64 runningTime; // wall time in ms, no persistence
+    qint64 cpuTime; // user+system time in ms, no persistence
+    qint64 peakMemory; // peak resident memory in KB, no persistence
+    bool timeLimitExceeded; // no persistence
+    bool memoryLimitExceeded; // no persistence
+    int mismatchLine; // 1-based position of the first mismatch in output, 0 for none, no persistence
+    int mismatchColumn; // no persistence
     OJProblemCase();
+    ~OJProblemCase();
 
 public:
     const QString &getId() const;
@@ -44,12 +62,22 @@ private:
 
 using POJProblemCase = std::shared_ptr<OJProblemCase>;
 
+Q_DECLARE_METATYPE(POJProblemCase);
+
+//load at most OJ_CASE_PREVIEW_SIZE bytes of the file
+QString readProblemCaseFilePreview(const QString& fileName, bool* truncated = nullptr);
+
 struct OJProblem {
     QString name;
     QString url;
     QString description;
     QString answerProgram;
+    QString generatorProgram; // source of the random input generator used by stress tests
+    QString bruteForceProgram; // source of the reference solution used by stress tests
+    int timeLimit; // in ms, 0 for no limit
+    int memoryLimit; // in MB, 0 for no limit
     QVector<POJProblemCase> cases;
+    OJProblem();
 };
 
 using POJProblem = std::shared_ptr<OJProblem>;
@@ -15,58 +15,335 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "problemcasevalidator.h"
-#include "../utils.h"
+#include <QFile>
+#include <QTextCodec>
+#include <cmath>
 
-ProblemCaseValidator::ProblemCaseValidator()
+#define CASE_READ_BUFFER_SIZE (64*1024)
+//longer tokens are not taken as numbers
+#define CASE_MAX_NUMBER_LENGTH 64
+
+/*
+ * Reads a text device byte by byte, "\r\n" is read as a single '\n'.
+ */
+class CaseStreamReader {
+public:
+    explicit CaseStreamReader(QIODevice* device):
+        mDevice(device),
+        mPos(0),
+        mHasNext(false),
+        mNext(-1),
+        mLine(1),
+        mColumn(1)
+    {
+    }
+
+    //returns -1 at the end of the text
+    int peek() {
+        if (!mHasNext) {
+            mNext = readChar();
+            mHasNext = true;
+        }
+        return mNext;
+    }
+
+    int get() {
+        int c = peek();
+        mHasNext = false;
+        if (c == '\n') {
+            mLine++;
+            mColumn = 1;
+        } else if (c>=0 && (c & 0xC0) != 0x80) { //don't count utf-8 continuation bytes
+            mColumn++;
+        }
+        return c;
+    }
+
+    //position of the next char
+    int line() const {
+        return mLine;
+    }
+    int column() const {
+        return mColumn;
+    }
+private:
+    int readChar() {
+        int c = readByte();
+        if (c == '\r' && peekByte() == '\n') {
+            readByte();
+            c = '\n';
+        }
+        return c;
+    }
+    int readByte() {
+        if (mPos>=mBuffer.length() && !fillBuffer())
+            return -1;
+        return (uchar)mBuffer[mPos++];
+    }
+    int peekByte() {
+        if (mPos>=mBuffer.length() && !fillBuffer())
+            return -1;
+        return (uchar)mBuffer[mPos];
+    }
+    bool fillBuffer() {
+        mBuffer = mDevice->read(CASE_READ_BUFFER_SIZE);
+        mPos = 0;
+        return !mBuffer.isEmpty();
+    }
+private:
+    QIODevice* mDevice;
+    QByteArray mBuffer;
+    int mPos;
+    bool mHasNext;
+    int mNext;
+    int mLine;
+    int mColumn;
+};
+
+/*
+ * Reads a text kept in memory as the local 8-bit bytes it would have been
+ * written with, encoding it chunk by chunk instead of copying it all at once.
+ */
+class CaseTextDevice : public QIODevice {
+public:
+    explicit CaseTextDevice(const QString& text):
+        mText(text),
+        mPos(0),
+        mCodec(QTextCodec::codecForLocale()),
+        mState(QTextCodec::IgnoreHeader)
+    {
+    }
+    bool isSequential() const override {
+        return true;
+    }
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        while (mPending.length()<maxSize && mPos<mText.length()) {
+            int count = std::min(mText.length()-mPos, CASE_READ_BUFFER_SIZE);
+            mPending.append(mCodec->fromUnicode(mText.constData()+mPos, count, &mState));
+            mPos += count;
+        }
+        qint64 size = std::min((qint64)mPending.length(), maxSize);
+        memcpy(data, mPending.constData(), size);
+        mPending.remove(0, size);
+        return size;
+    }
+    qint64 writeData(const char *, qint64) override {
+        return -1;
+    }
+private:
+    const QString& mText;
+    int mPos;
+    QTextCodec* mCodec;
+    QTextCodec::ConverterState mState;
+    QByteArray mPending;
+};
+
+enum class CaseTokenType {
+    Word,
+    LineBreak,
+    End
+};
+
+static bool isBlank(int c)
+{
+    return c==' ' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+static bool isWordChar(int c)
+{
+    return c>=0 && c!='\n' && !isBlank(c);
+}
+
+//skip blanks, and read the line break if there is one.
+//the line break at the end of the text is ignored.
+static CaseTokenType nextTokenType(CaseStreamReader& reader)
+{
+    while (isBlank(reader.peek()))
+        reader.get();
+    int c = reader.peek();
+    if (c<0)
+        return CaseTokenType::End;
+    if (c=='\n') {
+        reader.get();
+        return reader.peek()<0?CaseTokenType::End:CaseTokenType::LineBreak;
+    }
+    return CaseTokenType::Word;
+}
+
+ProblemCaseValidator::ProblemCaseValidator():
+    mFloatTolerance(0),
+    mMismatchLine(0),
+    mMismatchColumn(0)
 {
 
 }
 
 bool ProblemCaseValidator::validate(POJProblemCase problemCase, bool ignoreSpaces)
 {
+    mMismatchLine = 0;
+    mMismatchColumn = 0;
     if (!problemCase)
         return false;
-    QStringList output = textToLines(problemCase->output);
-    QStringList expected = textToLines(problemCase->expected);
-    if (output.count()!=expected.count())
-        return false;
-    for (int i=0;i<output.count();i++) {
-        if (ignoreSpaces) {
-            if (!equalIgnoringSpaces(output[i],expected[i]))
-                return false;
-        } else {
-            if (output[i]!=expected[i])
-                return false;
+    //texts kept in memory are encoded as the program's output
+    auto openData=[](const QString& fileName, QFile& file,
+            CaseTextDevice& textDevice) -> QIODevice* {
+        if (!fileName.isEmpty()) {
+            file.setFileName(fileName);
+            return file.open(QFile::ReadOnly)?&file:nullptr;
         }
+        return textDevice.open(QIODevice::ReadOnly)?&textDevice:nullptr;
+    };
+    QFile outputFile, expectedFile;
+    CaseTextDevice outputText(problemCase->output);
+    CaseTextDevice expectedText(problemCase->expected);
+    QIODevice* output = openData(problemCase->outputFileName, outputFile, outputText);
+    QIODevice* expected = openData(problemCase->expectedOutputFileName, expectedFile, expectedText);
+    if (!output || !expected) {
+        mMismatchLine = 1;
+        mMismatchColumn = 1;
+        return false;
     }
-    return true;
+    return validate(output,expected,ignoreSpaces);
 }
 
-bool ProblemCaseValidator::equalIgnoringSpaces(const QString &s1, const QString &s2)
+bool ProblemCaseValidator::validate(QIODevice *output, QIODevice *expected, bool ignoreSpaces)
 {
-    QStringList strList1=split(s1);
-    QStringList strList2=split(s2);
-    return (strList1==strList2);
+    mMismatchLine = 0;
+    mMismatchColumn = 0;
+    CaseStreamReader outputReader(output);
+    CaseStreamReader expectedReader(expected);
+    if (ignoreSpaces)
+        return compareTokens(outputReader,expectedReader);
+    return compareChars(outputReader,expectedReader);
+}
+
+bool ProblemCaseValidator::validateFiles(const QString &outputFilename, const QString &expectedFilename, bool ignoreSpaces)
+{
+    mMismatchLine = 0;
+    mMismatchColumn = 0;
+    QFile output(outputFilename);
+    QFile expected(expectedFilename);
+    if (!output.open(QFile::ReadOnly) || !expected.open(QFile::ReadOnly)) {
+        mMismatchLine = 1;
+        mMismatchColumn = 1;
+        return false;
+    }
+    return validate(&output,&expected,ignoreSpaces);
 }
 
-QStringList ProblemCaseValidator::split(const QString &s)
+bool ProblemCaseValidator::compareChars(CaseStreamReader &output, CaseStreamReader &expected)
 {
-    QStringList result;
-    const QChar* p = s.data();
-    const QChar* start = p;
-    while (p->unicode()!=0) {
-        if (p->isSpace()) {
-            if (!start->isSpace()) {
-                result.append(QString(start,p-start));
-            }
-            start = p;
-        } else if (start->isSpace()) {
-            start = p;
+    while (true) {
+        int line = output.line();
+        int column = output.column();
+        int c1 = output.get();
+        int c2 = expected.get();
+        if (c1 == c2) {
+            if (c1<0)
+                return true;
+            continue;
         }
-        p++;
+        //the line break at the end of the text is ignored
+        if (c1<0 && c2=='\n' && expected.peek()<0)
+            return true;
+        if (c2<0 && c1=='\n' && output.peek()<0)
+            return true;
+        mMismatchLine = line;
+        mMismatchColumn = column;
+        return false;
+    }
+}
+
+bool ProblemCaseValidator::compareTokens(CaseStreamReader &output, CaseStreamReader &expected)
+{
+    while (true) {
+        int line = output.line();
+        int column = output.column();
+        CaseTokenType type1 = nextTokenType(output);
+        if (type1 != CaseTokenType::LineBreak) {
+            //point to the token instead of the blanks before it
+            line = output.line();
+            column = output.column();
+        }
+        CaseTokenType type2 = nextTokenType(expected);
+        if (type1 == type2) {
+            if (type1 == CaseTokenType::End)
+                return true;
+            if (type1 == CaseTokenType::LineBreak || compareWords(output,expected))
+                continue;
+        }
+        mMismatchLine = line;
+        mMismatchColumn = column;
+        return false;
+    }
+}
+
+bool ProblemCaseValidator::compareWords(CaseStreamReader &output, CaseStreamReader &expected)
+{
+    //the common prefix is kept only for comparing numbers
+    QByteArray prefix;
+    int c1,c2;
+    while (true) {
+        c1 = isWordChar(output.peek())?output.get():-1;
+        c2 = isWordChar(expected.peek())?expected.get():-1;
+        if (c1 != c2)
+            break;
+        if (c1<0)
+            return true;
+        if (prefix.length()<=CASE_MAX_NUMBER_LENGTH)
+            prefix.append((char)c1);
+    }
+    if (mFloatTolerance<=0 || prefix.length()>CASE_MAX_NUMBER_LENGTH)
+        return false;
+    QByteArray word1 = prefix;
+    QByteArray word2 = prefix;
+    while (c1>=0 && word1.length()<=CASE_MAX_NUMBER_LENGTH) {
+        word1.append((char)c1);
+        c1 = isWordChar(output.peek())?output.get():-1;
     }
-    if (!start->isSpace()) {
-        result.append(QString(start,p-start));
+    while (c2>=0 && word2.length()<=CASE_MAX_NUMBER_LENGTH) {
+        word2.append((char)c2);
+        c2 = isWordChar(expected.peek())?expected.get():-1;
     }
-    return result;
+    if (c1>=0 || c2>=0)
+        return false;
+    return equalNumbers(word1,word2);
+}
+
+bool ProblemCaseValidator::equalNumbers(const QByteArray &s1, const QByteArray &s2)
+{
+    //integers must be exactly the same
+    auto isFloat=[](const QByteArray& s) {
+        return s.contains('.') || s.contains('e') || s.contains('E');
+    };
+    if (!isFloat(s1) && !isFloat(s2))
+        return false;
+    bool ok1,ok2;
+    double v1 = s1.toDouble(&ok1);
+    double v2 = s2.toDouble(&ok2);
+    if (!ok1 || !ok2 || !std::isfinite(v1) || !std::isfinite(v2))
+        return false;
+    double diff = std::fabs(v1-v2);
+    return diff <= mFloatTolerance || diff <= mFloatTolerance * std::fabs(v2);
+}
+
+double ProblemCaseValidator::floatTolerance() const
+{
+    return mFloatTolerance;
+}
+
+void ProblemCaseValidator::setFloatTolerance(double newFloatTolerance)
+{
+    mFloatTolerance = newFloatTolerance;
+}
+
+int ProblemCaseValidator::mismatchLine() const
+{
+    return mMismatchLine;
+}
+
+int ProblemCaseValidator::mismatchColumn() const
+{
+    return mMismatchColumn;
 }
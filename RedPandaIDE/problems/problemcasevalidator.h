@@ -19,14 +19,41 @@
 
 #include "ojproblemset.h"
 
+class QIODevice;
+class CaseStreamReader;
+
+/**
+ * Compares the output of a problem case with the expected output.
+ *
+ * Both texts are read incrementally and compared char by char (or token by
+ * token when ignoring spaces), so huge outputs are never split into lines.
+ * The position of the first mismatch in the output is kept for display.
+ */
 class ProblemCaseValidator
 {
 public:
     ProblemCaseValidator();
     bool validate(POJProblemCase problemCase,bool ignoreSpaces);
+    bool validate(QIODevice* output, QIODevice* expected, bool ignoreSpaces);
+    bool validateFiles(const QString& outputFilename, const QString& expectedFilename, bool ignoreSpaces);
+
+    //max absolute or relative error of floating point numbers, 0 to compare them as text
+    //only used when ignoring spaces
+    double floatTolerance() const;
+    void setFloatTolerance(double newFloatTolerance);
+
+    //1-based position of the first mismatch in the output, 0 if no mismatch found
+    int mismatchLine() const;
+    int mismatchColumn() const;
+private:
+    bool compareChars(CaseStreamReader& output, CaseStreamReader& expected);
+    bool compareTokens(CaseStreamReader& output, CaseStreamReader& expected);
+    bool compareWords(CaseStreamReader& output, CaseStreamReader& expected);
+    bool equalNumbers(const QByteArray& s1, const QByteArray& s2);
 private:
-    bool equalIgnoringSpaces(const QString& s1, const QString& s2);
-    QStringList split(const QString& s);
+    double mFloatTolerance;
+    int mMismatchLine;
+    int mMismatchColumn;
 };
 
 #endif // PROBLEMCASEVALIDATOR_H
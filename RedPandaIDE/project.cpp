@@ -793,6 +793,7 @@ void Project::saveOptions()
     ini.SetValue("Project","CompilerSettings", mOptions.compilerOptions);
     ini.SetLongValue("Project","StaticLink", mOptions.staticLink);
     ini.SetLongValue("Project","AddCharset", mOptions.addCharset);
+    ini.SetLongValue("Project","MakeJobs", mOptions.makeJobs);
     ini.SetValue("Project","Encoding",toByteArray(mOptions.encoding));
     ini.SetLongValue("Project","ModelType", (int)mOptions.modelType);
     //for Red Panda Dev C++ 6 compatibility
@@ -1509,6 +1510,7 @@ void Project::loadOptions(SimpleIni& ini)
         mOptions.compilerOptions = ini.GetValue("Project", "CompilerSettings", "");
         mOptions.staticLink = ini.GetBoolValue("Project", "StaticLink", true);
         mOptions.addCharset = ini.GetBoolValue("Project", "AddCharset", true);
+        mOptions.makeJobs = ini.GetLongValue("Project", "MakeJobs", 0);
 
         if (mOptions.compilerSetType<0) {
             updateCompilerSetType();
@@ -44,6 +44,7 @@ ProjectOptions::ProjectOptions()
     isCpp = false;
     logOutputEnabled = false;
     useCustomMakefile = false;
+    makeJobs = 0;
     usePrecompiledHeader = false;
     overrideOutput = false;
     includeVersionInfo = false;
@@ -73,6 +73,7 @@ struct ProjectOptions{
     bool logOutputEnabled;
     bool useCustomMakefile;
     QString customMakefile;
+    int makeJobs; // 0: choose from cpu cores and free memory
     bool usePrecompiledHeader;
     QString precompiledHeader;
     bool overrideOutput;
@@ -645,3 +645,106 @@ BufferCoord maxBufferCoord(const BufferCoord &P1, const BufferCoord &P2)
       return P1;
     }
 }
+
+QVector<LineDiffHunk> diffLines(const QStringList &oldLines, const QStringList &newLines, int maxDifferences)
+{
+    QVector<LineDiffHunk> hunks;
+    //skip the common head and tail, formatters and most edits leave them alone
+    int prefix = 0;
+    while (prefix<oldLines.count() && prefix<newLines.count()
+           && oldLines[prefix] == newLines[prefix])
+        prefix++;
+    int suffix = 0;
+    while (suffix<oldLines.count()-prefix && suffix<newLines.count()-prefix
+           && oldLines[oldLines.count()-1-suffix] == newLines[newLines.count()-1-suffix])
+        suffix++;
+    int n = oldLines.count() - prefix - suffix;
+    int m = newLines.count() - prefix - suffix;
+    if (n==0 && m==0)
+        return hunks;
+    if (n==0 || m==0) {
+        hunks.append(LineDiffHunk{prefix, n, prefix, m});
+        return hunks;
+    }
+    int maxD = std::min(n+m, maxDifferences);
+    int offset = maxD + 1;
+    std::vector<int> v(2*maxD+3, 0);
+    //trace[d] holds v[-(d-1)..d-1] as it was before step d, for walking back
+    std::vector<std::vector<int>> trace;
+    int found = -1;
+    for (int d=0;d<=maxD && found<0;d++) {
+        if (d==0)
+            trace.emplace_back();
+        else
+            trace.emplace_back(v.begin()+offset-d+1, v.begin()+offset+d);
+        for (int k=-d;k<=d;k+=2) {
+            int x;
+            if (k==-d || (k!=d && v[offset+k-1] < v[offset+k+1]))
+                x = v[offset+k+1];
+            else
+                x = v[offset+k-1]+1;
+            int y = x-k;
+            while (x<n && y<m && oldLines[prefix+x] == newLines[prefix+y]) {
+                x++;
+                y++;
+            }
+            v[offset+k] = x;
+            if (x>=n && y>=m) {
+                found = d;
+                break;
+            }
+        }
+    }
+    if (found<0) {
+        hunks.append(LineDiffHunk{prefix, n, prefix, m});
+        return hunks;
+    }
+    std::vector<bool> oldKept(n,false);
+    std::vector<bool> newKept(m,false);
+    int x = n;
+    int y = m;
+    for (int d=found;d>0;d--) {
+        const std::vector<int>& prev = trace[d];
+        auto prevV = [&prev,d](int k) { return prev[k+d-1]; };
+        int k = x-y;
+        int prevK;
+        if (k==-d || (k!=d && prevV(k-1) < prevV(k+1)))
+            prevK = k+1;
+        else
+            prevK = k-1;
+        int prevX = prevV(prevK);
+        //an insertion moves down from prevK, a deletion moves right; equal lines follow
+        int snakeStart = (prevK == k+1) ? prevX : prevX+1;
+        while (x>snakeStart) {
+            x--;
+            y--;
+            oldKept[x] = true;
+            newKept[y] = true;
+        }
+        x = prevX;
+        y = prevX - prevK;
+    }
+    while (x>0 && y>0) {
+        x--;
+        y--;
+        oldKept[x] = true;
+        newKept[y] = true;
+    }
+    int i = 0;
+    int j = 0;
+    while (i<n || j<m) {
+        if (i<n && j<m && oldKept[i] && newKept[j]) {
+            i++;
+            j++;
+            continue;
+        }
+        int oldStart = i;
+        int newStart = j;
+        while (i<n && !oldKept[i])
+            i++;
+        while (j<m && !newKept[j])
+            j++;
+        hunks.append(LineDiffHunk{prefix+oldStart, i-oldStart, prefix+newStart, j-newStart});
+    }
+    return hunks;
+}
@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 #include <QString>
+#include <QStringList>
 #include <QSet>
 #include "highlighter/base.h"
 #include <QPaintDevice>
@@ -140,4 +141,19 @@ void ensureNotAfter(BufferCoord& cord1, BufferCoord& cord2);
 
 bool isWordChar(const QChar& ch);
 
+struct LineDiffHunk {
+    int oldStart; // 0-based
+    int oldCount;
+    int newStart; // 0-based
+    int newCount;
+};
+
+/**
+ * Line-wise differences between oldLines and newLines (Myers' algorithm)
+ * Note: hunks are in ascending order. If more than maxDifferences lines differ,
+ *  the whole changed range is returned as one hunk
+ */
+QVector<LineDiffHunk> diffLines(const QStringList& oldLines, const QStringList& newLines,
+                                int maxDifferences = 1000);
+
 #endif // MISCPROCS_H
@@ -151,6 +151,7 @@ SynEdit::SynEdit(QWidget *parent) : QAbstractScrollArea(parent)
     mContentImage = std::make_shared<QImage>(clientWidth(),clientHeight(),QImage::Format_ARGB32);
 
     mUseCodeFolding = true;
+    mLazyRangeScan = false;
     m_blinkTimerId = 0;
     m_blinkStatus = 0;
 
@@ -3201,6 +3202,11 @@ int SynEdit::scanFrom(int Index, int canStopIndex)
     if (Result >= mLines->count())
         return Result;
 
+    if (mLazyRangeScan) {
+        //don't follow the changes through the whole file,
+        //lines out of the window are rescanned when they are painted
+        canStopIndex = std::min(canStopIndex, Result + mLinesInWindow);
+    }
     if (Result == 0) {
         mHighlighter->resetState();
     } else {
@@ -3210,6 +3216,12 @@ int SynEdit::scanFrom(int Index, int canStopIndex)
         mHighlighter->setLine(mLines->getString(Result), Result);
         mHighlighter->nextToEol();
         iRange = mHighlighter->getRangeState();
+        if (Result > canStopIndex && mLazyRangeScan) {
+            mLines->setRange(Result,iRange);
+            if (mUseCodeFolding)
+                rescanFolds();
+            return Result;
+        }
         if (Result > canStopIndex){
             if (mLines->ranges(Result).state == iRange.state
                     && mLines->ranges(Result).braceLevel == iRange.braceLevel
@@ -3252,7 +3264,7 @@ void SynEdit::rescanRange(int line)
 
 void SynEdit::rescanRanges()
 {
-    if (mHighlighter && !mLines->empty()) {
+    if (mHighlighter && !mLines->empty() && !mLazyRangeScan) {
         mHighlighter->resetState();
         for (int i =0;i<mLines->count();i++) {
             mHighlighter->setLine(mLines->getString(i), i);
@@ -3264,6 +3276,28 @@ void SynEdit::rescanRanges()
         rescanFolds();
 }
 
+void SynEdit::rescanRangesOfRows(int firstRow, int lastRow)
+{
+    if (!mHighlighter || mLines->empty())
+        return;
+    int firstLine = rowToLine(firstRow)-1;
+    int lastLine = std::min(rowToLine(lastRow)-1, mLines->count()-1);
+    if (firstLine<0)
+        firstLine = 0;
+    //ranges are only the highlighter's state, don't notify the changes
+    QSignalBlocker blocker(mLines.get());
+    if (firstLine == 0) {
+        mHighlighter->resetState();
+    } else {
+        mHighlighter->setState(mLines->ranges(firstLine-1));
+    }
+    for (int i=firstLine;i<=lastLine;i++) {
+        mHighlighter->setLine(mLines->getString(i), i);
+        mHighlighter->nextToEol();
+        mLines->setRange(i, mHighlighter->getRangeState());
+    }
+}
+
 void SynEdit::uncollapse(PSynEditFoldRange FoldRange)
 {
     FoldRange->linesCollapsed = 0;
@@ -4552,6 +4586,43 @@ void SynEdit::setUseCodeFolding(bool value)
     }
 }
 
+const PSynEditUndoList &SynEdit::undoList() const
+{
+    return mUndoList;
+}
+
+int SynEdit::undoLimit() const
+{
+    return mUndoList->maxUndoActions();
+}
+
+void SynEdit::setUndoLimit(int size)
+{
+    mUndoList->setMaxUndoActions(size);
+    mRedoList->setMaxUndoActions(size);
+}
+
+qint64 SynEdit::undoMemoryUsage() const
+{
+    return mUndoList->maxMemoryUsage();
+}
+
+void SynEdit::setUndoMemoryUsage(qint64 size)
+{
+    mUndoList->setMaxMemoryUsage(size);
+    mRedoList->setMaxMemoryUsage(size);
+}
+
+bool SynEdit::lazyRangeScan() const
+{
+    return mLazyRangeScan;
+}
+
+void SynEdit::setLazyRangeScan(bool value)
+{
+    mLazyRangeScan = value;
+}
+
 SynEditCodeFolding &SynEdit::codeFolding()
 {
     return mCodeFolding;
@@ -5151,8 +5222,11 @@ int SynEdit::insertTextByNormalMode(const QString &Value)
     // step1: insert the first line of Value into current line
     Start = 0;
     P = GetEOL(Value,Start);
+    //undo/redo must put back exactly the text they recorded
+    bool autoIndent = mHighlighter && mOptions.testFlag(eoAutoIndent)
+            && !mUndoing && !mUndoList->insideRedo();
     if (P<Value.length()) {
-        if (mHighlighter) {
+        if (autoIndent) {
             QString s = trimLeft(Value.mid(0, P - Start));
             if (sLeftSide.isEmpty()) {
                 sLeftSide = GetLeftSpacing(calcIndentSpaces(caretY,s,true),true);
@@ -5183,7 +5257,7 @@ int SynEdit::insertTextByNormalMode(const QString &Value)
         P = GetEOL(Value,Start);
         if (P == Start) {
             if (P<Value.length()) {
-                if (mHighlighter && mOptions.testFlag(eoAutoIndent) && notInComment) {
+                if (autoIndent && notInComment) {
                     Str = GetLeftSpacing(calcIndentSpaces(caretY,"",true),true);
                 } else {
                     Str = "";
@@ -5194,7 +5268,7 @@ int SynEdit::insertTextByNormalMode(const QString &Value)
             Str = Value.mid(Start, P-Start);
             if (P>=Value.length())
                 Str += sRightSide;
-            if (mHighlighter && mOptions.testFlag(eoAutoIndent) && notInComment) {
+            if (autoIndent && notInComment) {
                 int indentSpaces = calcIndentSpaces(caretY,Str,true);
                 Str = GetLeftSpacing(indentSpaces,true)+trimLeft(Str);
             }
@@ -5703,6 +5777,10 @@ void SynEdit::paintEvent(QPaintEvent *event)
 
         //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
 
+        //ranges are not scanned for the whole file, highlight the painted lines on demand
+        if (mLazyRangeScan)
+            rescanRangesOfRows(nL1,nL2);
+
         QPainter cachePainter(mContentImage.get());
         cachePainter.setFont(font());
         SynEditTextPainter textPainter(this, &cachePainter,
@@ -6150,6 +6228,11 @@ void SynEdit::setModified(bool Value)
     }
 }
 
+const QDateTime &SynEdit::lastModifyTime() const
+{
+    return mLastModifyTime;
+}
+
 int SynEdit::gutterWidth() const
 {
     return mGutterWidth;
@@ -6383,6 +6466,52 @@ void SynEdit::setSelText(const QString &text)
     doSetSelText(text);
 }
 
+void SynEdit::replaceContents(const QStringList &newLines)
+{
+    QStringList oldLines = mLines->contents();
+    QVector<LineDiffHunk> hunks = diffLines(oldLines,newLines);
+    if (hunks.isEmpty())
+        return;
+    incPaintLock();
+    mUndoList->BeginBlock();
+    auto action = finally([this]{
+        mUndoList->EndBlock();
+        decPaintLock();
+    });
+    //from the bottom up, so the hunks above keep their line numbers
+    for (int i=hunks.count()-1;i>=0;i--) {
+        const LineDiffHunk& hunk = hunks[i];
+        QStringList inserted = newLines.mid(hunk.newStart,hunk.newCount);
+        BufferCoord start;
+        BufferCoord end;
+        QString text;
+        if (hunk.oldStart+hunk.oldCount < oldLines.count()) {
+            start = BufferCoord{1, hunk.oldStart+1};
+            end = BufferCoord{1, hunk.oldStart+hunk.oldCount+1};
+            if (!inserted.isEmpty())
+                text = inserted.join("\n")+"\n";
+        } else {
+            //the hunk reaches the end of the text, which has no line after it
+            if (oldLines.isEmpty())
+                end = BufferCoord{1,1};
+            else
+                end = BufferCoord{oldLines.last().length()+1, oldLines.count()};
+            if (hunk.oldStart>0) {
+                start = BufferCoord{oldLines[hunk.oldStart-1].length()+1, hunk.oldStart};
+                if (!inserted.isEmpty())
+                    text = "\n"+inserted.join("\n");
+            } else {
+                start = BufferCoord{1,1};
+                text = inserted.join("\n");
+            }
+        }
+        if (start == end && text.isEmpty())
+            continue;
+        setCaretAndSelection(start,start,end);
+        setSelText(text);
+    }
+}
+
 BufferCoord SynEdit::blockBegin() const
 {
     if ((mBlockEnd.Line < mBlockBegin.Line)
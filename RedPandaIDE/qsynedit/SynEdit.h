@@ -243,6 +243,8 @@ public:
     PSynEditFoldRange foldHidesLine(int line);
     void setSelLength(int Value);
     void setSelText(const QString& text);
+    //replace the whole text, only the changed lines are touched and recorded for undo
+    void replaceContents(const QStringList& newLines);
 
     int searchReplace(const QString& sSearch, const QString& sReplace, SynSearchOptions options,
                PSynSearchBase searchEngine,  SynSearchMathedProc matchedCallback = nullptr,
@@ -320,12 +322,16 @@ public:
 
     bool modified() const;
     void setModified(bool Value);
+    const QDateTime &lastModifyTime() const;
 
     PSynHighlighter highlighter() const;
     void setHighlighter(const PSynHighlighter &highlighter);
 
     bool useCodeFolding() const;
     void setUseCodeFolding(bool value);
+    //only scan the ranges of changed lines, instead of the whole file
+    bool lazyRangeScan() const;
+    void setLazyRangeScan(bool value);
 
     SynEditCodeFolding & codeFolding();
 
@@ -370,6 +376,12 @@ public:
 
     bool canUndo() const;
     bool canRedo() const;
+    const PSynEditUndoList& undoList() const;
+    int undoLimit() const;
+    void setUndoLimit(int size);
+    //in bytes
+    qint64 undoMemoryUsage() const;
+    void setUndoMemoryUsage(qint64 size);
 
     int textHeight() const;
 
@@ -485,6 +497,7 @@ private:
     int scanFrom(int Index, int canStopIndex);
     void rescanRange(int line);
     void rescanRanges();
+    void rescanRangesOfRows(int firstRow, int lastRow);
     void uncollapse(PSynEditFoldRange FoldRange);
     void collapse(PSynEditFoldRange FoldRange);
 
@@ -610,6 +623,7 @@ private:
     SynEditFoldRanges mAllFoldRanges;
     SynEditCodeFolding mCodeFolding;
     bool mUseCodeFolding;
+    bool mLazyRangeScan;
     bool  mAlwaysShowCaret;
     BufferCoord mBlockBegin;
     BufferCoord mBlockEnd;
@@ -15,12 +15,14 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "TextBuffer.h"
+#include <QBuffer>
 #include <QDataStream>
 #include <QFile>
 #include <QTextCodec>
 #include <QTextStream>
 #include <QMutexLocker>
 #include <stdexcept>
+#include <cstring>
 #include "SynEdit.h"
 #include "../utils.h"
 #include "../platform.h"
@@ -29,7 +31,11 @@
 SynEditStringList::SynEditStringList(SynEdit *pEdit, QObject *parent):
       QObject(parent),
       mEdit(pEdit),
-      mMutex(QMutex::Recursive)
+      mMutex(QMutex::Recursive),
+      mKeepFileMapped(false),
+      mMappedData(nullptr),
+      mMappedCodec(nullptr),
+      mMappedUtf8(false)
 {
     mAppendNewLineAtEOF = true;
     mFileEndingType = FileEndingType::Windows;
@@ -118,7 +124,12 @@ int SynEditStringList::lengthOfLongestLine() {
         mIndexOfLongestLine = -1;
         if (mList.count() > 0 ) {
             for (int i=0;i<mList.size();i++) {
-                int len = lineColumns(i);
+                int len;
+                //don't decode mapped lines just to measure them, the byte length is close enough
+                if (mList[i]->fMappedOffset>=0 && mList[i]->fColumns == -1)
+                    len = mList[i]->fMappedLength;
+                else
+                    len = lineColumns(i);
                 if (len > MaxLen) {
                     MaxLen = len;
                     mIndexOfLongestLine = i;
@@ -126,8 +137,12 @@ int SynEditStringList::lengthOfLongestLine() {
             }
         }
     }
-    if (mIndexOfLongestLine >= 0)
-        return mList[mIndexOfLongestLine]->fColumns;
+    if (mIndexOfLongestLine >= 0) {
+        const PSynEditStringRec& line = mList[mIndexOfLongestLine];
+        if (line->fColumns == -1)
+            return line->fMappedLength;
+        return line->fColumns;
+    }
     else
         return 0;
 }
@@ -205,7 +220,7 @@ QString SynEditStringList::getString(int Index)
     if (Index<0 || Index>=mList.count()) {
         return QString();
     }
-    return mList[Index]->fString;
+    return lineString(mList[Index]);
 }
 
 int SynEditStringList::count()
@@ -258,9 +273,9 @@ QStringList SynEditStringList::contents()
 {
     QMutexLocker locker(&mMutex);
     QStringList Result;
-    SynEditStringRecList list = mList;
-    foreach (const PSynEditStringRec& line, list) {
-        Result.append(line->fString);
+    Result.reserve(mList.count());
+    foreach (const PSynEditStringRec& line, mList) {
+        Result.append(lineString(line));
     }
     return Result;
 }
@@ -316,7 +331,7 @@ int SynEditStringList::getTextLength()
     QMutexLocker locker(&mMutex);
     int Result = 0;
     foreach (const PSynEditStringRec& line, mList ) {
-        Result += line->fString.length();
+        Result += lineString(line).length();
         if (mFileEndingType == FileEndingType::Windows) {
             Result += 2;
         } else {
@@ -405,14 +420,38 @@ void SynEditStringList::deleteAt(int Index)
 
 QString SynEditStringList::getTextStr() const
 {
-    QString result;
-    for (int i=0;i<mList.count()-1;i++) {
-        const PSynEditStringRec& line = mList[i];
-        result.append(line->fString);
-        result.append(lineBreak());
+    if (mList.isEmpty())
+        return QString();
+    QString lb = lineBreak();
+    if (mMappedData) {
+        //decoded lengths of mapped lines are unknown, so estimate them by byte length
+        QString result;
+        int estimated = lb.length()*(mList.count()-1);
+        foreach (const PSynEditStringRec& line, mList) {
+            estimated += line->fMappedOffset<0 ? line->fString.length() : line->fMappedLength;
+        }
+        result.reserve(estimated);
+        for (int i=0;i<mList.count()-1;i++) {
+            result.append(lineString(mList[i]));
+            result.append(lb);
+        }
+        result.append(lineString(mList.back()));
+        return result;
+    }
+    int size = lb.length()*(mList.count()-1);
+    foreach (const PSynEditStringRec& line, mList) {
+        size += line->fString.length();
     }
-    if (mList.length()>0) {
-        result.append(mList.back()->fString);
+    QString result(size, Qt::Uninitialized);
+    QChar* p = result.data();
+    for (int i=0;i<mList.count();i++) {
+        const QString& s = mList[i]->fString;
+        memcpy(p, s.constData(), s.length()*sizeof(QChar));
+        p += s.length();
+        if (i<mList.count()-1) {
+            memcpy(p, lb.constData(), lb.length()*sizeof(QChar));
+            p += lb.length();
+        }
     }
     return result;
 }
@@ -428,6 +467,7 @@ void SynEditStringList::putString(int Index, const QString &s, bool notify) {
         beginUpdate();
         mIndexOfLongestLine = -1;
         mList[Index]->fString = s;
+        mList[Index]->fMappedOffset = -1;
         mList[Index]->fColumns = -1;
         if (notify)
             emit putted(Index,1);
@@ -458,7 +498,7 @@ int SynEditStringList::calculateLineColumns(int Index)
 {
     PSynEditStringRec line = mList[Index];
 
-    line->fColumns = mEdit->stringColumns(line->fString,0);
+    line->fColumns = mEdit->stringColumns(lineString(line),0);
     return line->fColumns;
 }
 
@@ -517,6 +557,275 @@ void SynEditStringList::insertText(int Index, const QString &NewText)
     insertStrings(Index,lines);
 }
 
+// offset of the first non-ascii byte, or size if all bytes are ascii
+static qint64 findFirstNonAsciiByte(const uchar* data, qint64 size)
+{
+    qint64 i=0;
+    //check 8 bytes at a time
+    for (;i+8<=size;i+=8) {
+        quint64 word;
+        memcpy(&word,data+i,8);
+        if (word & Q_UINT64_C(0x8080808080808080))
+            break;
+    }
+    for (;i<size;i++) {
+        if (data[i] & 0x80)
+            return i;
+    }
+    return size;
+}
+
+static bool isValidUtf8(const uchar* data, qint64 size)
+{
+    qint64 i=0;
+    while (i<size) {
+        uchar c = data[i];
+        if (c<0x80) {
+            i += findFirstNonAsciiByte(data+i,size-i);
+            continue;
+        }
+        int n;
+        quint32 codePoint;
+        if (c>=0xC2 && c<=0xDF) {
+            n=1;
+            codePoint = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            n=2;
+            codePoint = c & 0x0F;
+        } else if (c>=0xF0 && c<=0xF4) {
+            n=3;
+            codePoint = c & 0x07;
+        } else
+            return false;
+        if (i+n>=size)
+            return false;
+        for (int k=1;k<=n;k++) {
+            uchar b = data[i+k];
+            if ((b & 0xC0)!=0x80)
+                return false;
+            codePoint = (codePoint << 6) | (b & 0x3F);
+        }
+        if (n==2 && (codePoint<0x800 || (codePoint>=0xD800 && codePoint<=0xDFFF)))
+            return false;
+        if (n==3 && (codePoint<0x10000 || codePoint>0x10FFFF))
+            return false;
+        i+=n+1;
+    }
+    return true;
+}
+
+//bytes needed to encode the utf-16 text as utf-8; lone surrogates are written as '?'
+static int utf8Length(const QChar* text, int len)
+{
+    int result = len;
+    for (int i=0;i<len;i++) {
+        ushort c = text[i].unicode();
+        if (c<0x80)
+            continue;
+        if (c<0x800) {
+            result+=1;
+        } else if (QChar::isHighSurrogate(c) && i+1<len
+                   && QChar::isLowSurrogate(text[i+1].unicode())) {
+            //two utf-16 units make four bytes
+            result+=2;
+            i++;
+        } else if (!QChar::isSurrogate(c)) {
+            result+=2;
+        }
+    }
+    return result;
+}
+
+static char* writeUtf8(const QChar* text, int len, char* out)
+{
+    for (int i=0;i<len;i++) {
+        ushort c = text[i].unicode();
+        if (c<0x80) {
+            *out++ = static_cast<char>(c);
+        } else if (c<0x800) {
+            *out++ = static_cast<char>(0xC0 | (c >> 6));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        } else if (QChar::isHighSurrogate(c) && i+1<len
+                   && QChar::isLowSurrogate(text[i+1].unicode())) {
+            uint u = QChar::surrogateToUcs4(c,text[i+1].unicode());
+            i++;
+            *out++ = static_cast<char>(0xF0 | (u >> 18));
+            *out++ = static_cast<char>(0x80 | ((u >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((u >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (u & 0x3F));
+        } else if (QChar::isSurrogate(c)) {
+            *out++ = '?';
+        } else {
+            *out++ = static_cast<char>(0xE0 | (c >> 12));
+            *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return out;
+}
+
+static char* writeLatin1(const QChar* text, int len, char* out)
+{
+    for (int i=0;i<len;i++) {
+        ushort c = text[i].unicode();
+        *out++ = c>0xFF ? '?' : static_cast<char>(c);
+    }
+    return out;
+}
+
+//collects small writes into fixed size chunks before handing them to the device
+class ChunkedWriter {
+public:
+    explicit ChunkedWriter(QIODevice& device):
+        mDevice(device),
+        mBuffer(ChunkSize, Qt::Uninitialized),
+        mUsed(0),
+        mFailed(false) {}
+
+    //room for len bytes, nullptr if len doesn't fit into one chunk
+    char* reserve(int len) {
+        if (mUsed+len>ChunkSize)
+            flush();
+        if (len>ChunkSize)
+            return nullptr;
+        return mBuffer.data()+mUsed;
+    }
+    void commit(int len) {
+        mUsed+=len;
+    }
+    void write(const char* data, int len) {
+        char* p = reserve(len);
+        if (p) {
+            memcpy(p,data,len);
+            commit(len);
+        } else if (!mFailed && mDevice.write(data,len)!=len) {
+            mFailed = true;
+        }
+    }
+    bool flush() {
+        if (mUsed>0 && !mFailed && mDevice.write(mBuffer.constData(),mUsed)!=mUsed)
+            mFailed = true;
+        mUsed = 0;
+        return !mFailed;
+    }
+private:
+    static const int ChunkSize = 64*1024;
+    QIODevice& mDevice;
+    QByteArray mBuffer;
+    int mUsed;
+    bool mFailed;
+};
+
+QByteArray SynEditStringList::textBytes(QTextCodec *codec)
+{
+    QMutexLocker locker(&mMutex);
+    if (mList.isEmpty())
+        return QByteArray();
+    ExportEncoding encoding = exportEncodingOf(codec);
+    if (encoding == ExportEncoding::Codec) {
+        //multi-byte codecs can't be sized ahead, but they can be fed line by line
+        QByteArray result;
+        QBuffer buffer(&result);
+        buffer.open(QBuffer::WriteOnly);
+        bool allAscii;
+        writeTo(buffer, codec, false, allAscii);
+        return result;
+    }
+    QByteArray lb = lineBreak().toLatin1();
+    //exact size of the result, so the bytes are written in place with no reallocation
+    int size = lb.length()*(mList.count()-1);
+    QVector<QString> decoded;
+    foreach (const PSynEditStringRec& line, mList) {
+        int len = mappedExportLength(line, encoding);
+        if (len<0) {
+            QString s = lineString(line);
+            len = (encoding == ExportEncoding::Utf8) ? utf8Length(s.constData(),s.length()) : s.length();
+            if (line->fMappedOffset>=0)
+                decoded.append(s);
+        }
+        size += len;
+    }
+    QByteArray result(size, Qt::Uninitialized);
+    char* p = result.data();
+    int decodedIndex = 0;
+    for (int i=0;i<mList.count();i++) {
+        const PSynEditStringRec& line = mList[i];
+        int len = mappedExportLength(line, encoding);
+        if (len>=0) {
+            memcpy(p, mMappedData + line->fMappedOffset, len);
+            p += len;
+        } else {
+            const QString& s = line->fMappedOffset<0 ? line->fString : decoded[decodedIndex++];
+            if (encoding == ExportEncoding::Utf8)
+                p = writeUtf8(s.constData(),s.length(),p);
+            else
+                p = writeLatin1(s.constData(),s.length(),p);
+        }
+        if (i<mList.count()-1) {
+            memcpy(p, lb.constData(), lb.length());
+            p += lb.length();
+        }
+    }
+    return result;
+}
+
+bool SynEditStringList::writeTo(QIODevice &device, QTextCodec *codec, bool lineBreakAtEnd, bool &allAscii)
+{
+    QMutexLocker locker(&mMutex);
+    ExportEncoding encoding = exportEncodingOf(codec);
+    ChunkedWriter writer(device);
+    QString lb = lineBreak();
+    QByteArray lbBytes = lb.toLatin1();
+    QTextCodec::ConverterState state;
+    //ascii lines can skip the codec if it leaves ascii untouched (not the case for utf-16/32)
+    bool asciiCompatible = (encoding != ExportEncoding::Codec)
+            || codec->fromUnicode(lb) == lbBytes;
+    if (encoding == ExportEncoding::Codec && !asciiCompatible) {
+        //encoded on its own, so the header (BOM) is left to the first line
+        QTextCodec::ConverterState lbState(QTextCodec::IgnoreHeader);
+        lbBytes = codec->fromUnicode(lb.constData(),lb.length(),&lbState);
+    }
+    allAscii = true;
+    for (int i=0;i<mList.count();i++) {
+        const PSynEditStringRec& line = mList[i];
+        int len = mappedExportLength(line, encoding);
+        if (len>=0) {
+            const uchar* data = mMappedData + line->fMappedOffset;
+            if (allAscii)
+                allAscii = findFirstNonAsciiByte(data,len) == len;
+            writer.write(reinterpret_cast<const char*>(data), len);
+        } else {
+            QString s = lineString(line);
+            bool lineAscii = isTextAllAscii(s);
+            allAscii = allAscii && lineAscii;
+            if (encoding == ExportEncoding::Codec && !(lineAscii && asciiCompatible)) {
+                QByteArray bytes = codec->fromUnicode(s.constData(),s.length(),&state);
+                writer.write(bytes.constData(),bytes.length());
+            } else {
+                bool utf8 = (encoding == ExportEncoding::Utf8 && !lineAscii);
+                len = utf8 ? utf8Length(s.constData(),s.length()) : s.length();
+                char* p = writer.reserve(len);
+                QByteArray bytes;
+                if (!p) {
+                    bytes.resize(len);
+                    p = bytes.data();
+                }
+                if (utf8)
+                    writeUtf8(s.constData(),s.length(),p);
+                else
+                    writeLatin1(s.constData(),s.length(),p);
+                if (bytes.isEmpty())
+                    writer.commit(len);
+                else
+                    writer.write(bytes.constData(),bytes.length());
+            }
+        }
+        if (lineBreakAtEnd || i<mList.count()-1)
+            writer.write(lbBytes.constData(),lbBytes.length());
+    }
+    return writer.flush();
+}
+
 void SynEditStringList::loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding)
 {
     QMutexLocker locker(&mMutex);
@@ -527,67 +836,50 @@ void SynEditStringList::loadFromFile(const QString& filename, const QByteArray&
     auto action = finally([this]{
         endUpdate();
     });
-    //test for utf8 / utf 8 bom
+    internalClear();
+
+    //map the file instead of reading it, lines are decoded right from the mapped memory.
+    //lines kept undecoded need bytes that stay as they are, so the file is read then.
+    qint64 size = file.size();
+    QByteArray buffer;
+    const uchar* data = nullptr;
+    if (size>0) {
+        if (!mKeepFileMapped)
+            data = file.map(0,size);
+        if (!data) {
+            buffer = file.readAll();
+            if (buffer.size()!=size)
+                throw FileError(tr("Can't open file '%1' for read!").arg(file.fileName()));
+            data = reinterpret_cast<const uchar*>(buffer.constData());
+        }
+    }
+    bool hasBOM = (size>=3 && data[0]==0xEF && data[1]==0xBB && data[2]==0xBF);
     if (encoding == ENCODING_AUTO_DETECT) {
-        if (file.atEnd()) {
+        if (size==0) {
             realEncoding = ENCODING_ASCII;
             return;
         }
-        QByteArray line = file.readLine();
-        QTextCodec* codec;
-        QTextCodec::ConverterState state;
-        bool needReread = false;
-        bool allAscii = true;
-        //test for BOM
-        if ((line.length()>=3) && ((unsigned char)line[0]==0xEF) && ((unsigned char)line[1]==0xBB) && ((unsigned char)line[2]==0xBF) ) {
-            realEncoding = ENCODING_UTF8_BOM;
-            line = line.mid(3);
-            codec = QTextCodec::codecForName(ENCODING_UTF8);
-        } else {
-            realEncoding = ENCODING_UTF8;
-            codec = QTextCodec::codecForName(ENCODING_UTF8);
-        }
-        if (line.endsWith("\r\n")) {
-            mFileEndingType = FileEndingType::Windows;
-        } else if (line.endsWith("\n")) {
-            mFileEndingType = FileEndingType::Linux;
-        } else if (line.endsWith("\r")) {
+        const char* firstLineBreak = static_cast<const char*>(memchr(data,'\n',size));
+        if (firstLineBreak) {
+            if (firstLineBreak>(const char*)data && *(firstLineBreak-1)=='\r')
+                mFileEndingType = FileEndingType::Windows;
+            else
+                mFileEndingType = FileEndingType::Linux;
+        } else if (data[size-1]=='\r') {
             mFileEndingType = FileEndingType::Mac;
         }
-        internalClear();
-        while (true) {
-            if (line.endsWith("\r\n")) {
-                line.remove(line.length()-2,2);
-            } else if (line.endsWith("\r")) {
-                line.remove(line.length()-1,1);
-            } else if (line.endsWith("\n")){
-                line.remove(line.length()-1,1);
-            }
-            if (allAscii) {
-                allAscii = isTextAllAscii(line);
-            }
-            if (allAscii) {
-                addItem(QString::fromLatin1(line));
-            } else {
-                QString newLine = codec->toUnicode(line.constData(),line.length(),&state);
-                if (state.invalidChars>0) {
-                    needReread = true;
-                    break;
-                }
-                addItem(newLine);
-            }
-            if (file.atEnd()){
-                break;
-            }
-            line = file.readLine();
-        }
-        emit inserted(0,mList.count());
-        if (!needReread) {
-            if (allAscii)
+        if (hasBOM) {
+            realEncoding = ENCODING_UTF8_BOM;
+        } else {
+            //the ascii prefix is only checked once
+            qint64 nonAscii = findFirstNonAsciiByte(data,size);
+            if (nonAscii==size)
                 realEncoding = ENCODING_ASCII;
-            return;
+            else if (isValidUtf8(data+nonAscii,size-nonAscii))
+                realEncoding = ENCODING_UTF8;
+            else
+                realEncoding = ENCODING_SYSTEM_DEFAULT;
         }
-        realEncoding = ENCODING_SYSTEM_DEFAULT;
     } else {
         realEncoding = encoding;
     }
@@ -595,27 +887,88 @@ void SynEditStringList::loadFromFile(const QString& filename, const QByteArray&
     if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
         realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
     }
-    file.reset();
-    QTextStream textStream(&file);
-    if (realEncoding == ENCODING_UTF8_BOM) {
-        textStream.setAutoDetectUnicode(true);
-        textStream.setCodec(ENCODING_UTF8);
-    } else {
-        textStream.setAutoDetectUnicode(false);
-        textStream.setCodec(realEncoding);
+    qint64 start = 0;
+    if (hasBOM && (realEncoding == ENCODING_UTF8_BOM || realEncoding == ENCODING_UTF8))
+        start = 3;
+
+    QTextCodec* codec = nullptr;
+    bool isAscii = (realEncoding == ENCODING_ASCII);
+    bool isUtf8 = (realEncoding == ENCODING_UTF8 || realEncoding == ENCODING_UTF8_BOM);
+    if (!isAscii && !isUtf8) {
+        codec = QTextCodec::codecForName(realEncoding);
+        if (!codec)
+            codec = QTextCodec::codecForLocale();
+        if (codec->fromUnicode(QString("\n")) != "\n") {
+            //line breaks are not single bytes (utf-16/32), decode the whole file
+            QString text = codec->toUnicode(reinterpret_cast<const char*>(data+start),size-start);
+            int pos = 0;
+            while (pos<text.length()) {
+                int lineEnd = text.indexOf('\n',pos);
+                int next = lineEnd+1;
+                if (lineEnd<0) {
+                    lineEnd = text.length();
+                    next = lineEnd;
+                }
+                int len = lineEnd - pos;
+                if (len>0 && text[lineEnd-1]=='\r')
+                    len--;
+                PSynEditStringRec line = std::make_shared<SynEditStringRec>();
+                line->fString = text.mid(pos,len);
+                mList.append(line);
+                pos = next;
+            }
+            mIndexOfLongestLine = -1;
+            emit inserted(0,mList.count());
+            return;
+        }
     }
-    QString line;
-    internalClear();
-    while (textStream.readLineInto(&line)) {
-        if (line.endsWith("\r\n")) {
-            line.remove(line.length()-2,2);
-        } else if (line.endsWith("\r")) {
-            line.remove(line.length()-1,1);
-        } else if (line.endsWith("\n")){
-            line.remove(line.length()-1,1);
+
+    const char* p = reinterpret_cast<const char*>(data+start);
+    const char* end = reinterpret_cast<const char*>(data+size);
+    //build the line index first, so the list is allocated only once
+    int lineCount = 0;
+    const char* q = p;
+    while (q<end) {
+        lineCount++;
+        q = static_cast<const char*>(memchr(q,'\n',end-q));
+        if (!q)
+            break;
+        q++;
+    }
+    mList.reserve(lineCount);
+    //only the line index is built, lines are decoded when they're read
+    bool keepMapped = mKeepFileMapped && data;
+    if (keepMapped) {
+        mMappedFileData = buffer;
+        mMappedData = data;
+        mMappedCodec = codec;
+        mMappedUtf8 = isUtf8;
+    }
+    QTextCodec::ConverterState state;
+    while (p<end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p,'\n',end-p));
+        const char* next = lineEnd+1;
+        if (!lineEnd) {
+            lineEnd = end;
+            next = end;
         }
-        addItem(line);
+        int len = lineEnd - p;
+        if (len>0 && p[len-1]=='\r')
+            len--;
+        PSynEditStringRec line = std::make_shared<SynEditStringRec>();
+        if (keepMapped) {
+            line->fMappedOffset = reinterpret_cast<const uchar*>(p) - data;
+            line->fMappedLength = len;
+        } else if (isAscii)
+            line->fString = QString::fromLatin1(p,len);
+        else if (isUtf8)
+            line->fString = QString::fromUtf8(p,len);
+        else
+            line->fString = codec->toUnicode(p,len,&state);
+        mList.append(line);
+        p = next;
     }
+    mIndexOfLongestLine = -1;
     emit inserted(0,mList.count());
 }
 
@@ -629,7 +982,7 @@ void SynEditStringList::saveToFile(QFile &file, const QByteArray& encoding,
         throw FileError(tr("Can't open file '%1' for save!").arg(file.fileName()));
     if (mList.isEmpty())
         return;
-    bool allAscii = true;
+    bool allAscii;
 
     QTextCodec* codec;
     realEncoding = encoding;
@@ -647,17 +1000,8 @@ void SynEditStringList::saveToFile(QFile &file, const QByteArray& encoding,
     } else {
         codec = QTextCodec::codecForName(realEncoding);
     }
-    for (PSynEditStringRec& line:mList) {
-        if (allAscii) {
-            allAscii = isTextAllAscii(line->fString);
-        }
-        if (!allAscii) {
-            file.write(codec->fromUnicode(line->fString));
-        } else {
-            file.write(line->fString.toLatin1());
-        }
-        file.write(lineBreak().toLatin1());
-    }
+    if (!writeTo(file, codec, true, allAscii))
+        throw FileError(tr("Failed to write file '%1'!").arg(file.fileName()));
     if (encoding == ENCODING_AUTO_DETECT) {
         if (allAscii)
             realEncoding = ENCODING_ASCII;
@@ -706,6 +1050,61 @@ void SynEditStringList::internalClear()
         emit deleted(0,oldCount);
         endUpdate();
     }
+    mMappedFileData.clear();
+    mMappedData = nullptr;
+    mMappedCodec = nullptr;
+}
+
+QString SynEditStringList::lineString(const PSynEditStringRec &line) const
+{
+    if (line->fMappedOffset<0)
+        return line->fString;
+    const char* p = reinterpret_cast<const char*>(mMappedData + line->fMappedOffset);
+    if (mMappedCodec)
+        return mMappedCodec->toUnicode(p,line->fMappedLength);
+    if (mMappedUtf8)
+        return QString::fromUtf8(p,line->fMappedLength);
+    return QString::fromLatin1(p,line->fMappedLength);
+}
+
+int SynEditStringList::mappedExportLength(const PSynEditStringRec &line, ExportEncoding encoding) const
+{
+    if (line->fMappedOffset<0 || mMappedCodec)
+        return -1;
+    //mapped bytes are either pure ascii or utf-8
+    if (encoding == ExportEncoding::Utf8
+            || (encoding == ExportEncoding::Latin1 && !mMappedUtf8))
+        return line->fMappedLength;
+    return -1;
+}
+
+SynEditStringList::ExportEncoding SynEditStringList::exportEncodingOf(QTextCodec *codec)
+{
+    if (!codec)
+        return ExportEncoding::Utf8;
+    switch(codec->mibEnum()) {
+    case 106: //UTF-8
+        return ExportEncoding::Utf8;
+    case 3: //US-ASCII
+    case 4: //ISO-8859-1
+        return ExportEncoding::Latin1;
+    }
+    return ExportEncoding::Codec;
+}
+
+bool SynEditStringList::keepFileMapped() const
+{
+    return mKeepFileMapped;
+}
+
+void SynEditStringList::setKeepFileMapped(bool newKeepFileMapped)
+{
+    mKeepFileMapped = newKeepFileMapped;
+}
+
+bool SynEditStringList::isFileMapped() const
+{
+    return mMappedData!=nullptr;
 }
 
 FileEndingType SynEditStringList::getFileEndingType()
@@ -750,7 +1149,9 @@ SynEditStringRec::SynEditStringRec():
     fString(),
     fObject(nullptr),
     fRange{0,0,0,0,0},
-    fColumns(-1)
+    fColumns(-1),
+    fMappedOffset(-1),
+    fMappedLength(0)
 {
 }
 
@@ -758,6 +1159,8 @@ SynEditStringRec::SynEditStringRec():
 SynEditUndoList::SynEditUndoList():QObject()
 {
     mMaxUndoActions = 1024;
+    mMaxMemoryUsage = 50 * 1024 * 1024;
+    mMemoryUsage = 0;
     mNextChangeNumber = 1;
     mInsideRedo = false;
 
@@ -766,6 +1169,7 @@ SynEditUndoList::SynEditUndoList():QObject()
     mFullUndoImposible=false;
     mLockCount = 0;
     mInitialChangeNumber = 0;
+    mTypingChangeNumber = 0;
 }
 
 void SynEditUndoList::AddChange(SynChangeReason AReason, const BufferCoord &AStart,
@@ -774,6 +1178,8 @@ void SynEditUndoList::AddChange(SynChangeReason AReason, const BufferCoord &ASta
 {
     if (mLockCount != 0)
         return;
+    if (tryMergeTyping(AReason, AStart, AEnd, ChangeText, SelMode))
+        return;
     int changeNumber;
     if (mBlockChangeNumber != 0) {
         changeNumber = mBlockChangeNumber;
@@ -786,10 +1192,15 @@ void SynEditUndoList::AddChange(SynChangeReason AReason, const BufferCoord &ASta
             }
         }
     }
+    //a typed char that starts its block; pastes, completions and auto indents add more items
+    PSynEditUndoItem lastItem = PeekItem();
+    bool typing = isTypedChar(AReason, AStart, AEnd, ChangeText, SelMode)
+            && (!lastItem || lastItem->changeNumber()!=changeNumber);
     PSynEditUndoItem  NewItem = std::make_shared<SynEditUndoItem>(AReason,
                                                                   SelMode,AStart,AEnd,ChangeText,
                                                                   changeNumber);
     PushItem(NewItem);
+    mTypingChangeNumber = typing ? changeNumber : 0;
 }
 
 void SynEditUndoList::AddGroupBreak()
@@ -810,7 +1221,9 @@ void SynEditUndoList::BeginBlock()
 void SynEditUndoList::Clear()
 {
     mItems.clear();
+    mMemoryUsage = 0;
     mFullUndoImposible = false;
+    mTypingChangeNumber = 0;
 }
 
 void SynEditUndoList::DeleteItem(int index)
@@ -818,6 +1231,7 @@ void SynEditUndoList::DeleteItem(int index)
     if (index <0 || index>=mItems.count()) {
         ListIndexOutOfBounds(index);
     }
+    mMemoryUsage -= mItems[index]->memoryUsage();
     mItems.removeAt(index);
 }
 
@@ -865,6 +1279,7 @@ PSynEditUndoItem SynEditUndoList::PopItem()
     else {
         PSynEditUndoItem item = mItems.last();
         mItems.removeLast();
+        mMemoryUsage -= item->memoryUsage();
         return item;
     }
 }
@@ -874,11 +1289,27 @@ void SynEditUndoList::PushItem(PSynEditUndoItem Item)
     if (!Item)
         return;
     mItems.append(Item);
+    mMemoryUsage += Item->memoryUsage();
     EnsureMaxEntries();
     if (Item->changeReason()!= SynChangeReason::crGroupBreak)
         emit addedUndo();
 }
 
+void SynEditUndoList::restoreItems(const QVector<PSynEditUndoItem> &items)
+{
+    Clear();
+    mItems = items;
+    int lastChangeNumber = 0;
+    foreach (const PSynEditUndoItem& item, mItems) {
+        mMemoryUsage += item->memoryUsage();
+        lastChangeNumber = std::max(lastChangeNumber, item->changeNumber());
+    }
+    mNextChangeNumber = lastChangeNumber+1;
+    EnsureMaxEntries();
+    //the text is unmodified at the end of the restored history
+    mInitialChangeNumber = mItems.isEmpty() ? 0 : mItems.last()->changeNumber();
+}
+
 void SynEditUndoList::Unlock()
 {
     if (mLockCount > 0)
@@ -903,6 +1334,23 @@ int SynEditUndoList::maxUndoActions() const
 void SynEditUndoList::setMaxUndoActions(int maxUndoActions)
 {
     mMaxUndoActions = maxUndoActions;
+    EnsureMaxEntries();
+}
+
+qint64 SynEditUndoList::maxMemoryUsage() const
+{
+    return mMaxMemoryUsage;
+}
+
+void SynEditUndoList::setMaxMemoryUsage(qint64 newMaxMemoryUsage)
+{
+    mMaxMemoryUsage = newMaxMemoryUsage;
+    EnsureMaxEntries();
+}
+
+qint64 SynEditUndoList::memoryUsage() const
+{
+    return mMemoryUsage;
 }
 
 bool SynEditUndoList::initialState()
@@ -943,6 +1391,7 @@ void SynEditUndoList::setItem(int index, PSynEditUndoItem Value)
     if (index <0 || index>=mItems.count()) {
         ListIndexOutOfBounds(index);
     }
+    mMemoryUsage += Value->memoryUsage() - mItems[index]->memoryUsage();
     mItems[index]=Value;
 }
 
@@ -978,12 +1427,87 @@ bool SynEditUndoList::fullUndoImposible() const
 
 void SynEditUndoList::EnsureMaxEntries()
 {
-    if (mItems.count() > mMaxUndoActions){
-        mFullUndoImposible = true;
-        while (mItems.count() > mMaxUndoActions) {
-            mItems.removeFirst();
-      }
+    if (mItems.isEmpty())
+        return;
+    //a change has at least one item, so only count changes when there are enough items
+    int changes = mItems.count() > mMaxUndoActions ? changeCount() : 0;
+    if (changes <= mMaxUndoActions && mMemoryUsage <= mMaxMemoryUsage)
+        return;
+    mFullUndoImposible = true;
+    //drop whole changes from the oldest end, but never the last one or the
+    //one of the open block, which may still get items
+    int lastChangeNumber = mItems.last()->changeNumber();
+    int openChangeNumber = mBlockCount > 0 ? mBlockChangeNumber : 0;
+    int count = 0;
+    qint64 usage = mMemoryUsage;
+    while (count < mItems.count()
+           && (changes > mMaxUndoActions || usage > mMaxMemoryUsage)) {
+        int changeNumber = mItems[count]->changeNumber();
+        if (changeNumber == lastChangeNumber
+                || (openChangeNumber != 0 && changeNumber == openChangeNumber))
+            break;
+        while (count < mItems.count() && mItems[count]->changeNumber() == changeNumber) {
+            usage -= mItems[count]->memoryUsage();
+            count++;
+        }
+        changes--;
+    }
+    if (changes > mMaxUndoActions || usage > mMaxMemoryUsage) {
+        //the changes that must be kept are too big themselves
+        mItems.clear();
+        mMemoryUsage = 0;
+        mTypingChangeNumber = 0;
+        return;
     }
+    mItems.remove(0,count);
+    mMemoryUsage = usage;
+}
+
+int SynEditUndoList::changeCount() const
+{
+    int count = 0;
+    for (int i=0;i<mItems.count();i++) {
+        if (i==0 || mItems[i]->changeNumber() != mItems[i-1]->changeNumber())
+            count++;
+    }
+    return count;
+}
+
+bool SynEditUndoList::tryMergeTyping(SynChangeReason AReason, const BufferCoord &AStart,
+                                     const BufferCoord &AEnd, const QString &ChangeText,
+                                     SynSelectionMode SelMode)
+{
+    //chars typed one after another on the same line are kept as one item
+    if (!isTypedChar(AReason, AStart, AEnd, ChangeText, SelMode)
+            || mInsideRedo)
+        return false;
+    PSynEditUndoItem lastItem = PeekItem();
+    if (!lastItem
+            //the last item is typed too, and is the only item of its block
+            || lastItem->changeNumber() != mTypingChangeNumber
+            || lastItem->changeReason() != SynChangeReason::crInsert
+            || lastItem->changeStartPos().Line != AStart.Line
+            || lastItem->changeEndPos() != AStart
+            //the file was saved after the last item, it must stay a separate change
+            || lastItem->changeNumber() == mInitialChangeNumber)
+        return false;
+    //the new char must not join the block of the last item
+    if (mBlockChangeNumber != 0 && mBlockChangeNumber == lastItem->changeNumber())
+        return false;
+    lastItem->setChangeEndPos(AEnd);
+    emit addedUndo();
+    return true;
+}
+
+bool SynEditUndoList::isTypedChar(SynChangeReason AReason, const BufferCoord &AStart,
+                                  const BufferCoord &AEnd, const QString &ChangeText,
+                                  SynSelectionMode SelMode)
+{
+    return AReason == SynChangeReason::crInsert
+            && ChangeText.isEmpty()
+            && SelMode == SynSelectionMode::smNormal
+            && AStart.Line == AEnd.Line
+            && AEnd.Char - AStart.Char == 1;
 }
 
 SynSelectionMode SynEditUndoItem::changeSelMode() const
@@ -1006,6 +1530,16 @@ QString SynEditUndoItem::changeStr() const
     return mChangeStr;
 }
 
+int SynEditUndoItem::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
+void SynEditUndoItem::setChangeEndPos(const BufferCoord &endPos)
+{
+    mChangeEndPos = endPos;
+}
+
 int SynEditUndoItem::changeNumber() const
 {
     return mChangeNumber;
@@ -1021,6 +1555,8 @@ SynEditUndoItem::SynEditUndoItem(SynChangeReason reason, SynSelectionMode selMod
     mChangeEndPos = endPos;
     mChangeStr = str;
     mChangeNumber = number;
+    //the item, its shared_ptr control block and the text payload
+    mMemoryUsage = sizeof(SynEditUndoItem) + 16 + mChangeStr.length() * sizeof(QChar);
 }
 
 SynChangeReason SynEditUndoItem::changeReason() const
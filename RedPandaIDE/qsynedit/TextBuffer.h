@@ -39,6 +39,9 @@ struct SynEditStringRec {
   void * fObject;
   SynRangeState fRange;
   int fColumns;  //
+  // the line's text in the mapped file, used while fString is not loaded
+  qint64 fMappedOffset; // -1 if the text is in fString
+  int fMappedLength;
 
 public:
   explicit SynEditStringRec();
@@ -57,6 +60,8 @@ typedef std::shared_ptr<SynEditStringList> PSynEditStringList;
 using StringListChangeCallback = std::function<void(PSynEditStringList* object, int index, int count)>;
 
 class QFile;
+class QIODevice;
+class QTextCodec;
 
 class SynEdit;
 class SynEditStringList : public QObject
@@ -104,6 +109,15 @@ public:
     void loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding);
     void saveToFile(QFile& file, const QByteArray& encoding,
                     const QByteArray& defaultEncoding, QByteArray& realEncoding);
+    //the whole text encoded by codec (utf-8 if codec is nullptr), without a copy through QString
+    QByteArray textBytes(QTextCodec* codec=nullptr);
+    //stream the whole text to device; returns false if the device failed to write
+    bool writeTo(QIODevice& device, QTextCodec* codec, bool lineBreakAtEnd, bool& allAscii);
+
+    //keep the file's bytes after loading and decode lines only when they are read
+    bool keepFileMapped() const;
+    void setKeepFileMapped(bool newKeepFileMapped);
+    bool isFileMapped() const;
 
     bool getAppendNewLineAtEOF();
     void setAppendNewLineAtEOF(bool appendNewLineAtEOF);
@@ -132,6 +146,17 @@ protected:
     void putTextStr(const QString& text);
     void internalClear();
 
+private:
+    enum class ExportEncoding {
+        Latin1,
+        Utf8,
+        Codec
+    };
+    static ExportEncoding exportEncodingOf(QTextCodec* codec);
+    QString lineString(const PSynEditStringRec& line) const;
+    //bytes the raw mapped line can be exported as, -1 if it must be decoded first
+    int mappedExportLength(const PSynEditStringRec& line, ExportEncoding encoding) const;
+
 private:
     SynEditStringRecList mList;
 
@@ -144,6 +169,14 @@ private:
     int mUpdateCount;
     QMutex mMutex;
 
+    bool mKeepFileMapped;
+    //a private copy of the file's bytes, not a map of the file, so other
+    //programs changing the file can't change or truncate the lines under us
+    QByteArray mMappedFileData;
+    const uchar* mMappedData;
+    QTextCodec* mMappedCodec; // nullptr for ascii and utf-8
+    bool mMappedUtf8;
+
     int calculateLineColumns(int Index);
 };
 
@@ -171,6 +204,7 @@ private:
     BufferCoord mChangeEndPos;
     QString mChangeStr;
     int mChangeNumber;
+    int mMemoryUsage;
 public:
     SynEditUndoItem(SynChangeReason reason,
         SynSelectionMode selMode,
@@ -185,6 +219,9 @@ public:
     BufferCoord changeEndPos() const;
     QString changeStr() const;
     int changeNumber() const;
+    //approximate bytes held by the item
+    int memoryUsage() const;
+    void setChangeEndPos(const BufferCoord& endPos);
 };
 using PSynEditUndoItem = std::shared_ptr<SynEditUndoItem>;
 
@@ -206,6 +243,8 @@ public:
     PSynEditUndoItem PeekItem();
     PSynEditUndoItem PopItem();
     void PushItem(PSynEditUndoItem Item);
+    //replace the history with items recorded earlier for the current text
+    void restoreItems(const QVector<PSynEditUndoItem>& items);
     void Unlock();
 
     bool CanUndo();
@@ -213,6 +252,10 @@ public:
 
     int maxUndoActions() const;
     void setMaxUndoActions(int maxUndoActions);
+    //oldest changes are dropped when the items hold more than this many bytes
+    qint64 maxMemoryUsage() const;
+    void setMaxMemoryUsage(qint64 newMaxMemoryUsage);
+    qint64 memoryUsage() const;
     bool initialState();
     PSynEditUndoItem item(int index);
     void setInitialState(const bool Value);
@@ -232,6 +275,11 @@ signals:
     void addedUndo();
 protected:
     void EnsureMaxEntries();
+    int changeCount() const;
+    bool tryMergeTyping(SynChangeReason AReason, const BufferCoord& AStart, const BufferCoord& AEnd,
+                        const QString& ChangeText, SynSelectionMode SelMode);
+    static bool isTypedChar(SynChangeReason AReason, const BufferCoord& AStart, const BufferCoord& AEnd,
+                            const QString& ChangeText, SynSelectionMode SelMode);
 protected:
     int mBlockChangeNumber;
     int mBlockCount;
@@ -239,8 +287,11 @@ protected:
     QVector<PSynEditUndoItem> mItems;
     int mLockCount;
     int mMaxUndoActions;
+    qint64 mMaxMemoryUsage;
+    qint64 mMemoryUsage;
     int mNextChangeNumber;
     int mInitialChangeNumber;
+    int mTypingChangeNumber; // change number of the last item if typing can be merged into it, 0 otherwise
     bool mInsideRedo;
 };
 
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "recoveryjournal.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtEndian>
+#include <QCryptographicHash>
+#include <QUuid>
+#include <cstring>
+#include "settings.h"
+#include "systemconsts.h"
+#include "utils.h"
+
+static const char JournalMagic[4] = {'R','P','R','J'};
+static const quint32 JournalVersion = 2;
+static const int JournalHeaderSize = 8; // magic + version
+static const QDataStream::Version JournalStreamVersion = QDataStream::Qt_5_6;
+// first line, old and new line counts
+static const int ChangeHeaderSize = 3*4;
+
+namespace {
+
+class RecoveryJournalWriteTask : public QRunnable
+{
+public:
+    enum class Mode {
+        Append,
+        Rewrite,
+        Remove
+    };
+    RecoveryJournalWriteTask(const QString& filename, const QByteArray& data, Mode mode):
+        mFilename(filename),
+        mData(data),
+        mMode(mode)
+    {
+    }
+
+    void run() override
+    {
+        if (mMode == Mode::Remove) {
+            QFile::remove(mFilename);
+            return;
+        }
+        QDir().mkpath(extractFileDir(mFilename));
+        QFile file(mFilename);
+        if (file.open(mMode == Mode::Rewrite ? (QFile::WriteOnly | QFile::Truncate)
+                      : (QFile::WriteOnly | QFile::Append)))
+            file.write(mData);
+    }
+private:
+    QString mFilename;
+    QByteArray mData;
+    Mode mMode;
+};
+
+}
+
+static QThreadPool* writerPool()
+{
+    //one thread keeps the writes to a journal in order
+    static QThreadPool* pool = [](){
+        QThreadPool* p = new QThreadPool();
+        p->setMaxThreadCount(1);
+        return p;
+    }();
+    return pool;
+}
+
+static QByteArray makeBlock(const QByteArray& payload)
+{
+    quint32 size = qToLittleEndian((quint32)payload.length());
+    QByteArray block(reinterpret_cast<const char*>(&size),sizeof(size));
+    block.append(payload);
+    return block;
+}
+
+//the next size prefixed block, false at the end or at a block cut off by a crash
+static bool readBlock(const QByteArray& content, int& pos, QByteArray& payload)
+{
+    if (pos+4 > content.length())
+        return false;
+    quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(content.constData()+pos));
+    if (pos+4+(qint64)size > content.length())
+        return false;
+    payload = content.mid(pos+4,size);
+    pos += 4+size;
+    return true;
+}
+
+struct JournalHeader {
+    QString sourceFilename;
+    bool untitled;
+    qint64 ownerPid;
+    qint64 baseSize;
+    qint64 baseModified;
+    qint32 baseLineCount;
+};
+
+static bool readHeader(const QByteArray& content, int& pos, JournalHeader& header)
+{
+    if (content.length()<JournalHeaderSize
+            || memcmp(content.constData(),JournalMagic,sizeof(JournalMagic))!=0
+            || qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(content.constData()+4))
+               != JournalVersion)
+        return false;
+    pos = JournalHeaderSize;
+    QByteArray payload;
+    if (!readBlock(content,pos,payload))
+        return false;
+    QDataStream stream(payload);
+    stream.setVersion(JournalStreamVersion);
+    stream>>header.sourceFilename>>header.untitled>>header.ownerPid
+         >>header.baseSize>>header.baseModified>>header.baseLineCount;
+    return stream.status() == QDataStream::Ok && header.baseLineCount>=0;
+}
+
+static QString sessionLockFilename(qint64 pid)
+{
+    return includeTrailingPathDelimiter(
+                pSettings->dirs().config(Settings::Dirs::DataType::RecoveryJournal))
+            + QString("%1.lock").arg(pid);
+}
+
+//held from the first journal this session writes until it exits
+static void lockSession()
+{
+    static QLockFile lock([](){
+        QDir().mkpath(pSettings->dirs().config(Settings::Dirs::DataType::RecoveryJournal));
+        return sessionLockFilename(QCoreApplication::applicationPid());
+    }());
+    if (lock.isLocked())
+        return;
+    //a session is never stale while its process runs
+    lock.setStaleLockTime(0);
+    if (!lock.tryLock(0)) {
+        //left by a dead process that had the same pid
+        lock.removeStaleLockFile();
+        lock.tryLock(0);
+    }
+}
+
+static bool isSessionRunning(qint64 pid)
+{
+    QString filename = sessionLockFilename(pid);
+    if (!fileExists(filename))
+        return false;
+    QLockFile lock(filename);
+    lock.setStaleLockTime(0);
+    //taking over the lock of a dead session removes it
+    if (lock.tryLock(0)) {
+        lock.unlock();
+        return false;
+    }
+    return lock.error() == QLockFile::LockFailedError;
+}
+
+RecoveryJournal::RecoveryJournal(PSynEditStringList lines, QObject *parent):
+    QObject(parent),
+    mLines(lines),
+    mUntitled(false),
+    mBaseSize(-1),
+    mBaseLineCount(0),
+    mHeaderWritten(false),
+    mDirty(false),
+    mDirtyFirst(0),
+    mDirtyLast(0)
+{
+    connect(mLines.get(),&SynEditStringList::deleted,
+            this, &RecoveryJournal::onLinesDeleted);
+    connect(mLines.get(),&SynEditStringList::inserted,
+            this, &RecoveryJournal::onLinesInserted);
+    connect(mLines.get(),&SynEditStringList::putted,
+            this, &RecoveryJournal::onLinesPutted);
+}
+
+void RecoveryJournal::resetBase(const QString &sourceFilename)
+{
+    QString key = QFileInfo(sourceFilename).absoluteFilePath();
+    if (PATH_SENSITIVITY == Qt::CaseInsensitive)
+        key = key.toLower();
+    setBase(sourceFilename, key, false);
+}
+
+void RecoveryJournal::resetUntitledBase(const QString &caption)
+{
+    //the caption is reused by later sessions, it can't tell the buffers apart
+    setBase(caption, QString::fromLatin1(QUuid::createUuid().toRfc4122().toHex()), true);
+}
+
+void RecoveryJournal::checkpoint()
+{
+    if (!mDirty || mJournalFilename.isEmpty())
+        return;
+    int count = mLines->count();
+    int first = mDirtyFirst;
+    int last = std::min(mDirtyLast,count);
+    //the lines after the changed range are the same as at the last checkpoint
+    int oldCount = mBaseLineCount - first - (count - last);
+    if (first<0 || first>last || oldCount<0) {
+        first = 0;
+        last = count;
+        oldCount = mBaseLineCount;
+    }
+    QByteArray data;
+    if (!mHeaderWritten) {
+        lockSession();
+        quint32 version = qToLittleEndian(JournalVersion);
+        data.append(JournalMagic,sizeof(JournalMagic));
+        data.append(reinterpret_cast<const char*>(&version),sizeof(version));
+        QByteArray header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+        stream.setVersion(JournalStreamVersion);
+        stream<<mSourceFilename<<mUntitled<<(qint64)QCoreApplication::applicationPid()
+             <<mBaseSize
+             <<(mBaseModified.isValid()?mBaseModified.toMSecsSinceEpoch():(qint64)0)
+            <<(qint32)mBaseLineCount;
+        data.append(makeBlock(header));
+    }
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(JournalStreamVersion);
+    stream<<(qint32)first<<(qint32)oldCount<<(qint32)(last-first);
+    for (int i=first;i<last;i++) {
+        stream<<mLines->getString(i).toUtf8();
+    }
+    data.append(makeBlock(payload));
+    writerPool()->start(new RecoveryJournalWriteTask(
+                            mJournalFilename, data,
+                            mHeaderWritten ? RecoveryJournalWriteTask::Mode::Append
+                                           : RecoveryJournalWriteTask::Mode::Rewrite));
+    mHeaderWritten = true;
+    mBaseLineCount = count;
+    mDirty = false;
+}
+
+void RecoveryJournal::discard()
+{
+    if (mHeaderWritten) {
+        writerPool()->start(new RecoveryJournalWriteTask(
+                                mJournalFilename, QByteArray(),
+                                RecoveryJournalWriteTask::Mode::Remove));
+    }
+    mHeaderWritten = false;
+    mDirty = false;
+    mBaseLineCount = mLines->count();
+}
+
+QList<RecoveryJournal::PendingJournal> RecoveryJournal::pendingJournals()
+{
+    QList<PendingJournal> result;
+    QDir dir(pSettings->dirs().config(Settings::Dirs::DataType::RecoveryJournal));
+    qint64 currentPid = QCoreApplication::applicationPid();
+    foreach (const QFileInfo& info, dir.entryInfoList(QStringList{"*.journal"},QDir::Files)) {
+        QFile file(info.absoluteFilePath());
+        if (!file.open(QFile::ReadOnly))
+            continue;
+        //the header is at the start, no need to read the changes
+        QByteArray content = file.read(64*1024);
+        PendingJournal journal;
+        journal.journalFilename = info.absoluteFilePath();
+        JournalHeader header;
+        int pos;
+        if (!readHeader(content,pos,header)) {
+            journal.untitled = false;
+            journal.baseLineCount = 0;
+            journal.baseValid = false;
+        } else {
+            //still being written by a running instance
+            if (header.ownerPid == currentPid || isSessionRunning(header.ownerPid))
+                continue;
+            journal.sourceFilename = header.sourceFilename;
+            journal.untitled = header.untitled;
+            journal.baseLineCount = header.baseLineCount;
+            if (header.untitled) {
+                journal.baseValid = true;
+            } else {
+                QFileInfo sourceInfo(journal.sourceFilename);
+                journal.baseValid = sourceInfo.exists()
+                        && sourceInfo.size() == header.baseSize
+                        && sourceInfo.lastModified().toMSecsSinceEpoch() == header.baseModified;
+            }
+        }
+        result.append(journal);
+    }
+    //sessions that died after their journals were dropped
+    foreach (const QFileInfo& info, dir.entryInfoList(QStringList{"*.lock"},QDir::Files)) {
+        bool ok;
+        qint64 pid = info.completeBaseName().toLongLong(&ok);
+        if (ok && pid != currentPid)
+            isSessionRunning(pid);
+    }
+    return result;
+}
+
+bool RecoveryJournal::replay(const QString &journalFilename, QStringList &lines)
+{
+    QFile file(journalFilename);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    QByteArray content = file.readAll();
+    JournalHeader header;
+    int pos;
+    if (!readHeader(content,pos,header))
+        return false;
+    QByteArray payload;
+    while (readBlock(content,pos,payload)) {
+        QDataStream stream(payload);
+        stream.setVersion(JournalStreamVersion);
+        qint32 first,oldCount,newCount;
+        stream>>first>>oldCount>>newCount;
+        //each line takes at least its size prefix, more can't be in the block
+        if (stream.status()!=QDataStream::Ok
+                || first<0 || oldCount<0 || newCount<0
+                || first>lines.count() || oldCount>lines.count()-first
+                || newCount>(payload.length()-ChangeHeaderSize)/4)
+            return false;
+        QStringList newLines;
+        newLines.reserve(newCount);
+        for (int i=0;i<newCount;i++) {
+            QByteArray line;
+            stream>>line;
+            newLines.append(QString::fromUtf8(line));
+        }
+        if (stream.status()!=QDataStream::Ok)
+            return false;
+        lines.erase(lines.begin()+first,lines.begin()+first+oldCount);
+        for (int i=0;i<newCount;i++)
+            lines.insert(first+i,newLines[i]);
+    }
+    return true;
+}
+
+void RecoveryJournal::waitForWrites()
+{
+    writerPool()->waitForDone();
+}
+
+void RecoveryJournal::onLinesDeleted(int index, int count)
+{
+    markChanged(index,count,0);
+}
+
+void RecoveryJournal::onLinesInserted(int index, int count)
+{
+    markChanged(index,0,count);
+}
+
+void RecoveryJournal::onLinesPutted(int index, int count)
+{
+    markChanged(index,count,count);
+}
+
+void RecoveryJournal::markChanged(int index, int oldCount, int newCount)
+{
+    if (!mDirty) {
+        mDirty = true;
+        mDirtyFirst = index;
+        mDirtyLast = index+newCount;
+        return;
+    }
+    //lines after the change move, the changed range grows to cover it
+    if (mDirtyLast >= index+oldCount)
+        mDirtyLast += newCount-oldCount;
+    else
+        mDirtyLast = index+newCount;
+    mDirtyFirst = std::min(mDirtyFirst,index);
+}
+
+void RecoveryJournal::setBase(const QString &sourceFilename, const QString &journalKey, bool untitled)
+{
+    discard();
+    mSourceFilename = sourceFilename;
+    mJournalFilename = journalFilename(journalKey);
+    mUntitled = untitled;
+    QFileInfo fileInfo(sourceFilename);
+    mBaseSize = (!untitled && fileInfo.exists()) ? fileInfo.size() : -1;
+    mBaseModified = untitled ? QDateTime() : fileInfo.lastModified();
+    mBaseLineCount = mLines->count();
+}
+
+QString RecoveryJournal::journalFilename(const QString &key)
+{
+    return includeTrailingPathDelimiter(
+                pSettings->dirs().config(Settings::Dirs::DataType::RecoveryJournal))
+            + QString::fromLatin1(
+                QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex())
+            + ".journal";
+}
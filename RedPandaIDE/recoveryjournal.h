@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef RECOVERYJOURNAL_H
+#define RECOVERYJOURNAL_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QStringList>
+#include <memory>
+#include "qsynedit/TextBuffer.h"
+
+/**
+ * Auto-save target that records only what changed.
+ *
+ * It tracks the range of lines edited since the last checkpoint. A checkpoint
+ * appends those lines to a per-file journal in the config folder, on a
+ * background thread. The journal is relative to the file as it was last loaded
+ * or saved, and is dropped when the file is saved for real. Untitled buffers are
+ * journaled from their empty start, under a key made up for the buffer.
+ *
+ * The session writing journals holds a lock file, so another instance running
+ * at the same time leaves its journals alone.
+ */
+class RecoveryJournal : public QObject
+{
+    Q_OBJECT
+public:
+    struct PendingJournal {
+        QString journalFilename;
+        QString sourceFilename; // the caption of an untitled buffer
+        bool untitled;
+        int baseLineCount; // lines of the buffer the changes start from
+        bool baseValid; // the source file is still the one the journal started from
+    };
+
+    explicit RecoveryJournal(PSynEditStringList lines, QObject* parent = nullptr);
+    //the lines now equal the source file on the disk
+    void resetBase(const QString& sourceFilename);
+    //the lines are a new buffer that isn't saved anywhere yet
+    void resetUntitledBase(const QString& caption);
+    //append the lines changed since the last checkpoint
+    void checkpoint();
+    //drop the journal, the changes are saved or thrown away
+    void discard();
+
+    //journals left behind by a session that didn't end normally
+    static QList<PendingJournal> pendingJournals();
+    //apply the journaled changes to the lines of its source file
+    static bool replay(const QString& journalFilename, QStringList& lines);
+    static void waitForWrites();
+private slots:
+    void onLinesDeleted(int index, int count);
+    void onLinesInserted(int index, int count);
+    void onLinesPutted(int index, int count);
+private:
+    void markChanged(int index, int oldCount, int newCount);
+    void setBase(const QString& sourceFilename, const QString& journalKey, bool untitled);
+    static QString journalFilename(const QString& key);
+private:
+    PSynEditStringList mLines;
+    QString mSourceFilename;
+    QString mJournalFilename;
+    bool mUntitled;
+    qint64 mBaseSize;
+    QDateTime mBaseModified;
+    int mBaseLineCount; // line count at the last checkpoint
+    bool mHeaderWritten;
+    bool mDirty;
+    int mDirtyFirst;
+    int mDirtyLast; // exclusive, in current line numbers
+};
+
+using PRecoveryJournal = std::shared_ptr<RecoveryJournal>;
+
+#endif // RECOVERYJOURNAL_H
@@ -27,6 +27,9 @@
 #include <QScreen>
 #include <QDesktopWidget>
 #include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
 
 const char ValueToChar[28] = {'0', '1', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h',
                               'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r',
@@ -214,6 +217,9 @@ QString Settings::Dirs::data(Settings::Dirs::DataType dataType) const
         return ":/resources/iconsets";
     case DataType::Theme:
         return ":/themes";
+    case DataType::UndoJournal:
+    case DataType::RecoveryJournal:
+        return "";
     }
     return "";
 }
@@ -232,6 +238,10 @@ QString Settings::Dirs::config(Settings::Dirs::DataType dataType) const
         return includeTrailingPathDelimiter(configDir)+"iconsets";
     case DataType::Theme:
         return includeTrailingPathDelimiter(configDir)+"themes";
+    case DataType::UndoJournal:
+        return includeTrailingPathDelimiter(configDir)+"undo";
+    case DataType::RecoveryJournal:
+        return includeTrailingPathDelimiter(configDir)+"recovery";
     }
     return "";
 }
@@ -566,6 +576,66 @@ void Settings::Editor::setMouseWheelScrollSpeed(int newMouseWheelScrollSpeed)
     mMouseWheelScrollSpeed = newMouseWheelScrollSpeed;
 }
 
+bool Settings::Editor::enableLargeFileMode() const
+{
+    return mEnableLargeFileMode;
+}
+
+void Settings::Editor::setEnableLargeFileMode(bool newEnableLargeFileMode)
+{
+    mEnableLargeFileMode = newEnableLargeFileMode;
+}
+
+int Settings::Editor::largeFileSize() const
+{
+    return mLargeFileSize;
+}
+
+void Settings::Editor::setLargeFileSize(int newLargeFileSize)
+{
+    mLargeFileSize = newLargeFileSize;
+}
+
+int Settings::Editor::undoMemoryUsage() const
+{
+    return mUndoMemoryUsage;
+}
+
+void Settings::Editor::setUndoMemoryUsage(int newUndoMemoryUsage)
+{
+    mUndoMemoryUsage = newUndoMemoryUsage;
+}
+
+int Settings::Editor::undoLimit() const
+{
+    return mUndoLimit;
+}
+
+void Settings::Editor::setUndoLimit(int newUndoLimit)
+{
+    mUndoLimit = newUndoLimit;
+}
+
+bool Settings::Editor::persistentUndo() const
+{
+    return mPersistentUndo;
+}
+
+void Settings::Editor::setPersistentUndo(bool newPersistentUndo)
+{
+    mPersistentUndo = newPersistentUndo;
+}
+
+int Settings::Editor::undoJournalSize() const
+{
+    return mUndoJournalSize;
+}
+
+void Settings::Editor::setUndoJournalSize(int newUndoJournalSize)
+{
+    mUndoJournalSize = newUndoJournalSize;
+}
+
 bool Settings::Editor::useUTF8ByDefault() const
 {
     return mUseUTF8ByDefault;
@@ -1183,6 +1253,12 @@ void Settings::Editor::doSave()
     saveValue("auto_load_last_files",mAutoLoadLastFiles);
     saveValue("default_file_cpp",mDefaultFileCpp);
     saveValue("use_utf8_by_default",mUseUTF8ByDefault);
+    saveValue("enable_large_file_mode",mEnableLargeFileMode);
+    saveValue("large_file_size",mLargeFileSize);
+    saveValue("undo_memory_usage",mUndoMemoryUsage);
+    saveValue("undo_limit",mUndoLimit);
+    saveValue("persistent_undo",mPersistentUndo);
+    saveValue("undo_journal_size",mUndoJournalSize);
 
 
     //tooltips
@@ -1316,6 +1392,12 @@ void Settings::Editor::doLoad()
     mAutoLoadLastFiles = boolValue("auto_load_last_files",true);
     mDefaultFileCpp = boolValue("default_file_cpp",true);
     mUseUTF8ByDefault = boolValue("use_utf8_by_default",false);
+    mEnableLargeFileMode = boolValue("enable_large_file_mode",true);
+    mLargeFileSize = intValue("large_file_size",16);
+    mUndoMemoryUsage = intValue("undo_memory_usage",50);
+    mUndoLimit = intValue("undo_limit",1000);
+    mPersistentUndo = boolValue("persistent_undo",false);
+    mUndoJournalSize = intValue("undo_journal_size",4);
 
     //tooltips
     mEnableTooltips = boolValue("enable_tooltips",true);
@@ -1983,6 +2065,70 @@ void Settings::CompilerSet::setDefines() {
     }
 }
 
+void Settings::CompilerSet::probe()
+{
+    if (mBinDirs.isEmpty())
+        return;
+    mDefaultCIncludeDirs.clear();
+    mDefaultCppIncludeDirs.clear();
+    mDefaultLibDirs.clear();
+    QString binDir = mBinDirs[0];
+    setDirectories(binDir);
+    setDefines();
+}
+
+QString Settings::CompilerSet::probeKey() const
+{
+    if (mBinDirs.isEmpty())
+        return QString();
+    return includeTrailingPathDelimiter(mBinDirs[0])+GCC_PROGRAM+"|"+mCCompiler;
+}
+
+QString Settings::CompilerSet::probeStamp() const
+{
+    if (mBinDirs.isEmpty())
+        return QString();
+    QStringList stamps;
+    // every binary whose location or version ends up in the result
+    QStringList filenames{includeTrailingPathDelimiter(mBinDirs[0])+GCC_PROGRAM,
+                mCCompiler, mCppCompiler, mMake, mDebugger};
+    foreach (const QString& filename, filenames) {
+        QFileInfo info(filename);
+        stamps.append(QString("%1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()));
+    }
+    return stamps.join(";");
+}
+
+QJsonObject Settings::CompilerSet::probeResult() const
+{
+    QJsonObject result;
+    result["stamp"]=probeStamp();
+    result["bin_dirs"]=QJsonArray::fromStringList(mBinDirs);
+    result["c_include_dirs"]=QJsonArray::fromStringList(mDefaultCIncludeDirs);
+    result["cpp_include_dirs"]=QJsonArray::fromStringList(mDefaultCppIncludeDirs);
+    result["lib_dirs"]=QJsonArray::fromStringList(mDefaultLibDirs);
+    result["defines"]=QJsonArray::fromStringList(mDefines);
+    return result;
+}
+
+void Settings::CompilerSet::setProbeResult(const QJsonObject &result)
+{
+    mDefaultCIncludeDirs.clear();
+    mDefaultCppIncludeDirs.clear();
+    mDefaultLibDirs.clear();
+    mDefines.clear();
+    foreach (const QJsonValue& value, result["bin_dirs"].toArray())
+        addExistingDirectory(mBinDirs, value.toString());
+    foreach (const QJsonValue& value, result["c_include_dirs"].toArray())
+        addExistingDirectory(mDefaultCIncludeDirs, value.toString());
+    foreach (const QJsonValue& value, result["cpp_include_dirs"].toArray())
+        addExistingDirectory(mDefaultCppIncludeDirs, value.toString());
+    foreach (const QJsonValue& value, result["lib_dirs"].toArray())
+        addExistingDirectory(mDefaultLibDirs, value.toString());
+    foreach (const QJsonValue& value, result["defines"].toArray())
+        mDefines.append(value.toString());
+}
+
 void Settings::CompilerSet::setExecutables()
 {
     mCCompiler = findProgramInBinDirs(GCC_PROGRAM);
@@ -2611,6 +2757,32 @@ void Settings::CompilerSets::loadSets()
         mList.clear();
         mDefaultIndex = -1;
     }
+    // use cached probe results, only run compilers never probed before
+    QJsonObject probeCache = loadProbeCache();
+    QList<PCompilerSet> setsToProbe;
+    QList<PCompilerSet> setsToRefresh;
+    for (const PCompilerSet& pSet:mList) {
+        QJsonObject result = probeCache[pSet->probeKey()].toObject();
+        if (result.isEmpty()) {
+            setsToProbe.append(pSet);
+        } else {
+            pSet->setProbeResult(result);
+            if (result["stamp"].toString()!=pSet->probeStamp())
+                setsToRefresh.append(pSet);
+        }
+    }
+    if (!setsToProbe.isEmpty()) {
+        probeSets(setsToProbe);
+        QJsonObject newCache;
+        for (const PCompilerSet& pSet:mList) {
+            if (setsToProbe.contains(pSet))
+                newCache[pSet->probeKey()]=pSet->probeResult();
+            else if (probeCache.contains(pSet->probeKey()))
+                newCache[pSet->probeKey()]=probeCache[pSet->probeKey()];
+        }
+        saveProbeCache(newCache);
+    }
+    refreshProbesInBackground(setsToRefresh);
     PCompilerSet pCurrentSet = defaultSet();
     if (pCurrentSet) {
         QString msg;
@@ -2727,7 +2899,8 @@ Settings::PCompilerSet Settings::CompilerSets::defaultSet()
 Settings::PCompilerSet Settings::CompilerSets::getSet(int index)
 {
     if (index>=0 && index<mList.size()) {
-        return mList[index];
+        // compilers read the sets in their own threads, see refreshProbesInBackground()
+        return std::atomic_load(&mList[index]);
     }
     return PCompilerSet();
 }
@@ -2876,11 +3049,73 @@ Settings::PCompilerSet Settings::CompilerSets::loadSet(int index)
 
     if (pSet->binDirs().isEmpty())
         return PCompilerSet();
-    pSet->setDirectories(pSet->binDirs()[0]);
-    pSet->setDefines();
+    // directories and defines are probed by loadSets()
     return pSet;
 }
 
+QJsonObject Settings::CompilerSets::loadProbeCache()
+{
+    QFile file(QDir(QFileInfo(mSettings->filename()).path()).filePath(DEV_COMPILER_SET_PROBES_FILE));
+    if (!file.open(QFile::ReadOnly))
+        return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void Settings::CompilerSets::saveProbeCache(const QJsonObject &cache)
+{
+    QFile file(QDir(QFileInfo(mSettings->filename()).path()).filePath(DEV_COMPILER_SET_PROBES_FILE));
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(QJsonDocument(cache).toJson(QJsonDocument::Compact));
+    }
+}
+
+void Settings::CompilerSets::probeSets(const QList<PCompilerSet> &sets)
+{
+    // each set only touches its own fields, so sets can be probed at the same time
+    QList<QThread*> threads;
+    foreach (const PCompilerSet& pSet, sets) {
+        QThread* thread = QThread::create([pSet](){
+            pSet->probe();
+        });
+        thread->start();
+        threads.append(thread);
+    }
+    foreach (QThread* thread, threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void Settings::CompilerSets::refreshProbesInBackground(const QList<PCompilerSet> &sets)
+{
+    foreach (const PCompilerSet& pSet, sets) {
+        // probe a copy, the set itself is in use by the main thread and compilers
+        PCompilerSet probedSet = std::make_shared<CompilerSet>(*pSet);
+        std::weak_ptr<CompilerSet> weakSet = pSet;
+        QString key = pSet->probeKey();
+        QThread* thread = QThread::create([probedSet](){
+            probedSet->probe();
+        });
+        QObject::connect(thread, &QThread::finished,
+                         QApplication::instance(), [this,thread,probedSet,weakSet,key](){
+            thread->deleteLater();
+            QJsonObject result = probedSet->probeResult();
+            PCompilerSet pSet = weakSet.lock();
+            auto it = std::find(mList.begin(), mList.end(), pSet);
+            if (pSet && it!=mList.end() && pSet->probeKey()==key) {
+                // a running compiler may be reading the set, replace it instead of changing it
+                PCompilerSet newSet = std::make_shared<CompilerSet>(*pSet);
+                newSet->setProbeResult(result);
+                std::atomic_store(&(*it), newSet);
+            }
+            QJsonObject cache = loadProbeCache();
+            cache[key]=result;
+            saveProbeCache(cache);
+        });
+        thread->start();
+    }
+}
+
 Settings::Environment::Environment(Settings *settings):_Base(settings, SETTING_ENVIRONMENT)
 {
 
@@ -3130,6 +3365,26 @@ void Settings::Executor::setIgnoreSpacesWhenValidatingCases(bool newIgnoreSpaces
     mIgnoreSpacesWhenValidatingCases = newIgnoreSpacesWhenValidatingCases;
 }
 
+bool Settings::Executor::enableFloatToleranceWhenValidatingCases() const
+{
+    return mEnableFloatToleranceWhenValidatingCases;
+}
+
+void Settings::Executor::setEnableFloatToleranceWhenValidatingCases(bool newEnableFloatToleranceWhenValidatingCases)
+{
+    mEnableFloatToleranceWhenValidatingCases = newEnableFloatToleranceWhenValidatingCases;
+}
+
+double Settings::Executor::floatToleranceWhenValidatingCases() const
+{
+    return mFloatToleranceWhenValidatingCases;
+}
+
+void Settings::Executor::setFloatToleranceWhenValidatingCases(double newFloatToleranceWhenValidatingCases)
+{
+    mFloatToleranceWhenValidatingCases = newFloatToleranceWhenValidatingCases;
+}
+
 bool Settings::Executor::caseEditorFontOnlyMonospaced() const
 {
     return mCaseEditorFontOnlyMonospaced;
@@ -3140,6 +3395,36 @@ void Settings::Executor::setCaseEditorFontOnlyMonospaced(bool newCaseEditorFontO
     mCaseEditorFontOnlyMonospaced = newCaseEditorFontOnlyMonospaced;
 }
 
+bool Settings::Executor::enableCompileCache() const
+{
+    return mEnableCompileCache;
+}
+
+void Settings::Executor::setEnableCompileCache(bool newEnableCompileCache)
+{
+    mEnableCompileCache = newEnableCompileCache;
+}
+
+int Settings::Executor::compileCacheMaxSize() const
+{
+    return mCompileCacheMaxSize;
+}
+
+void Settings::Executor::setCompileCacheMaxSize(int newCompileCacheMaxSize)
+{
+    mCompileCacheMaxSize = newCompileCacheMaxSize;
+}
+
+bool Settings::Executor::autoPrecompileHeaders() const
+{
+    return mAutoPrecompileHeaders;
+}
+
+void Settings::Executor::setAutoPrecompileHeaders(bool newAutoPrecompileHeaders)
+{
+    mAutoPrecompileHeaders = newAutoPrecompileHeaders;
+}
+
 int Settings::Executor::caseEditorFontSize() const
 {
     return mCaseEditorFontSize;
@@ -3193,9 +3478,15 @@ void Settings::Executor::doSave()
     saveValue("enable_competivie_companion", mEnableCompetitiveCompanion);
     saveValue("competitive_companion_port", mCompetivieCompanionPort);
     saveValue("ignore_spaces_when_validating_cases", mIgnoreSpacesWhenValidatingCases);
+    saveValue("enable_float_tolerance_when_validating_cases", mEnableFloatToleranceWhenValidatingCases);
+    saveValue("float_tolerance_when_validating_cases", mFloatToleranceWhenValidatingCases);
     saveValue("case_editor_font_name",mCaseEditorFontName);
     saveValue("case_editor_font_size",mCaseEditorFontSize);
     saveValue("case_editor_font_only_monospaced",mCaseEditorFontOnlyMonospaced);
+    //compile cache
+    saveValue("enable_compile_cache", mEnableCompileCache);
+    saveValue("compile_cache_max_size", mCompileCacheMaxSize);
+    saveValue("auto_precompile_headers", mAutoPrecompileHeaders);
 }
 
 bool Settings::Executor::pauseConsole() const
@@ -3221,6 +3512,8 @@ void Settings::Executor::doLoad()
     mEnableCompetitiveCompanion = boolValue("enable_competivie_companion",true);
     mCompetivieCompanionPort = intValue("competitive_companion_port",10045);
     mIgnoreSpacesWhenValidatingCases = boolValue("ignore_spaces_when_validating_cases",false);
+    mEnableFloatToleranceWhenValidatingCases = boolValue("enable_float_tolerance_when_validating_cases",false);
+    mFloatToleranceWhenValidatingCases = value("float_tolerance_when_validating_cases",1e-6).toDouble();
 #ifdef Q_OS_WIN
     mCaseEditorFontName = stringValue("case_editor_font_name","consolas");
 #else
@@ -3228,6 +3521,10 @@ void Settings::Executor::doLoad()
 #endif
     mCaseEditorFontSize = intValue("case_editor_font_size",12);
     mCaseEditorFontOnlyMonospaced = boolValue("case_editor_font_only_monospaced",true);
+
+    mEnableCompileCache = boolValue("enable_compile_cache",true);
+    mCompileCacheMaxSize = intValue("compile_cache_max_size",256);
+    mAutoPrecompileHeaders = boolValue("auto_precompile_headers",true);
 }
 
 
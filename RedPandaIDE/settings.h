@@ -21,6 +21,7 @@
 #include <vector>
 #include <memory>
 #include <QColor>
+#include <QJsonObject>
 #include <QString>
 #include "qsynedit/SynEdit.h"
 
@@ -104,7 +105,9 @@ public:
             None,
             ColorScheme,
             IconSet,
-            Theme
+            Theme,
+            UndoJournal,
+            RecoveryJournal
         };
         explicit Dirs(Settings * settings);
         QString appDir() const;
@@ -356,6 +359,24 @@ public:
         int mouseWheelScrollSpeed() const;
         void setMouseWheelScrollSpeed(int newMouseWheelScrollSpeed);
 
+        bool enableLargeFileMode() const;
+        void setEnableLargeFileMode(bool newEnableLargeFileMode);
+
+        int largeFileSize() const;
+        void setLargeFileSize(int newLargeFileSize);
+
+        int undoMemoryUsage() const;
+        void setUndoMemoryUsage(int newUndoMemoryUsage);
+
+        int undoLimit() const;
+        void setUndoLimit(int newUndoLimit);
+
+        bool persistentUndo() const;
+        void setPersistentUndo(bool newPersistentUndo);
+
+        int undoJournalSize() const;
+        void setUndoJournalSize(int newUndoJournalSize);
+
         bool useUTF8ByDefault() const;
         void setUseUTF8ByDefault(bool newUseUTF8ByDefault);
 
@@ -476,6 +497,12 @@ public:
         bool mAutoLoadLastFiles;
         bool mDefaultFileCpp;
         bool mUseUTF8ByDefault;
+        bool mEnableLargeFileMode;
+        int mLargeFileSize; // in MB
+        int mUndoMemoryUsage; // in MB
+        int mUndoLimit;
+        bool mPersistentUndo;
+        int mUndoJournalSize; // in MB
 
         //hints tooltip
         bool mEnableTooltips;
@@ -849,6 +876,12 @@ public:
         bool ignoreSpacesWhenValidatingCases() const;
         void setIgnoreSpacesWhenValidatingCases(bool newIgnoreSpacesWhenValidatingCases);
 
+        bool enableFloatToleranceWhenValidatingCases() const;
+        void setEnableFloatToleranceWhenValidatingCases(bool newEnableFloatToleranceWhenValidatingCases);
+
+        double floatToleranceWhenValidatingCases() const;
+        void setFloatToleranceWhenValidatingCases(double newFloatToleranceWhenValidatingCases);
+
         const QString &caseEditorFontName() const;
         void setCaseEditorFontName(const QString &newCaseEditorFontName);
 
@@ -858,6 +891,15 @@ public:
         bool caseEditorFontOnlyMonospaced() const;
         void setCaseEditorFontOnlyMonospaced(bool newCaseEditorFontOnlyMonospaced);
 
+        bool enableCompileCache() const;
+        void setEnableCompileCache(bool newEnableCompileCache);
+
+        int compileCacheMaxSize() const;
+        void setCompileCacheMaxSize(int newCompileCacheMaxSize);
+
+        bool autoPrecompileHeaders() const;
+        void setAutoPrecompileHeaders(bool newAutoPrecompileHeaders);
+
     private:
         // general
         bool mPauseConsole;
@@ -872,10 +914,17 @@ public:
         bool mEnableCompetitiveCompanion;
         int mCompetivieCompanionPort;
         bool mIgnoreSpacesWhenValidatingCases;
+        bool mEnableFloatToleranceWhenValidatingCases;
+        double mFloatToleranceWhenValidatingCases;
         QString mCaseEditorFontName;
         int mCaseEditorFontSize;
         bool mCaseEditorFontOnlyMonospaced;
 
+        //Compile cache
+        bool mEnableCompileCache;
+        int mCompileCacheMaxSize; // in MB
+        bool mAutoPrecompileHeaders;
+
     protected:
         void doSave() override;
         void doLoad() override;
@@ -1194,6 +1243,15 @@ public:
         //load hard defines
         void setDefines();
 
+        //run the compiler to find its default directories and hard defines
+        void probe();
+        //the compilers probed, used as the key of cached probe results
+        QString probeKey() const;
+        //size and modification time of the compilers probed
+        QString probeStamp() const;
+        QJsonObject probeResult() const;
+        void setProbeResult(const QJsonObject& result);
+
         bool staticLink() const;
         void setStaticLink(bool newStaticLink);
 
@@ -1294,6 +1352,11 @@ public:
         QString loadPath(const QString& name);
         void loadPathList(const QString& name, QStringList& list);
         PCompilerSet loadSet(int index);
+        //probe results of compiler sets are cached, to avoid running compilers at startup
+        QJsonObject loadProbeCache();
+        void saveProbeCache(const QJsonObject& cache);
+        void probeSets(const QList<PCompilerSet>& sets);
+        void refreshProbesInBackground(const QList<PCompilerSet>& sets);
         CompilerSetList mList;
         int mDefaultIndex;
         Settings* mSettings;
@@ -34,7 +34,7 @@ EditorAutoSaveWidget::~EditorAutoSaveWidget()
 
 void EditorAutoSaveWidget::onAutoSaveStrategyChanged()
 {
-    if (ui->rbOverwrite->isChecked()) {
+    if (ui->rbOverwrite->isChecked() || ui->rbRecoveryJournal->isChecked()) {
         ui->lblFilename->setText(tr("Demo file name: ") + "main.cpp");
     } else if (ui->rbAppendUNIXTimestamp->isChecked()) {
         ui->lblFilename->setText(tr("Demo file name: ") +
@@ -69,6 +69,9 @@ void EditorAutoSaveWidget::doLoad()
     case assAppendUnixTimestamp:
         ui->rbAppendUNIXTimestamp->setChecked(true);
         break;
+    case assRecoveryJournal:
+        ui->rbRecoveryJournal->setChecked(true);
+        break;
     default:
         ui->rbAppendFormattedTimestamp->setChecked(true);
     }
@@ -88,6 +91,8 @@ void EditorAutoSaveWidget::doSave()
         pSettings->editor().setAutoSaveStrategy(assOverwrite);
     else if (ui->rbAppendUNIXTimestamp->isChecked())
         pSettings->editor().setAutoSaveStrategy(assAppendUnixTimestamp);
+    else if (ui->rbRecoveryJournal->isChecked())
+        pSettings->editor().setAutoSaveStrategy(assRecoveryJournal);
     else
         pSettings->editor().setAutoSaveStrategy(assAppendFormatedTimeStamp);
     pSettings->editor().save();
@@ -111,3 +116,7 @@ void EditorAutoSaveWidget::on_rbAppendFormattedTimestamp_toggled(bool)
     onAutoSaveStrategyChanged();
 }
 
+void EditorAutoSaveWidget::on_rbRecoveryJournal_toggled(bool)
+{
+    onAutoSaveStrategyChanged();
+}
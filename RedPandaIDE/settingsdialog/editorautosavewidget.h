@@ -45,6 +45,7 @@ private slots:
     void on_rbOverwrite_toggled(bool checked);
     void on_rbAppendUNIXTimestamp_toggled(bool checked);
     void on_rbAppendFormattedTimestamp_toggled(bool checked);
+    void on_rbRecoveryJournal_toggled(bool checked);
 };
 
 #endif // EDITORAUTOSAVEWIDGET_H
@@ -24,6 +24,10 @@ EditorMiscWidget::EditorMiscWidget(const QString& name, const QString& group,
     ui(new Ui::EditorMiscWidget)
 {
     ui->setupUi(this);
+    connect(ui->chkLargeFileMode, &QCheckBox::toggled,
+            ui->spinLargeFileSize, &QWidget::setEnabled);
+    connect(ui->chkPersistentUndo, &QCheckBox::toggled,
+            ui->spinUndoJournalSize, &QWidget::setEnabled);
 }
 
 EditorMiscWidget::~EditorMiscWidget()
@@ -41,6 +45,14 @@ void EditorMiscWidget::doLoad()
         ui->rbCFile->setChecked(true);
     }
     ui->chkUseUTF8ByDefault->setChecked(pSettings->editor().useUTF8ByDefault());
+    ui->chkLargeFileMode->setChecked(pSettings->editor().enableLargeFileMode());
+    ui->spinLargeFileSize->setValue(pSettings->editor().largeFileSize());
+    ui->spinLargeFileSize->setEnabled(ui->chkLargeFileMode->isChecked());
+    ui->spinUndoMemoryUsage->setValue(pSettings->editor().undoMemoryUsage());
+    ui->spinUndoLimit->setValue(pSettings->editor().undoLimit());
+    ui->chkPersistentUndo->setChecked(pSettings->editor().persistentUndo());
+    ui->spinUndoJournalSize->setValue(pSettings->editor().undoJournalSize());
+    ui->spinUndoJournalSize->setEnabled(ui->chkPersistentUndo->isChecked());
 }
 
 void EditorMiscWidget::doSave()
@@ -49,5 +61,11 @@ void EditorMiscWidget::doSave()
     pSettings->editor().setAutoLoadLastFiles(ui->chkLoadLastFiles->isChecked());
     pSettings->editor().setDefaultFileCpp(ui->rbCppFile->isChecked());
     pSettings->editor().setUseUTF8ByDefault(ui->chkUseUTF8ByDefault->isChecked());
+    pSettings->editor().setEnableLargeFileMode(ui->chkLargeFileMode->isChecked());
+    pSettings->editor().setLargeFileSize(ui->spinLargeFileSize->value());
+    pSettings->editor().setUndoMemoryUsage(ui->spinUndoMemoryUsage->value());
+    pSettings->editor().setUndoLimit(ui->spinUndoLimit->value());
+    pSettings->editor().setPersistentUndo(ui->chkPersistentUndo->isChecked());
+    pSettings->editor().setUndoJournalSize(ui->spinUndoJournalSize->value());
     pSettings->editor().save();
 }
@@ -19,6 +19,7 @@
 #include "../settings.h"
 #include "../iconsmanager.h"
 #include "../systemconsts.h"
+#include "../compiler/compilecache.h"
 
 #include <QFileDialog>
 
@@ -38,20 +39,27 @@ void ExecutorGeneralWidget::doLoad()
 {
     ui->chkPauseConsole->setChecked(pSettings->executor().pauseConsole());
     ui->chkMinimizeOnRun->setChecked(pSettings->executor().minimizeOnRun());
+    ui->chkAutoPrecompileHeaders->setChecked(pSettings->executor().autoPrecompileHeaders());
     ui->grpExecuteParameters->setChecked(pSettings->executor().useParams());
     ui->txtExecuteParamaters->setText(pSettings->executor().params());
     ui->grpRedirectInput->setChecked(pSettings->executor().redirectInput());
     ui->txtRedirectInputFile->setText(pSettings->executor().inputFilename());
+    ui->grpCompileCache->setChecked(pSettings->executor().enableCompileCache());
+    ui->spinCompileCacheMaxSize->setValue(pSettings->executor().compileCacheMaxSize());
+    updateCompileCacheStatistics();
 }
 
 void ExecutorGeneralWidget::doSave()
 {
     pSettings->executor().setPauseConsole(ui->chkPauseConsole->isChecked());
     pSettings->executor().setMinimizeOnRun(ui->chkMinimizeOnRun->isChecked());
+    pSettings->executor().setAutoPrecompileHeaders(ui->chkAutoPrecompileHeaders->isChecked());
     pSettings->executor().setUseParams(ui->grpExecuteParameters->isChecked());
     pSettings->executor().setParams(ui->txtExecuteParamaters->text());
     pSettings->executor().setRedirectInput(ui->grpRedirectInput->isChecked());
     pSettings->executor().setInputFilename(ui->txtRedirectInputFile->text());
+    pSettings->executor().setEnableCompileCache(ui->grpCompileCache->isChecked());
+    pSettings->executor().setCompileCacheMaxSize(ui->spinCompileCacheMaxSize->value());
 
     pSettings->executor().save();
 }
@@ -68,6 +76,22 @@ void ExecutorGeneralWidget::on_btnBrowse_clicked()
     }
 }
 
+void ExecutorGeneralWidget::on_btnClearCompileCache_clicked()
+{
+    pCompileCache->clear();
+    updateCompileCacheStatistics();
+}
+
+void ExecutorGeneralWidget::updateCompileCacheStatistics()
+{
+    QLocale locale = QLocale::system();
+    ui->lblCompileCacheStatistics->setText(
+                tr("Cached size: %1, hits: %2, misses: %3")
+                .arg(locale.formattedDataSize(pCompileCache->totalSize()))
+                .arg(pCompileCache->hits())
+                .arg(pCompileCache->misses()));
+}
+
 void ExecutorGeneralWidget::updateIcons(const QSize &size)
 {
     pIconsManager->setIcon(ui->btnBrowse,IconsManager::ACTION_FILE_OPEN_FOLDER);
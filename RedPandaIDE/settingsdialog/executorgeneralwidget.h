@@ -41,6 +41,9 @@ protected:
     void doSave() override;
 private slots:
     void on_btnBrowse_clicked();
+    void on_btnClearCompileCache_clicked();
+private:
+    void updateCompileCacheStatistics();
 
     // SettingsWidget interface
 protected:
@@ -37,6 +37,9 @@ void ExecutorProblemSetWidget::doLoad()
     ui->grpCompetitiveCompanion->setChecked(pSettings->executor().enableCompetitiveCompanion());
     ui->spinPortNumber->setValue(pSettings->executor().competivieCompanionPort());
     ui->chkIgnoreSpacesWhenValidatingCases->setChecked(pSettings->executor().ignoreSpacesWhenValidatingCases());
+    ui->chkFloatTolerance->setChecked(pSettings->executor().enableFloatToleranceWhenValidatingCases());
+    ui->spinFloatTolerance->setValue(pSettings->executor().floatToleranceWhenValidatingCases());
+    ui->widgetFloatTolerance->setEnabled(ui->chkIgnoreSpacesWhenValidatingCases->isChecked());
 
     ui->cbFont->setCurrentFont(QFont(pSettings->executor().caseEditorFontName()));
     ui->spinFontSize->setValue(pSettings->executor().caseEditorFontSize());
@@ -49,6 +52,8 @@ void ExecutorProblemSetWidget::doSave()
     pSettings->executor().setEnableCompetitiveCompanion(ui->grpCompetitiveCompanion->isChecked());
     pSettings->executor().setCompetivieCompanionPort(ui->spinPortNumber->value());
     pSettings->executor().setIgnoreSpacesWhenValidatingCases(ui->chkIgnoreSpacesWhenValidatingCases->isChecked());
+    pSettings->executor().setEnableFloatToleranceWhenValidatingCases(ui->chkFloatTolerance->isChecked());
+    pSettings->executor().setFloatToleranceWhenValidatingCases(ui->spinFloatTolerance->value());
     pSettings->executor().setCaseEditorFontName(ui->cbFont->currentFont().family());
     pSettings->executor().setCaseEditorFontOnlyMonospaced(ui->chkOnlyMonospaced->isChecked());
     pSettings->executor().setCaseEditorFontSize(ui->spinFontSize->value());
@@ -65,3 +70,10 @@ void ExecutorProblemSetWidget::on_chkOnlyMonospaced_stateChanged(int )
     }
 }
 
+
+void ExecutorProblemSetWidget::on_chkIgnoreSpacesWhenValidatingCases_toggled(bool checked)
+{
+    //floating point numbers are compared as tokens
+    ui->widgetFloatTolerance->setEnabled(checked);
+}
+
@@ -45,6 +45,7 @@ void ProjectMakefileWidget::doLoad()
     ui->grpCustomMakefile->setChecked(pMainWindow->project()->options().useCustomMakefile);
     ui->txtCustomMakefile->setText(pMainWindow->project()->options().customMakefile);
     mIncludesDirWidget->setDirList(pMainWindow->project()->options().makeIncludes);
+    ui->spinMakeJobs->setValue(pMainWindow->project()->options().makeJobs);
 }
 
 void ProjectMakefileWidget::doSave()
@@ -52,6 +53,7 @@ void ProjectMakefileWidget::doSave()
     pMainWindow->project()->options().useCustomMakefile = ui->grpCustomMakefile->isChecked();
     pMainWindow->project()->options().customMakefile = ui->txtCustomMakefile->text();
     pMainWindow->project()->options().makeIncludes = mIncludesDirWidget->dirList();
+    pMainWindow->project()->options().makeJobs = ui->spinMakeJobs->value();
     pMainWindow->project()->saveOptions();
 
 }
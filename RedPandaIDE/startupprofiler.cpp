@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "startupprofiler.h"
+#include "editor.h"
+#include <QApplication>
+#include <QEvent>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// finish profiling even if the main window is never painted, e.g. when it's minimized
+#define STARTUP_PROFILE_TIMEOUT 30000
+
+StartupProfiler* pStartupProfiler = nullptr;
+
+StartupProfiler::StartupProfiler(QObject *parent) : QObject(parent),
+    mPhaseStartWallTime(0),
+    mPhaseStartCpuTime(0),
+    mTotalWallTime(0),
+    mTotalCpuTime(0),
+    mFinished(false),
+    mTimedOut(false),
+    mMainWindow(nullptr)
+{
+    mTimer.start();
+}
+
+void StartupProfiler::startPhase(const QString &name)
+{
+    if (mFinished)
+        return;
+    endPhase();
+    mCurrentPhase = name;
+    mPhaseStartWallTime = mTimer.elapsed();
+    mPhaseStartCpuTime = processCpuTime();
+}
+
+void StartupProfiler::watchFirstPaint(QWidget* mainWindow)
+{
+    if (mFinished)
+        return;
+    mMainWindow = mainWindow;
+    startPhase("Event loop until first paint");
+    QApplication::instance()->installEventFilter(this);
+    QTimer::singleShot(STARTUP_PROFILE_TIMEOUT, this, [this](){
+        if (mFinished)
+            return;
+        mTimedOut = true;
+        finish();
+    });
+}
+
+bool StartupProfiler::finished() const
+{
+    return mFinished;
+}
+
+QString StartupProfiler::report() const
+{
+    if (!mFinished)
+        return tr("Startup profiling is not finished.");
+    QString result;
+    QTextStream stream(&result);
+    int nameWidth = 20;
+    foreach (const StartupPhase& phase, mPhases) {
+        nameWidth = std::max(nameWidth, phase.name.length());
+    }
+    foreach (const StartupPhase& phase, mDeferredInitializations) {
+        nameWidth = std::max(nameWidth, phase.name.length());
+    }
+    // the report is compared between runs and versions, so it's not translated
+    QString total = mTimedOut?"Total (timed out before first paint)":"Total (to first paint)";
+    nameWidth = std::max(nameWidth, total.length());
+    stream<<QString("%1 %2 %3").arg("Phase",-nameWidth).arg("Wall (ms)",10).arg("CPU (ms)",10)<<"\n";
+    foreach (const StartupPhase& phase, mPhases) {
+        stream<<QString("%1 %2 %3").arg(phase.name,-nameWidth).arg(phase.wallTime,10).arg(phase.cpuTime,10)<<"\n";
+    }
+    stream<<QString("%1 %2 %3").arg(total,-nameWidth).arg(mTotalWallTime,10).arg(mTotalCpuTime,10)<<"\n";
+    if (!mDeferredInitializations.isEmpty()) {
+        stream<<"\n"<<"Deferred until first use:"<<"\n";
+        foreach (const StartupPhase& phase, mDeferredInitializations) {
+            stream<<QString("%1 %2").arg(phase.name,-nameWidth).arg(phase.wallTime,10)<<"\n";
+        }
+    }
+    return result;
+}
+
+void StartupProfiler::addDeferredInitialization(const QString &name, qint64 wallTime)
+{
+    StartupPhase phase;
+    phase.name = name;
+    phase.wallTime = wallTime;
+    phase.cpuTime = 0;
+    mDeferredInitializations.append(phase);
+    //most subsystems are first used after the report is written
+    if (mFinished)
+        writeLog();
+}
+
+const QVector<StartupPhase> &StartupProfiler::phases() const
+{
+    return mPhases;
+}
+
+void StartupProfiler::endPhase()
+{
+    if (mCurrentPhase.isEmpty())
+        return;
+    StartupPhase phase;
+    phase.name = mCurrentPhase;
+    phase.wallTime = mTimer.elapsed() - mPhaseStartWallTime;
+    phase.cpuTime = processCpuTime() - mPhaseStartCpuTime;
+    mPhases.append(phase);
+    mCurrentPhase.clear();
+}
+
+void StartupProfiler::finish()
+{
+    QApplication::instance()->removeEventFilter(this);
+    endPhase();
+    mTotalWallTime = mTimer.elapsed();
+    mTotalCpuTime = processCpuTime();
+    mFinished = true;
+    writeLog();
+    emit profileFinished();
+}
+
+void StartupProfiler::writeLog()
+{
+    if (mLogFilename.isEmpty())
+        return;
+    QFile file(mLogFilename);
+    if (file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        file.write(report().toUtf8());
+    }
+}
+
+qint64 StartupProfiler::processCpuTime()
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0;
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    // in 100-nanosecond ticks
+    return (kernel.QuadPart + user.QuadPart) / 10000;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)!=0)
+        return 0;
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)*1000
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000;
+#endif
+}
+
+const QString &StartupProfiler::logFilename() const
+{
+    return mLogFilename;
+}
+
+void StartupProfiler::setLogFilename(const QString &newLogFilename)
+{
+    mLogFilename = newLogFilename;
+}
+
+bool StartupProfiler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && !mFinished) {
+        // editors are painted through their viewports
+        QObject* obj = watched;
+        if (obj->parent() && !obj->inherits("Editor"))
+            obj = obj->parent();
+        // the main window is painted first if no editor is shown
+        if (qobject_cast<Editor*>(obj) || (mMainWindow && watched == mMainWindow)) {
+            // every event would go through the filter until then
+            QApplication::instance()->removeEventFilter(this);
+            // finish after the whole window is painted
+            QMetaObject::invokeMethod(this, [this](){
+                if (!mFinished)
+                    finish();
+            }, Qt::QueuedConnection);
+        }
+    }
+    return false;
+}
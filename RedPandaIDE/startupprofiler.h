@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVector>
+
+class QWidget;
+
+struct StartupPhase {
+    QString name;
+    qint64 wallTime; // in ms
+    qint64 cpuTime; // in ms
+};
+
+/**
+ * Records the wall and cpu time of the named phases of startup, from the
+ * entry of main() to the first paint of an editor or the main window.
+ * Phase names are used as keys in the report, so they are not translated.
+ *
+ * Phases are sequential: starting a phase ends the previous one.
+ * The report is written to the startup log in the config folder.
+ */
+class StartupProfiler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StartupProfiler(QObject *parent = nullptr);
+    void startPhase(const QString& name);
+    //wait for the first paint of an editor or the main window to finish profiling
+    void watchFirstPaint(QWidget* mainWindow);
+    //record a subsystem which was taken out of startup and initialized on first use
+    void addDeferredInitialization(const QString& name, qint64 wallTime);
+    bool finished() const;
+    QString report() const;
+    const QVector<StartupPhase> &phases() const;
+
+    const QString &logFilename() const;
+    void setLogFilename(const QString &newLogFilename);
+
+signals:
+    void profileFinished();
+private:
+    void endPhase();
+    void finish();
+    void writeLog();
+    static qint64 processCpuTime();
+
+    // QObject interface
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+private:
+    QElapsedTimer mTimer;
+    QVector<StartupPhase> mPhases;
+    QVector<StartupPhase> mDeferredInitializations;
+    QString mCurrentPhase;
+    qint64 mPhaseStartWallTime;
+    qint64 mPhaseStartCpuTime;
+    qint64 mTotalWallTime;
+    qint64 mTotalCpuTime;
+    bool mFinished;
+    bool mTimedOut;
+    QWidget* mMainWindow;
+    QString mLogFilename;
+};
+
+extern StartupProfiler* pStartupProfiler;
+
+#endif // STARTUPPROFILER_H
@@ -51,6 +51,7 @@
 #define RES_EXT "res"
 #define H_EXT "h"
 #define OBJ_EXT "o"
+#define DEP_EXT "d"
 #define DEF_EXT "def"
 #define LIB_EXT "a"
 #define GCH_EXT "gch"
@@ -67,6 +68,14 @@
 #define DEV_BOOKMARK_FILE "bookmarks.json"
 #define DEV_BREAKPOINTS_FILE "breakpoints.json"
 #define DEV_WATCH_FILE "watch.json"
+#define DEV_COMPILE_CACHE_DIR "compilecache"
+#define DEV_COMPILE_CACHE_INDEX_FILE "index.json"
+#define DEV_PRECOMPILED_HEADERS_DIR "pch"
+#define DEV_COMPILER_SET_PROBES_FILE "compilersetprobes.json"
+#define DEV_STARTUP_PROFILE_FILE "startuptime.log"
+#define AUTO_SAVE_IDLE_SECONDS 30
+#define UNDO_JOURNAL_MAX_AGE_DAYS 90
+#define UNDO_JOURNAL_MIN_TOTAL_SIZE (64*1024*1024)
 
 #ifdef Q_OS_WIN
 #   define PATH_SENSITIVITY Qt::CaseInsensitive
@@ -20,81 +20,364 @@
 #include "editorlist.h"
 #include "HighlighterManager.h"
 #include "qsynedit/Constants.h"
+#include "utils.h"
+#include <QRunnable>
+
+namespace {
+
+PTodoItem createTodoItem(const QString& filename, int lineNo, int ch, const QString& line)
+{
+    PTodoItem item = std::make_shared<TodoItem>();
+    item->filename = filename;
+    item->lineNo = lineNo;
+    item->ch = ch;
+    item->line = line.trimmed();
+    return item;
+}
+
+enum class CommentLexerState {
+    Normal,
+    BlockComment,
+    LineComment, // line comment continued by a trailing backslash
+    String, // string continued by a trailing backslash
+    RawString
+};
+
+//find the TODO in the comment text [start,end) of the line
+int findTodo(const QString& line, int start, int end)
+{
+    int pos = line.indexOf("TODO:",start,Qt::CaseInsensitive);
+    if (pos<0 || pos+5>end)
+        return -1;
+    return pos;
+}
+
+/*
+ * A lexer which only knows about comments, strings and character literals.
+ * It's much cheaper than the highlighter, and good enough to find TODOs
+ * in files which are not opened.
+ */
+QList<PTodoItem> scanTodosInLines(const QString& filename, const QStringList& lines)
+{
+    QList<PTodoItem> result;
+    CommentLexerState state = CommentLexerState::Normal;
+    QString rawStringEnd;
+    for (int lineIdx=0;lineIdx<lines.count();lineIdx++) {
+        QString line = lines[lineIdx];
+        int len = line.length();
+        while (len>0 && (line[len-1]=='\n' || line[len-1]=='\r'))
+            len--;
+        bool continued = (len>0 && line[len-1]=='\\');
+        int todoPos = -1;
+        int i=0;
+        switch(state) {
+        case CommentLexerState::LineComment:
+            todoPos = findTodo(line,0,len);
+            i = len;
+            if (!continued)
+                state = CommentLexerState::Normal;
+            break;
+        case CommentLexerState::BlockComment: {
+            int end = line.indexOf("*/");
+            if (end<0 || end>=len) {
+                todoPos = findTodo(line,0,len);
+                i = len;
+            } else {
+                todoPos = findTodo(line,0,end);
+                i = end+2;
+                state = CommentLexerState::Normal;
+            }
+        }
+            break;
+        case CommentLexerState::RawString: {
+            int end = line.indexOf(rawStringEnd);
+            if (end<0) {
+                i = len;
+            } else {
+                i = end+rawStringEnd.length();
+                state = CommentLexerState::Normal;
+            }
+        }
+            break;
+        default:
+            break;
+        }
+        while (i<len) {
+            QChar ch = line[i];
+            if (state == CommentLexerState::String) {
+                if (ch=='\\') {
+                    i+=2;
+                    continue;
+                }
+                if (ch=='"')
+                    state = CommentLexerState::Normal;
+                i++;
+                continue;
+            }
+            if (ch=='/' && i+1<len && line[i+1]=='/') {
+                if (todoPos<0)
+                    todoPos = findTodo(line,i+2,len);
+                if (continued)
+                    state = CommentLexerState::LineComment;
+                i = len;
+            } else if (ch=='/' && i+1<len && line[i+1]=='*') {
+                int end = line.indexOf("*/",i+2);
+                if (end<0 || end>=len) {
+                    if (todoPos<0)
+                        todoPos = findTodo(line,i+2,len);
+                    state = CommentLexerState::BlockComment;
+                    i = len;
+                } else {
+                    if (todoPos<0)
+                        todoPos = findTodo(line,i+2,end);
+                    i = end+2;
+                }
+            } else if (ch=='"') {
+                // R"delim( ... )delim"
+                int prefixStart = i;
+                while (prefixStart>0 && (line[prefixStart-1].isLetterOrNumber()
+                                         || line[prefixStart-1]=='_'))
+                    prefixStart--;
+                QString prefix = line.mid(prefixStart,i-prefixStart);
+                if (prefix=="R" || prefix=="u8R" || prefix=="uR"
+                        || prefix=="UR" || prefix=="LR") {
+                    int paren = line.indexOf('(',i+1);
+                    if (paren>=0 && paren<len) {
+                        rawStringEnd = ")"+line.mid(i+1,paren-i-1)+"\"";
+                        int end = line.indexOf(rawStringEnd,paren+1);
+                        if (end<0) {
+                            state = CommentLexerState::RawString;
+                            i = len;
+                        } else {
+                            i = end+rawStringEnd.length();
+                        }
+                        continue;
+                    }
+                }
+                state = CommentLexerState::String;
+                i++;
+            } else if (ch=='\'') {
+                // digit separator: 1'000'000, 0xFF'FF
+                int tokenStart = i;
+                while (tokenStart>0 && (line[tokenStart-1].isLetterOrNumber()
+                                        || line[tokenStart-1]=='\''))
+                    tokenStart--;
+                if (tokenStart<i && line[tokenStart].isDigit()) {
+                    i++;
+                    continue;
+                }
+                i++;
+                while (i<len && line[i]!='\'') {
+                    if (line[i]=='\\')
+                        i++;
+                    i++;
+                }
+                i++;
+            } else {
+                i++;
+            }
+        }
+        // unterminated strings end at the end of line, unless continued
+        if (state == CommentLexerState::String && !continued)
+            state = CommentLexerState::Normal;
+        if (todoPos>=0)
+            result.append(createTodoItem(filename,lineIdx+1,todoPos,line));
+    }
+    return result;
+}
+
+class TodoFileScanTask: public QRunnable {
+public:
+    TodoFileScanTask(TodoParser* parser, int generation, const QString& filename):
+        mParser(parser),
+        mGeneration(generation),
+        mFilename(filename) {
+    }
+
+    // QRunnable interface
+public:
+    void run() override {
+        QList<PTodoItem> items = TodoParser::scanFile(mFilename);
+        TodoParser* parser = mParser;
+        int generation = mGeneration;
+        QString filename = mFilename;
+        QMetaObject::invokeMethod(parser, [parser, generation, filename, items](){
+            parser->onFileScanned(generation, filename, items);
+        }, Qt::QueuedConnection);
+    }
+private:
+    TodoParser* mParser;
+    int mGeneration;
+    QString mFilename;
+};
+
+}
 
 TodoParser::TodoParser(QObject *parent) : QObject(parent),
-    mMutex(QMutex::Recursive)
+    mGeneration(0),
+    mPendingFiles(0)
+{
+}
+
+TodoParser::~TodoParser()
 {
-    mThread = nullptr;
+    mThreadPool.clear();
+    mThreadPool.waitForDone();
 }
 
-void TodoParser::parseFile(const QString &filename)
+void TodoParser::parseEditor(Editor *editor)
 {
-    QMutexLocker locker(&mMutex);
-    if (mThread) {
+    if (!editor->highlighter())
         return;
-    }
-    mThread = new TodoThread(filename);
-    connect(mThread,&QThread::finished,
-            [this] {
-        QMutexLocker locker(&mMutex);
-        if (mThread) {
-            mThread->deleteLater();
-            mThread = nullptr;
+    emit todosUpdated(editor->filename(),
+                      editor->todoLineCache()->scan(editor->filename(),editor->highlighter()));
+}
+
+void TodoParser::parseFiles(const QStringList &filenames)
+{
+    foreach (const QString& filename, filenames) {
+        switch(getFileType(filename)) {
+        case FileType::CSource:
+        case FileType::CppSource:
+        case FileType::CHeader:
+        case FileType::CppHeader:
+            break;
+        default:
+            continue;
         }
-    });
-    connect(mThread, &TodoThread::parseStarted,
-            pMainWindow, &MainWindow::onTodoParseStarted);
-    connect(mThread, &TodoThread::todoFound,
-            pMainWindow, &MainWindow::onTodoParsing);
-    connect(mThread, &TodoThread::parseFinished,
-            pMainWindow, &MainWindow::onTodoParseFinished);
-    mThread->start();
+        mPendingFiles++;
+        mThreadPool.start(new TodoFileScanTask(this, mGeneration, filename));
+    }
+}
+
+void TodoParser::removeFile(const QString &filename)
+{
+    emit todosRemoved(filename);
+}
+
+void TodoParser::clear()
+{
+    mGeneration++;
+    mThreadPool.clear();
+    mPendingFiles = 0;
 }
 
 bool TodoParser::parsing() const
 {
-    return (mThread!=nullptr);
+    return mPendingFiles>0;
 }
 
-TodoThread::TodoThread(const QString& filename, QObject *parent): QThread(parent)
+QList<PTodoItem> TodoParser::scanFile(const QString &filename)
 {
-    mFilename = filename;
+    return scanTodosInLines(filename, readFileToLines(filename));
 }
 
-void TodoThread::run()
+void TodoParser::onFileScanned(int generation, const QString &filename, const QList<PTodoItem> &items)
 {
-    PSynHighlighter highlighter = highlighterManager.getCppHighlighter();
-    emit parseStarted(mFilename);
-    auto action = finally([this]{
-        emit parseFinished();
-    });
-    QStringList lines;
-    if (!pMainWindow->editorList()->getContentFromOpenedEditor(mFilename,lines)) {
+    if (generation != mGeneration)
         return;
+    mPendingFiles--;
+    //the opened editor has the newest content
+    if (!pMainWindow->editorList()->getOpenedEditorByFilename(filename))
+        emit todosUpdated(filename, items);
+    if (mPendingFiles==0)
+        emit parseFinished();
+}
+
+TodoLineCache::TodoLineCache(PSynEditStringList lines, QObject *parent):
+    QObject(parent),
+    mLines(lines)
+{
+    connect(mLines.get(), &SynEditStringList::cleared,
+            this, &TodoLineCache::onLinesCleared);
+    connect(mLines.get(), &SynEditStringList::deleted,
+            this, &TodoLineCache::onLinesDeleted);
+    connect(mLines.get(), &SynEditStringList::inserted,
+            this, &TodoLineCache::onLinesInserted);
+    connect(mLines.get(), &SynEditStringList::putted,
+            this, &TodoLineCache::onLinesPutted);
+}
+
+QList<PTodoItem> TodoLineCache::scan(const QString &filename, PSynHighlighter highlighter)
+{
+    if (!mHighlighter || mHighlighter->getName()!=highlighter->getName()) {
+        //range states saved by another highlighter can't be reused
+        mHighlighter = highlighterManager.copyHighlighter(highlighter);
+        mCommentAttr = mHighlighter->getAttribute(SYNS_AttrComment);
+        mEntries.clear();
     }
-    PSynHighlighterAttribute commentAttr = highlighter->getAttribute(SYNS_AttrComment);
-
-    highlighter->resetState();
-    for (int i =0;i<lines.count();i++) {
-        highlighter->setLine(lines[i],i);
-        while (!highlighter->eol()) {
-            PSynHighlighterAttribute attr;
-            attr = highlighter->getTokenAttribute();
-            if (attr == commentAttr) {
-                QString token = highlighter->getToken();
-                int pos = token.indexOf("TODO:",0,Qt::CaseInsensitive);
-                if (pos>=0) {
-                    emit todoFound(
-                                mFilename,
-                                i+1,
-                                pos+highlighter->getTokenPos(),
-                                lines[i].trimmed()
-                                );
+    int count = mLines->count();
+    if (mEntries.count()!=count) {
+        mEntries.clear();
+        mEntries.resize(count);
+        for (int i=0;i<count;i++)
+            mEntries[i].dirty = true;
+    }
+    QList<PTodoItem> result;
+    for (int i=0;i<count;i++) {
+        LineEntry& entry = mEntries[i];
+        SynRangeState startState;
+        int state = -1;
+        if (i>0) {
+            startState = mLines->ranges(i-1);
+            state = startState.state;
+        }
+        if (entry.dirty || entry.startState!=state) {
+            if (i==0)
+                mHighlighter->resetState();
+            else
+                mHighlighter->setState(startState);
+            mHighlighter->setLine(mLines->getString(i),i);
+            entry.todoColumns.clear();
+            while (!mHighlighter->eol()) {
+                if (mHighlighter->getTokenAttribute() == mCommentAttr) {
+                    int pos = mHighlighter->getToken().indexOf("TODO:",0,Qt::CaseInsensitive);
+                    if (pos>=0)
+                        entry.todoColumns.append(pos+mHighlighter->getTokenPos());
                 }
+                mHighlighter->next();
             }
-            highlighter->next();
+            entry.dirty = false;
+            entry.startState = state;
+        }
+        foreach (int ch, entry.todoColumns) {
+            result.append(createTodoItem(filename,i+1,ch,mLines->getString(i)));
         }
     }
+    return result;
+}
+
+void TodoLineCache::onLinesCleared()
+{
+    mEntries.clear();
+}
+
+void TodoLineCache::onLinesDeleted(int index, int count)
+{
+    if (index<0 || index+count>mEntries.count()) {
+        mEntries.clear();
+        return;
+    }
+    mEntries.remove(index,count);
+}
+
+void TodoLineCache::onLinesInserted(int index, int count)
+{
+    if (index<0 || index>mEntries.count()) {
+        mEntries.clear();
+        return;
+    }
+    LineEntry entry;
+    entry.dirty = true;
+    entry.startState = -1;
+    mEntries.insert(index,count,entry);
+}
+
+void TodoLineCache::onLinesPutted(int index, int count)
+{
+    for (int i=index;i<index+count && i<mEntries.count();i++) {
+        mEntries[i].dirty = true;
+    }
 }
 
 TodoModel::TodoModel(QObject *parent) : QAbstractListModel(parent)
@@ -102,18 +385,54 @@ TodoModel::TodoModel(QObject *parent) : QAbstractListModel(parent)
 
 }
 
-void TodoModel::addItem(const QString &filename, int lineNo, int ch, const QString &line)
+void TodoModel::setItems(const QString &filename, const QList<PTodoItem> &items)
 {
-    beginInsertRows(QModelIndex(),mItems.count(),mItems.count());
-    PTodoItem item = std::make_shared<TodoItem>();
-    item->filename = filename;
-    item->lineNo = lineNo;
-    item->ch = ch;
-    item->line = line;
-    mItems.append(item);
+    int first = -1;
+    int last = -1;
+    for (int i=0;i<mItems.count();i++) {
+        if (mItems[i]->filename == filename) {
+            if (first<0)
+                first = i;
+            last = i;
+        } else if (first>=0)
+            break;
+    }
+    if (first>=0 && last-first+1 == items.count()) {
+        bool same = true;
+        for (int i=0;i<items.count();i++) {
+            const PTodoItem& oldItem = mItems[first+i];
+            const PTodoItem& newItem = items[i];
+            if (oldItem->lineNo != newItem->lineNo
+                    || oldItem->ch != newItem->ch
+                    || oldItem->line != newItem->line) {
+                same = false;
+                break;
+            }
+        }
+        if (same)
+            return;
+    }
+    if (first>=0) {
+        beginRemoveRows(QModelIndex(),first,last);
+        mItems.erase(mItems.begin()+first, mItems.begin()+last+1);
+        endRemoveRows();
+    } else {
+        first = mItems.count();
+    }
+    if (items.isEmpty())
+        return;
+    beginInsertRows(QModelIndex(),first,first+items.count()-1);
+    for (int i=0;i<items.count();i++) {
+        mItems.insert(first+i,items[i]);
+    }
     endInsertRows();
 }
 
+void TodoModel::removeItems(const QString &filename)
+{
+    setItems(filename, QList<PTodoItem>());
+}
+
 void TodoModel::clear()
 {
     beginResetModel();
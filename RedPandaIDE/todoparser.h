@@ -18,9 +18,10 @@
 #define TODOPARSER_H
 
 #include <QObject>
-#include <QThread>
-#include <QMutex>
+#include <QThreadPool>
 #include <QAbstractListModel>
+#include "qsynedit/TextBuffer.h"
+#include "qsynedit/highlighter/base.h"
 
 struct TodoItem {
     QString filename;
@@ -35,11 +36,13 @@ class TodoModel : public QAbstractListModel {
     Q_OBJECT
 public:
     explicit TodoModel(QObject* parent=nullptr);
-    void addItem(const QString& filename, int lineNo,
-                 int ch, const QString& line);
+    //replace all the items of the file
+    void setItems(const QString& filename, const QList<PTodoItem>& items);
+    void removeItems(const QString& filename);
     void clear();
     PTodoItem getItem(const QModelIndex& index);
 private:
+    //items of the same file are kept together
     QList<PTodoItem> mItems;
 
     // QAbstractItemModel interface
@@ -53,36 +56,68 @@ public:
     int columnCount(const QModelIndex &parent) const override;
 };
 
-class TodoThread: public QThread
+/**
+ * Remembers the TODOs found in each line of an editor, so that a rescan only
+ * tokenizes the lines changed since the last scan.
+ *
+ * A line is tokenized starting from the range state the editor has saved for
+ * its previous line, so lines whose comment state changed because of an edit
+ * above them are detected and rescanned too.
+ */
+class TodoLineCache : public QObject
 {
     Q_OBJECT
 public:
-    explicit TodoThread(const QString& filename, QObject* parent = nullptr);
-signals:
-    void parseStarted(const QString& filename);
-    void todoFound(const QString& filename, int lineNo, int ch, const QString& line);
-    void parseFinished();
+    explicit TodoLineCache(PSynEditStringList lines, QObject* parent = nullptr);
+    QList<PTodoItem> scan(const QString& filename, PSynHighlighter highlighter);
+private slots:
+    void onLinesCleared();
+    void onLinesDeleted(int index, int count);
+    void onLinesInserted(int index, int count);
+    void onLinesPutted(int index, int count);
 private:
-    QString mFilename;
-
-    // QThread interface
-protected:
-    void run() override;
+    struct LineEntry {
+        bool dirty;
+        int startState; // highlighter state at the start of the line
+        QVector<int> todoColumns;
+    };
+    PSynEditStringList mLines;
+    PSynHighlighter mHighlighter;
+    PSynHighlighterAttribute mCommentAttr;
+    QVector<LineEntry> mEntries;
 };
 
-using PTodoThread = std::shared_ptr<TodoThread>;
+using PTodoLineCache = std::shared_ptr<TodoLineCache>;
+
+class Editor;
 
 class TodoParser : public QObject
 {
     Q_OBJECT
 public:
     explicit TodoParser(QObject *parent = nullptr);
-    void parseFile(const QString& filename);
+    ~TodoParser();
+    //rescan the changed lines of an opened editor
+    void parseEditor(Editor* editor);
+    //scan files which are not opened, in the thread pool
+    void parseFiles(const QStringList& filenames);
+    void removeFile(const QString& filename);
+    //drop the results of all pending scans
+    void clear();
     bool parsing() const;
 
+    static QList<PTodoItem> scanFile(const QString& filename);
+signals:
+    void todosUpdated(const QString& filename, const QList<PTodoItem>& items);
+    void todosRemoved(const QString& filename);
+    void parseFinished();
+public slots:
+    //called in the main thread when a file is scanned in the thread pool
+    void onFileScanned(int generation, const QString& filename, const QList<PTodoItem>& items);
 private:
-    TodoThread* mThread;
-    QMutex mMutex;
+    QThreadPool mThreadPool;
+    int mGeneration;
+    int mPendingFiles;
 };
 
 using PTodoParser = std::shared_ptr<TodoParser>;
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "undojournal.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QtEndian>
+#include <cstring>
+#include "qsynedit/SynEdit.h"
+#include "settings.h"
+#include "systemconsts.h"
+#include "utils.h"
+
+static const char JournalMagic[4] = {'R','P','U','J'};
+static const quint32 JournalVersion = 2;
+//the serialization format of the payloads, kept in the header so a newer Qt reads it back the same way
+static const quint32 JournalStreamVersion = QDataStream::Qt_5_6;
+static const int JournalHeaderSize = 12; // magic + version + stream version
+static const int HashSize = 20; // sha1
+static const int RecordHeaderSize = 4 + HashSize; // payload size + content hash
+// reason, selection mode, start, end, change number and the string's size
+static const int ItemFixedSize = 1 + 1 + 4*4 + 4 + 4;
+
+UndoJournal::UndoJournal(const QString &sourceFilename, qint64 maxSize):
+    mMaxSize(maxSize)
+{
+    QString key = QFileInfo(sourceFilename).absoluteFilePath();
+    if (PATH_SENSITIVITY == Qt::CaseInsensitive)
+        key = key.toLower();
+    QByteArray keyHash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    mFilename = includeTrailingPathDelimiter(
+                pSettings->dirs().config(Settings::Dirs::DataType::UndoJournal))
+            + QString::fromLatin1(keyHash.toHex()) + ".undo";
+}
+
+bool UndoJournal::save(SynEdit *editor)
+{
+    if (editor->modified())
+        return false;
+    const PSynEditUndoList& undoList = editor->undoList();
+    int count = undoList->ItemCount();
+    if (count == 0)
+        return false;
+    //keep the newest items that fit into the journal, without splitting a change
+    qint64 budget = mMaxSize - JournalHeaderSize - RecordHeaderSize - (qint64)sizeof(qint32);
+    int first = count;
+    while (first>0) {
+        qint64 itemSize = ItemFixedSize + undoList->item(first-1)->changeStr().length()*3;
+        if (itemSize > budget)
+            break;
+        budget -= itemSize;
+        first--;
+    }
+    while (first>0 && first<count
+           && undoList->item(first)->changeNumber() == undoList->item(first-1)->changeNumber())
+        first++;
+    if (first>=count)
+        return false;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(JournalStreamVersion);
+    stream<<(qint32)(count-first);
+    for (int i=first;i<count;i++) {
+        PSynEditUndoItem item = undoList->item(i);
+        stream<<(qint8)item->changeReason()
+             <<(qint8)item->changeSelMode()
+            <<(qint32)item->changeStartPos().Char
+           <<(qint32)item->changeStartPos().Line
+          <<(qint32)item->changeEndPos().Char
+         <<(qint32)item->changeEndPos().Line
+        <<(qint32)item->changeNumber()
+        <<item->changeStr().toUtf8();
+    }
+
+    QFile file(mFilename);
+    bool rewrite = true;
+    if (file.open(QFile::ReadOnly)) {
+        QByteArray header = file.read(JournalHeaderSize);
+        //start over instead of growing past the cap
+        rewrite = header.length()<JournalHeaderSize
+                || !isValidHeader(header.constData())
+                || file.size()+RecordHeaderSize+payload.length() > mMaxSize;
+        file.close();
+    }
+    QDir().mkpath(extractFileDir(mFilename));
+    if (!file.open(rewrite ? (QFile::WriteOnly | QFile::Truncate) : (QFile::WriteOnly | QFile::Append)))
+        return false;
+    if (rewrite) {
+        quint32 version = qToLittleEndian(JournalVersion);
+        quint32 streamVersion = qToLittleEndian(JournalStreamVersion);
+        file.write(JournalMagic,sizeof(JournalMagic));
+        file.write(reinterpret_cast<const char*>(&version),sizeof(version));
+        file.write(reinterpret_cast<const char*>(&streamVersion),sizeof(streamVersion));
+    }
+    quint32 payloadSize = qToLittleEndian((quint32)payload.length());
+    file.write(reinterpret_cast<const char*>(&payloadSize),sizeof(payloadSize));
+    file.write(contentHash(editor));
+    return file.write(payload) == payload.length();
+}
+
+bool UndoJournal::restore(SynEdit *editor)
+{
+    QFile file(mFilename);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    qint64 size = file.size();
+    if (size<JournalHeaderSize)
+        return false;
+    //only record headers are visited until the matching record, so map instead of reading it all
+    const char* data = reinterpret_cast<const char*>(file.map(0,size));
+    QByteArray buffer;
+    if (!data) {
+        buffer = file.readAll();
+        data = buffer.constData();
+        size = buffer.size();
+    }
+    if (!isValidHeader(data))
+        return false;
+    QByteArray hash = contentHash(editor);
+    qint64 found = -1;
+    quint32 foundSize = 0;
+    qint64 pos = JournalHeaderSize;
+    while (pos+RecordHeaderSize <= size) {
+        quint32 payloadSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data+pos));
+        //an append that didn't finish
+        if (pos+RecordHeaderSize+payloadSize > size)
+            break;
+        //the latest record wins
+        if (memcmp(data+pos+4,hash.constData(),HashSize)==0) {
+            found = pos+RecordHeaderSize;
+            foundSize = payloadSize;
+        }
+        pos += RecordHeaderSize+payloadSize;
+    }
+    if (found<0)
+        return false;
+
+    QByteArray payload = QByteArray::fromRawData(data+found,foundSize);
+    QDataStream stream(payload);
+    stream.setVersion(qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data+8)));
+    qint32 count;
+    stream>>count;
+    if (count<=0)
+        return false;
+    QVector<PSynEditUndoItem> items;
+    items.reserve(count);
+    for (int i=0;i<count;i++) {
+        qint8 reason,selMode;
+        qint32 startChar,startLine,endChar,endLine,changeNumber;
+        QByteArray str;
+        stream>>reason>>selMode>>startChar>>startLine>>endChar>>endLine>>changeNumber>>str;
+        if (stream.status()!=QDataStream::Ok
+                || reason<0 || reason>(qint8)SynChangeReason::crDeleteAll
+                || selMode<0 || selMode>(qint8)SynSelectionMode::smColumn)
+            return false;
+        items.append(std::make_shared<SynEditUndoItem>(
+                         (SynChangeReason)reason,
+                         (SynSelectionMode)selMode,
+                         BufferCoord{startChar,startLine},
+                         BufferCoord{endChar,endLine},
+                         QString::fromUtf8(str),
+                         changeNumber));
+    }
+    editor->undoList()->restoreItems(items);
+    return true;
+}
+
+void UndoJournal::prune(qint64 maxTotalSize)
+{
+    QDir dir(pSettings->dirs().config(Settings::Dirs::DataType::UndoJournal));
+    if (!dir.exists())
+        return;
+    QDateTime oldest = QDateTime::currentDateTime().addDays(-UNDO_JOURNAL_MAX_AGE_DAYS);
+    qint64 totalSize = 0;
+    //newest first, so the histories of the files edited lately are the ones kept
+    foreach (const QFileInfo& info, dir.entryInfoList(QStringList{"*.undo"}, QDir::Files, QDir::Time)) {
+        totalSize += info.size();
+        if (info.lastModified() < oldest || totalSize > maxTotalSize)
+            QFile::remove(info.absoluteFilePath());
+    }
+}
+
+const QString &UndoJournal::filename() const
+{
+    return mFilename;
+}
+
+QByteArray UndoJournal::contentHash(SynEdit *editor)
+{
+    return QCryptographicHash::hash(editor->lines()->textBytes(), QCryptographicHash::Sha1);
+}
+
+bool UndoJournal::isValidHeader(const char *data)
+{
+    if (memcmp(data,JournalMagic,sizeof(JournalMagic))!=0
+            || qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data+4)) != JournalVersion)
+        return false;
+    //written by a Qt that knows a stream format this one doesn't
+    quint32 streamVersion = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data+8));
+    return streamVersion>0 && streamVersion<=QDataStream::Qt_DefaultCompiledVersion;
+}
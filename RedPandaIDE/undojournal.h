@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef UNDOJOURNAL_H
+#define UNDOJOURNAL_H
+
+#include <QString>
+#include <QByteArray>
+
+class SynEdit;
+
+/**
+ * Keeps the undo history of a source file across close and reopen.
+ *
+ * Every file has its own append-only journal in the config folder. Each record
+ * holds the undo items of an editor and the hash of the text they end at, so
+ * the history is restored only if the reopened text is exactly that text.
+ */
+class UndoJournal
+{
+public:
+    explicit UndoJournal(const QString& sourceFilename, qint64 maxSize);
+    //append the editor's undo history; its text must be the one saved on the disk
+    bool save(SynEdit* editor);
+    //restore the history recorded for the editor's current text
+    bool restore(SynEdit* editor);
+    const QString& filename() const;
+    //remove journals not touched for a long time, then the oldest ones over the size cap
+    static void prune(qint64 maxTotalSize);
+
+private:
+    static QByteArray contentHash(SynEdit* editor);
+    static bool isValidHeader(const char* data);
+private:
+    QString mFilename;
+    qint64 mMaxSize;
+};
+
+#endif // UNDOJOURNAL_H
@@ -1140,3 +1140,31 @@ void copyFolder(const QString &fromDir, const QString &toDir)
         }
     }
 }
+
+qulonglong availablePhysicalMemory()
+{
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status))
+        return status.ullAvailPhys;
+    return 0;
+#elif defined(Q_OS_LINUX)
+    QFile file("/proc/meminfo");
+    if (!file.open(QFile::ReadOnly))
+        return 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (line.startsWith("MemAvailable:")) {
+            // "MemAvailable:   12345678 kB"
+            QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.length()>=2)
+                return fields[1].toULongLong()*1024;
+            break;
+        }
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
@@ -71,7 +71,8 @@ enum AutoSaveTarget {
 enum AutoSaveStrategy {
     assOverwrite,
     assAppendUnixTimestamp,
-    assAppendFormatedTimeStamp
+    assAppendFormatedTimeStamp,
+    assRecoveryJournal
 };
 
 enum FormatterBraceStyle {
@@ -238,6 +239,9 @@ float pixelToPoint(float pixel);
 
 void copyFolder(const QString &fromDir, const QString& toDir);
 
+// physical memory currently available to new processes, in bytes (0 if unknown)
+qulonglong availablePhysicalMemory();
+
 
 /**
  * from https://github.com/Microsoft/GSL
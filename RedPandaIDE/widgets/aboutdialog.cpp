@@ -18,6 +18,8 @@
 #include "ui_aboutdialog.h"
 #include "../systemconsts.h"
 #include "../utils.h"
+#include "../startupprofiler.h"
+#include <QFontDatabase>
 #include <QDebug>
 
 AboutDialog::AboutDialog(QWidget *parent) :
@@ -41,6 +43,8 @@ AboutDialog::AboutDialog(QWidget *parent) :
 #endif
     ui->lblCompileTime->setText(ui->lblCompileTime->text()
                                 .arg(__DATE__, __TIME__));
+    ui->txtStartupTime->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    ui->txtStartupTime->setPlainText(pStartupProfiler->report());
 }
 
 AboutDialog::~AboutDialog()
@@ -83,10 +83,8 @@ void CPUDialog::updateInfo()
         // Load the registers..
         sendSyntaxCommand();
         pMainWindow->debugger()->sendCommand("-data-list-register-values", "N");
-        if (ui->chkBlendMode->isChecked())
-            pMainWindow->debugger()->sendCommand("disas", "/s");
-        else
-            pMainWindow->debugger()->sendCommand("disas", "");
+        pMainWindow->debugger()->requestDisassembly(ui->rdIntel->isChecked(),
+                                                    ui->chkBlendMode->isChecked());
     }
 }
 
@@ -96,18 +94,20 @@ void CPUDialog::updateButtonStates(bool enable)
     ui->btnStepOverInstruction->setEnabled(enable);
 }
 
-void CPUDialog::setDisassembly(const QString& file, const QString& funcName,const QStringList& lines)
+void CPUDialog::setDisassembly(PDisassemblyFunction function, qulonglong address)
 {
-    ui->txtFunctionName->setText(QString("%1:%2").arg(file, funcName));
-    int activeLine = -1;
-    ui->txtCode->lines()->clear();
-    for (int i=0;i<lines.size();i++) {
-        QString line = lines[i];
-        if (line.startsWith("=>")) {
-            activeLine = i;
+    if (!function)
+        return;
+    //only move the active line when stepping in the same function
+    if (function != mDisassembly) {
+        mDisassembly = function;
+        ui->txtFunctionName->setText(QString("%1:%2").arg(function->filename, function->funcName));
+        ui->txtCode->lines()->clear();
+        for (int i=0;i<function->lines.size();i++) {
+            ui->txtCode->lines()->add(function->lines[i]);
         }
-        ui->txtCode->lines()->add(line);
     }
+    int activeLine = function->lineAddresses.indexOf(address);
     if (activeLine!=-1)
         ui->txtCode->setCaretXYEx(true,BufferCoord{1,activeLine+1});
 }
@@ -18,6 +18,7 @@
 #define CPUDIALOG_H
 
 #include <QDialog>
+#include "../debugger.h"
 
 namespace Ui {
 class CPUDialog;
@@ -33,13 +34,14 @@ public:
     void updateInfo();
     void updateButtonStates(bool enable);
 public slots:
-    void setDisassembly(const QString& file, const QString& funcName,const QStringList& lines);
+    void setDisassembly(PDisassemblyFunction function, qulonglong address);
 signals:
     void closed();
 private:
     void sendSyntaxCommand();
 private:
     Ui::CPUDialog *ui;
+    PDisassemblyFunction mDisassembly;
     // QWidget interface
 protected:
     void closeEvent(QCloseEvent *event) override;
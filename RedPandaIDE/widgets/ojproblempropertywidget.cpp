@@ -16,6 +16,8 @@
  */
 #include "ojproblempropertywidget.h"
 #include "ui_ojproblempropertywidget.h"
+#include <QFileDialog>
+#include <QFileInfo>
 
 OJProblemPropertyWidget::OJProblemPropertyWidget(QWidget *parent) :
     QDialog(parent),
@@ -48,6 +50,26 @@ void OJProblemPropertyWidget::setDescription(const QString &description)
     ui->txtDescription->setHtml(description);
 }
 
+void OJProblemPropertyWidget::setTimeLimit(int timeLimit)
+{
+    ui->spinTimeLimit->setValue(timeLimit);
+}
+
+void OJProblemPropertyWidget::setMemoryLimit(int memoryLimit)
+{
+    ui->spinMemoryLimit->setValue(memoryLimit);
+}
+
+void OJProblemPropertyWidget::setGeneratorProgram(const QString &filename)
+{
+    ui->txtGenerator->setText(filename);
+}
+
+void OJProblemPropertyWidget::setBruteForceProgram(const QString &filename)
+{
+    ui->txtBruteForce->setText(filename);
+}
+
 QString OJProblemPropertyWidget::name()
 {
     return ui->lbName->text();
@@ -63,6 +85,26 @@ QString OJProblemPropertyWidget::description()
     return ui->txtDescription->toHtml();
 }
 
+int OJProblemPropertyWidget::timeLimit()
+{
+    return ui->spinTimeLimit->value();
+}
+
+int OJProblemPropertyWidget::memoryLimit()
+{
+    return ui->spinMemoryLimit->value();
+}
+
+QString OJProblemPropertyWidget::generatorProgram()
+{
+    return ui->txtGenerator->text();
+}
+
+QString OJProblemPropertyWidget::bruteForceProgram()
+{
+    return ui->txtBruteForce->text();
+}
+
 void OJProblemPropertyWidget::on_btnOk_clicked()
 {
     this->accept();
@@ -74,3 +116,25 @@ void OJProblemPropertyWidget::on_btnCancel_clicked()
     this->reject();
 }
 
+
+void OJProblemPropertyWidget::on_btnChooseGenerator_clicked()
+{
+    QString filename = QFileDialog::getOpenFileName(
+                this,
+                tr("Choose Generator Source File"),
+                QFileInfo(ui->txtGenerator->text()).absolutePath(),
+                tr("C/C++ Source Files (*.c *.cpp *.cc *.cxx)"));
+    if (!filename.isEmpty())
+        ui->txtGenerator->setText(filename);
+}
+
+void OJProblemPropertyWidget::on_btnChooseBruteForce_clicked()
+{
+    QString filename = QFileDialog::getOpenFileName(
+                this,
+                tr("Choose Brute Force Source File"),
+                QFileInfo(ui->txtBruteForce->text()).absolutePath(),
+                tr("C/C++ Source Files (*.c *.cpp *.cc *.cxx)"));
+    if (!filename.isEmpty())
+        ui->txtBruteForce->setText(filename);
+}
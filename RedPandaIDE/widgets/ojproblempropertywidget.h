@@ -33,15 +33,27 @@ public:
     void setName(const QString& name);
     void setUrl(const QString& url);
     void setDescription(const QString& description);
+    void setTimeLimit(int timeLimit);
+    void setMemoryLimit(int memoryLimit);
+    void setGeneratorProgram(const QString& filename);
+    void setBruteForceProgram(const QString& filename);
     QString name();
     QString url();
     QString description();
+    int timeLimit();
+    int memoryLimit();
+    QString generatorProgram();
+    QString bruteForceProgram();
 
 private slots:
     void on_btnOk_clicked();
 
     void on_btnCancel_clicked();
 
+    void on_btnChooseGenerator_clicked();
+
+    void on_btnChooseBruteForce_clicked();
+
 private:
     Ui::OJProblemPropertyWidget *ui;
 };
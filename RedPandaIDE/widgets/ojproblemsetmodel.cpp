@@ -21,6 +21,7 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QLocale>
 #include "../utils.h"
 #include "../iconsmanager.h"
 #include "../systemconsts.h"
@@ -107,12 +108,24 @@ void OJProblemSetModel::saveToFile(const QString &fileName)
             problemObj["description"]=problem->description;
             if (fileExists(problem->answerProgram))
                 problemObj["answer_program"] = problem->answerProgram;
+            if (!problem->generatorProgram.isEmpty())
+                problemObj["generator_program"] = problem->generatorProgram;
+            if (!problem->bruteForceProgram.isEmpty())
+                problemObj["brute_force_program"] = problem->bruteForceProgram;
+            problemObj["time_limit"]=problem->timeLimit;
+            problemObj["memory_limit"]=problem->memoryLimit;
             QJsonArray cases;
             foreach (const POJProblemCase& problemCase, problem->cases) {
                 QJsonObject caseObj;
                 caseObj["name"]=problemCase->name;
-                caseObj["input"]=problemCase->input;
-                caseObj["expected"]=problemCase->expected;
+                if (!problemCase->inputFileName.isEmpty())
+                    caseObj["input_file"]=problemCase->inputFileName;
+                else
+                    caseObj["input"]=problemCase->input;
+                if (!problemCase->expectedOutputFileName.isEmpty())
+                    caseObj["expected_file"]=problemCase->expectedOutputFileName;
+                else
+                    caseObj["expected"]=problemCase->expected;
                 cases.append(caseObj);
             }
             problemObj["cases"]=cases;
@@ -153,6 +166,10 @@ void OJProblemSetModel::loadFromFile(const QString &fileName)
             problem->url = problemObj["url"].toString();
             problem->description = problemObj["description"].toString();
             problem->answerProgram = problemObj["answer_program"].toString();
+            problem->generatorProgram = problemObj["generator_program"].toString();
+            problem->bruteForceProgram = problemObj["brute_force_program"].toString();
+            problem->timeLimit = problemObj["time_limit"].toInt();
+            problem->memoryLimit = problemObj["memory_limit"].toInt();
             QJsonArray casesArray = problemObj["cases"].toArray();
             foreach (const QJsonValue& caseVal, casesArray) {
                 QJsonObject caseObj = caseVal.toObject();
@@ -160,6 +177,8 @@ void OJProblemSetModel::loadFromFile(const QString &fileName)
                 problemCase->name = caseObj["name"].toString();
                 problemCase->input = caseObj["input"].toString();
                 problemCase->expected = caseObj["expected"].toString();
+                problemCase->inputFileName = caseObj["input_file"].toString();
+                problemCase->expectedOutputFileName = caseObj["expected_file"].toString();
                 problemCase->testState = ProblemCaseTestState::NotTested;
                 problem->cases.append(problemCase);
             }
@@ -348,11 +367,50 @@ QVariant OJProblemModel::data(const QModelIndex &index, int role) const
         return QVariant();
     if (mProblem==nullptr)
         return QVariant();
-    if (role == Qt::DisplayRole || role == Qt::EditRole) {
-        return mProblem->cases[index.row()]->name;
+    POJProblemCase problemCase = mProblem->cases[index.row()];
+    if (role == Qt::DisplayRole) {
+        switch (problemCase->testState) {
+        case ProblemCaseTestState::Passed:
+        case ProblemCaseTestState::Failed:
+            return tr("%1 (%2 ms, %3)").arg(problemCase->name)
+                    .arg(problemCase->cpuTime)
+                    .arg(QLocale::system().formattedDataSize(problemCase->peakMemory*1024));
+        case ProblemCaseTestState::TimeLimitExceeded:
+            return tr("%1 (Time Limit Exceeded)").arg(problemCase->name);
+        case ProblemCaseTestState::MemoryLimitExceeded:
+            return tr("%1 (Memory Limit Exceeded)").arg(problemCase->name);
+        default:
+            return problemCase->name;
+        }
+    } else if (role == Qt::EditRole) {
+        return problemCase->name;
+    } else if (role == Qt::ToolTipRole) {
+        QStringList lines;
+        if (!problemCase->inputFileName.isEmpty())
+            lines.append(tr("Input file: %1").arg(problemCase->inputFileName));
+        if (!problemCase->expectedOutputFileName.isEmpty())
+            lines.append(tr("Expected output file: %1").arg(problemCase->expectedOutputFileName));
+        if (problemCase->testState != ProblemCaseTestState::NotTested
+                && problemCase->testState != ProblemCaseTestState::Testing) {
+            lines.append(tr("CPU time: %1 ms<br />Wall time: %2 ms<br />Peak memory: %3")
+                    .arg(problemCase->cpuTime)
+                    .arg(problemCase->runningTime)
+                    .arg(QLocale::system().formattedDataSize(problemCase->peakMemory*1024)));
+            if (problemCase->mismatchLine>0)
+                lines.append(tr("First mismatch at line %1, column %2")
+                        .arg(problemCase->mismatchLine)
+                        .arg(problemCase->mismatchColumn));
+            if (problemCase->outputTruncated)
+                lines.append(tr("Only the beginning of the output is shown."));
+        }
+        if (lines.isEmpty())
+            return QVariant();
+        return lines.join("<br />");
     } else if (role == Qt::DecorationRole) {
-        switch (mProblem->cases[index.row()]->testState) {
+        switch (problemCase->testState) {
         case ProblemCaseTestState::Failed:
+        case ProblemCaseTestState::TimeLimitExceeded:
+        case ProblemCaseTestState::MemoryLimitExceeded:
             return pIconsManager->getIcon(IconsManager::ACTION_PROBLEM_FALIED);
         case ProblemCaseTestState::Passed:
             return pIconsManager->getIcon(IconsManager::ACTION_PROBLEM_PASSED);
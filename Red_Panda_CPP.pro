@@ -5,6 +5,11 @@ SUBDIRS += \
     astyle \
     consolepauser
 
+# qmake CONFIG+=benchmarks
+CONFIG(benchmarks) {
+    SUBDIRS += benchmarks/gdbmiparser
+}
+
 APP_NAME = RedPandaCPP
 
 APP_VERSION = 0.14.2
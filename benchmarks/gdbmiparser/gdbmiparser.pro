@@ -0,0 +1,15 @@
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = gdbmiparser-benchmark
+
+INCLUDEPATH += ../../RedPandaIDE
+
+SOURCES += \
+    ../../RedPandaIDE/gdbmiresultparser.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../RedPandaIDE/gdbmiresultparser.h
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include "gdbmiresultparser.h"
+
+/*
+ * Times GDBMIResultParser over GDB/MI transcripts.
+ *
+ * Usage: gdbmiparser-benchmark [-n iterations] [transcript...]
+ * Each "^done,..." line of a transcript is parsed and all of its values are
+ * read. Without transcripts, replies like the ones of -data-read-memory-bytes,
+ * -var-list-children and -data-disassemble are generated.
+ */
+
+static int walk(const GDBMIResultParser::ParseValue& value);
+
+static int walk(const GDBMIResultParser::ParseObject& object, const QList<QByteArray>& names)
+{
+    int count = 0;
+    foreach (const QByteArray& name, names) {
+        count += walk(object[name]);
+    }
+    return count;
+}
+
+static int walk(const GDBMIResultParser::ParseValue& value)
+{
+    switch(value.type()) {
+    case GDBMIResultParser::ParseValueType::Value:
+        return value.value().length();
+    case GDBMIResultParser::ParseValueType::Array: {
+        int count = 0;
+        foreach (const GDBMIResultParser::ParseValue& item, value.array()) {
+            count += walk(item);
+        }
+        return count;
+    }
+    case GDBMIResultParser::ParseValueType::Object:
+        return walk(value.object(),
+                    {"name","exp","numchild","value","type","begin","contents",
+                     "address","func-name","offset","inst","children","child"});
+    default:
+        return 0;
+    }
+}
+
+static QList<QByteArray> generatedRecords()
+{
+    QList<QByteArray> records;
+    QByteArray memory = "memory=[{begin=\"0x7ffe0000\",offset=\"0x0\",end=\"0x7ffe1000\",contents=\"";
+    for (int i=0;i<4096;i++)
+        memory += QByteArray::number(i%256,16).rightJustified(2,'0');
+    memory += "\"}]";
+    records.append(memory);
+
+    QByteArray children = "numchild=\"1000\",children=[";
+    for (int i=0;i<1000;i++) {
+        if (i>0)
+            children += ",";
+        children += QString("child={name=\"var1.%1\",exp=\"%1\",numchild=\"0\",value=\"\\\"item %1\\\\n\\\"\",type=\"std::string\",thread-id=\"1\"}")
+                .arg(i).toUtf8();
+    }
+    children += "],has_more=\"0\"";
+    records.append(children);
+
+    QByteArray disassembly = "asm_insns=[";
+    for (int i=0;i<2000;i++) {
+        if (i>0)
+            disassembly += ",";
+        disassembly += QString("{address=\"0x%1\",func-name=\"main\",offset=\"%2\",inst=\"mov    %eax,-0x%3(%rbp)\"}")
+                .arg(0x401000+i*4,0,16).arg(i*4).arg(i%64,0,16).toUtf8();
+    }
+    disassembly += "]";
+    records.append(disassembly);
+    return records;
+}
+
+static QList<QByteArray> transcriptRecords(const QString& filename)
+{
+    QList<QByteArray> records;
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly))
+        return records;
+    foreach (QByteArray line, file.readAll().split('\n')) {
+        line = line.trimmed();
+        //skip the token before the result class
+        int pos = 0;
+        while (pos<line.length() && line[pos]>='0' && line[pos]<='9')
+            pos++;
+        if (!line.mid(pos).startsWith("^done,"))
+            continue;
+        records.append(line.mid(pos+6));
+    }
+    return records;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+    int iterations = 200;
+    if (args.count()>=2 && args[0]=="-n") {
+        iterations = std::max(1,args[1].toInt());
+        args = args.mid(2);
+    }
+    QList<QByteArray> records;
+    foreach (const QString& filename, args) {
+        records.append(transcriptRecords(filename));
+    }
+    if (args.isEmpty())
+        records = generatedRecords();
+
+    QTextStream out(stdout);
+    if (records.isEmpty()) {
+        out<<"No ^done records found."<<"\n";
+        return 1;
+    }
+    qint64 bytes = 0;
+    foreach (const QByteArray& record, records) {
+        bytes += record.length();
+    }
+    GDBMIResultParser parser;
+    GDBMIResultType type;
+    int checksum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i=0;i<iterations;i++) {
+        foreach (const QByteArray& record, records) {
+            GDBMIResultParser::ParseObject multiValues;
+            //any registered command will do, the type isn't used here
+            if (parser.parse(record, "-data-disassemble", type, multiValues))
+                checksum += walk(multiValues,
+                                 {"memory","children","asm_insns","numchild","has_more","value"});
+        }
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    double seconds = elapsed / 1e9;
+    out<<QString("%1 records, %2 bytes, %3 iterations").arg(records.count()).arg(bytes).arg(iterations)<<"\n";
+    out<<QString("%1 ms total, %2 us per pass, %3 MB/s")
+         .arg(elapsed/1e6,0,'f',1)
+         .arg(elapsed/1e3/iterations,0,'f',1)
+         .arg(bytes*(double)iterations/seconds/1024/1024,0,'f',1)<<"\n";
+    out<<"checksum "<<checksum<<"\n";
+    return 0;
+}